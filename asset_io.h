@@ -0,0 +1,141 @@
+/*
+  asset_io.h
+
+  Read-only file mappings for assets. The mapping is handed straight to
+  stbi_load_from_memory / stbtt_InitFont, so there is no read() copy on
+  the load path and fonts don't need a second in-memory copy for as long
+  as stb_truetype keeps pointing at the bytes.
+
+  Do this:
+
+     #define ASSET_IO_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header.
+
+  Usage:
+
+     asset_file font;
+     if (asset_map(&font, "./third_party/fonts/Hack-Regular.ttf")) {
+         stbtt_InitFont(&info, font.data, 0);
+         ...
+         asset_unmap(&font); // only once the font isn't used anymore
+     }
+
+  Define ASSET_IO_NO_MMAP to fall back to malloc + fread (platforms without
+  mmap), the API stays the same.
+*/
+
+#ifndef ASSET_IO_H
+#define ASSET_IO_H
+
+#include <stddef.h>
+
+typedef struct
+{
+    const unsigned char *data;
+    size_t size;
+} asset_file;
+
+// returns 0 on failure, f is zeroed in that case
+int asset_map(asset_file *f, const char *path);
+void asset_unmap(asset_file *f);
+
+#endif // ASSET_IO_H
+
+#ifdef ASSET_IO_IMPLEMENTATION
+
+#include <stdio.h>
+
+#ifdef ASSET_IO_NO_MMAP
+
+#include <stdlib.h>
+
+int
+asset_map(asset_file *f, const char *path)
+{
+    f->data = NULL;
+    f->size = 0;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        printf("Failed to open asset: %s\n", path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned char *data = malloc(size > 0 ? size : 1);
+    if (!data || fread(data, 1, size, file) != (size_t)size) {
+        printf("Failed to read asset: %s\n", path);
+        free(data);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+
+    f->data = data;
+    f->size = size;
+    return 1;
+}
+
+void
+asset_unmap(asset_file *f)
+{
+    free((void *)f->data);
+    f->data = NULL;
+    f->size = 0;
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int
+asset_map(asset_file *f, const char *path)
+{
+    f->data = NULL;
+    f->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Failed to open asset: %s\n", path);
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        printf("Failed to map asset: %s\n", path);
+        close(fd);
+        return 0;
+    }
+
+    // the mapping outlives the descriptor
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Failed to map asset: %s\n", path);
+        return 0;
+    }
+
+    f->data = data;
+    f->size = st.st_size;
+    return 1;
+}
+
+void
+asset_unmap(asset_file *f)
+{
+    if (f->data) {
+        munmap((void *)f->data, f->size);
+    }
+    f->data = NULL;
+    f->size = 0;
+}
+
+#endif // ASSET_IO_NO_MMAP
+
+#endif // ASSET_IO_IMPLEMENTATION
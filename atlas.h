@@ -0,0 +1,169 @@
+/*
+  atlas.h
+
+  Loads the UV lookup table written by atlas_packer so renderers can draw
+  every sprite and glyph out of one or a few texture pages instead of a
+  texture per sheet.
+
+  Do this:
+
+     #define ATLAS_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header.
+
+  Table format (text, one record per line, sprites sorted by name):
+
+     pages <count>
+     page <index> <file> <width> <height> <color|mask>
+     sprites <count>
+     sprite <name> <page> <x> <y> <w> <h> <u0> <v0> <u1> <v1>
+
+  Page files are relative to the table. u0/v0 is the top left corner of the
+  sprite in an image loaded without stbi_set_flip_vertically_on_load.
+*/
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#define ATLAS_MAX_PAGES 8
+#define ATLAS_NAME_LEN 48
+#define ATLAS_PATH_LEN 256
+
+typedef struct
+{
+    char name[ATLAS_NAME_LEN];
+    int page;
+    int x, y, w, h;
+    float u0, v0, u1, v1;
+} atlas_sprite;
+
+typedef struct
+{
+    char path[ATLAS_PATH_LEN];
+    int width;
+    int height;
+    int mask; // 1 channel coverage page, load with TEXTURE_USAGE_MASK
+} atlas_page;
+
+typedef struct
+{
+    int page_count;
+    atlas_page pages[ATLAS_MAX_PAGES];
+    int sprite_count;
+    atlas_sprite *sprites;
+} atlas;
+
+// returns 0 on failure, page paths are resolved relative to path
+int atlas_load(atlas *a, const char *path);
+void atlas_free(atlas *a);
+// binary search by name, NULL if the sprite is not in the table
+const atlas_sprite *atlas_find(const atlas *a, const char *name);
+
+#endif // ATLAS_H
+
+#ifdef ATLAS_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int
+atlas_load(atlas *a, const char *path)
+{
+    memset(a, 0, sizeof(*a));
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("Failed to open atlas: %s\n", path);
+        return 0;
+    }
+
+    // page files live next to the table
+    char dir[ATLAS_PATH_LEN] = "";
+    const char *slash = strrchr(path, '/');
+    if (slash && (size_t)(slash - path) + 1 >= sizeof(dir)) {
+        printf("Atlas path too long: %s\n", path);
+        fclose(file);
+        return 0;
+    }
+    if (slash) {
+        memcpy(dir, path, slash - path + 1);
+        dir[slash - path + 1] = 0;
+    }
+
+    int ok = 1;
+    if (fscanf(file, " pages %d", &a->page_count) != 1 ||
+        a->page_count < 0 || a->page_count > ATLAS_MAX_PAGES) {
+        ok = 0;
+    }
+
+    for (int i = 0; ok && i < a->page_count; i++) {
+        int index;
+        char file_name[128], kind[16];
+        if (fscanf(file, " page %d %127s %d %d %15s", &index, file_name,
+                   &a->pages[i].width, &a->pages[i].height, kind) != 5 || index != i) {
+            ok = 0;
+            break;
+        }
+        if (snprintf(a->pages[i].path, sizeof(a->pages[i].path), "%s%s", dir, file_name) >=
+            (int)sizeof(a->pages[i].path)) {
+            ok = 0;
+            break;
+        }
+        a->pages[i].mask = strcmp(kind, "mask") == 0;
+    }
+
+    if (ok && (fscanf(file, " sprites %d", &a->sprite_count) != 1 || a->sprite_count < 0)) {
+        ok = 0;
+    }
+
+    if (ok) {
+        a->sprites = calloc(a->sprite_count ? a->sprite_count : 1, sizeof(atlas_sprite));
+        ok = a->sprites != NULL;
+    }
+
+    for (int i = 0; ok && i < a->sprite_count; i++) {
+        atlas_sprite *s = &a->sprites[i];
+        if (fscanf(file, " sprite %47s %d %d %d %d %d %f %f %f %f", s->name, &s->page,
+                   &s->x, &s->y, &s->w, &s->h, &s->u0, &s->v0, &s->u1, &s->v1) != 10 ||
+            s->page < 0 || s->page >= a->page_count) {
+            ok = 0;
+        }
+    }
+
+    fclose(file);
+    if (!ok) {
+        printf("Malformed atlas: %s\n", path);
+        atlas_free(a);
+    }
+    return ok;
+}
+
+void
+atlas_free(atlas *a)
+{
+    free(a->sprites);
+    memset(a, 0, sizeof(*a));
+}
+
+const atlas_sprite *
+atlas_find(const atlas *a, const char *name)
+{
+    int lo = 0;
+    int hi = a->sprite_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(name, a->sprites[mid].name);
+        if (cmp == 0) {
+            return &a->sprites[mid];
+        }
+        if (cmp < 0) {
+            hi = mid - 1;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+#endif // ATLAS_IMPLEMENTATION
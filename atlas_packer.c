@@ -0,0 +1,334 @@
+// Offline sprite sheet packer.
+//
+// Slices the sheets listed in `sheets` into named cells and packs them with
+// a skyline packer into as few pages as possible, one set of pages for
+// colour sprites and one for single channel glyph masks. Each sprite is
+// surrounded by `padding` pixels copied from its own edge so linear
+// filtering and lower mips never pull in a neighbour.
+//
+// usage: ./atlas_packer [out_dir] [page_size] [padding]
+// writes <out_dir>/atlas_<n>.png and <out_dir>/atlas.txt (see atlas.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#include "atlas.h"
+
+typedef struct {
+    const char *path;
+    const char *name;
+    int cell_w;
+    int cell_h;
+    int mask; // white glyphs on transparent, stored as alpha only
+} Sheet;
+
+Sheet sheets[] = {
+    {"./third_party/images/roguelikecreatures.png", "roguelikecreatures", 16, 16, 0},
+    {"./third_party/fonts/charmap_w_alpha.png",    "charmap",            7,  9,  0},
+    {"./third_party/fonts/mbf_big_00.png",         "mbf_big_00",         16, 16, 0},
+    {"./third_party/fonts/mbf_big_04.png",         "mbf_big_04",         16, 16, 0},
+    {"./third_party/fonts/square_6x6.png",         "square_6x6",         6,  6,  1},
+    {"./third_party/fonts/minogram_6x10.png",      "minogram_6x10",      6,  10, 1},
+};
+
+typedef struct {
+    char name[ATLAS_NAME_LEN];
+    int sheet;
+    int src_x, src_y;
+    int w, h;
+    int mask;
+    int page;
+    int x, y; // top left of the sprite inside its page, padding excluded
+} Rect;
+
+typedef struct {
+    int x, y, width;
+} SkylineNode;
+
+typedef struct {
+    int mask;
+    SkylineNode *nodes;
+    int node_count;
+    unsigned char *pixels;
+} Page;
+
+int page_size = 512;
+int padding = 2;
+
+// lowest y a w wide rect can sit at when its left edge is on node i, -1 if it doesn't fit
+int skyline_fit(Page *page, int i, int w, int h)
+{
+    int x = page->nodes[i].x;
+    if (x + w > page_size) {
+        return -1;
+    }
+    int y = 0;
+    int remaining = w;
+    while (remaining > 0) {
+        if (page->nodes[i].y > y) {
+            y = page->nodes[i].y;
+        }
+        if (y + h > page_size) {
+            return -1;
+        }
+        remaining -= page->nodes[i].width;
+        i++;
+    }
+    return y;
+}
+
+int skyline_insert(Page *page, int w, int h, int *out_x, int *out_y)
+{
+    int best = -1, best_y = page_size, best_width = page_size;
+    for (int i = 0; i < page->node_count; i++) {
+        int y = skyline_fit(page, i, w, h);
+        if (y < 0) {
+            continue;
+        }
+        if (y < best_y || (y == best_y && page->nodes[i].width < best_width)) {
+            best = i;
+            best_y = y;
+            best_width = page->nodes[i].width;
+        }
+    }
+    if (best < 0) {
+        return 0;
+    }
+
+    int x = page->nodes[best].x;
+
+    // new node covering the rect, then trim whatever it shadows
+    memmove(&page->nodes[best + 1], &page->nodes[best], (page->node_count - best) * sizeof(SkylineNode));
+    page->nodes[best] = (SkylineNode){x, best_y + h, w};
+    page->node_count++;
+
+    for (int i = best + 1; i < page->node_count; i++) {
+        SkylineNode *prev = &page->nodes[i - 1];
+        SkylineNode *node = &page->nodes[i];
+        int shrink = prev->x + prev->width - node->x;
+        if (shrink <= 0) {
+            break;
+        }
+        node->x += shrink;
+        node->width -= shrink;
+        if (node->width > 0) {
+            break;
+        }
+        memmove(node, node + 1, (page->node_count - i - 1) * sizeof(SkylineNode));
+        page->node_count--;
+        i--;
+    }
+
+    // merge neighbours at the same height
+    for (int i = 0; i + 1 < page->node_count; i++) {
+        if (page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            memmove(&page->nodes[i + 1], &page->nodes[i + 2], (page->node_count - i - 2) * sizeof(SkylineNode));
+            page->node_count--;
+            i--;
+        }
+    }
+
+    *out_x = x;
+    *out_y = best_y;
+    return 1;
+}
+
+int cell_is_empty(unsigned char *data, int stride, int x0, int y0, int w, int h)
+{
+    for (int y = y0; y < y0 + h; y++) {
+        for (int x = x0; x < x0 + w; x++) {
+            if (data[(y*stride + x)*4 + 3]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int compare_height(const void *a, const void *b)
+{
+    const Rect *ra = a, *rb = b;
+    if (ra->h != rb->h) {
+        return rb->h - ra->h;
+    }
+    return rb->w - ra->w;
+}
+
+int compare_name(const void *a, const void *b)
+{
+    return strcmp(((const Rect *)a)->name, ((const Rect *)b)->name);
+}
+
+int clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_dir = argc > 1 ? argv[1] : "./third_party/atlas";
+    if (argc > 2) {
+        page_size = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        padding = atoi(argv[3]);
+    }
+
+    int sheet_count = sizeof(sheets) / sizeof(sheets[0]);
+    unsigned char *sheet_data[sizeof(sheets) / sizeof(sheets[0])];
+    int sheet_w[sizeof(sheets) / sizeof(sheets[0])];
+
+    // slice
+    int rect_count = 0, rect_cap = 1024;
+    Rect *rects = malloc(rect_cap * sizeof(Rect));
+    for (int s = 0; s < sheet_count; s++) {
+        int w, h, n;
+        asset_file file;
+        sheet_data[s] = NULL;
+        if (asset_map(&file, sheets[s].path)) {
+            sheet_data[s] = stbi_load_from_memory(file.data, (int)file.size, &w, &h, &n, 4);
+            asset_unmap(&file);
+        }
+        if (!sheet_data[s]) {
+            printf("Failed to load sheet: %s\n", sheets[s].path);
+            return -1;
+        }
+        sheet_w[s] = w;
+
+        for (int cy = 0; cy + sheets[s].cell_h <= h; cy += sheets[s].cell_h) {
+            for (int cx = 0; cx + sheets[s].cell_w <= w; cx += sheets[s].cell_w) {
+                if (cell_is_empty(sheet_data[s], w, cx, cy, sheets[s].cell_w, sheets[s].cell_h)) {
+                    continue;
+                }
+                if (rect_count == rect_cap) {
+                    rect_cap *= 2;
+                    rects = realloc(rects, rect_cap * sizeof(Rect));
+                }
+                Rect *r = &rects[rect_count++];
+                snprintf(r->name, sizeof(r->name), "%s/%d_%d", sheets[s].name,
+                         cx / sheets[s].cell_w, cy / sheets[s].cell_h);
+                r->sheet = s;
+                r->src_x = cx;
+                r->src_y = cy;
+                r->w = sheets[s].cell_w;
+                r->h = sheets[s].cell_h;
+                r->mask = sheets[s].mask;
+            }
+        }
+    }
+
+    // pack, tallest first
+    qsort(rects, rect_count, sizeof(Rect), compare_height);
+
+    Page pages[ATLAS_MAX_PAGES];
+    int page_count = 0;
+    for (int i = 0; i < rect_count; i++) {
+        Rect *r = &rects[i];
+        int pw = r->w + 2*padding, ph = r->h + 2*padding;
+        if (pw > page_size || ph > page_size) {
+            printf("Sprite %s does not fit a %d page\n", r->name, page_size);
+            return -1;
+        }
+
+        int placed = 0, x, y;
+        for (int p = 0; p < page_count && !placed; p++) {
+            if (pages[p].mask == r->mask && skyline_insert(&pages[p], pw, ph, &x, &y)) {
+                r->page = p;
+                placed = 1;
+            }
+        }
+        if (!placed) {
+            if (page_count == ATLAS_MAX_PAGES) {
+                printf("Out of atlas pages, try a bigger page size\n");
+                return -1;
+            }
+            Page *page = &pages[page_count];
+            page->mask = r->mask;
+            page->nodes = malloc((page_size + 1) * sizeof(SkylineNode));
+            page->nodes[0] = (SkylineNode){0, 0, page_size};
+            page->node_count = 1;
+            page->pixels = calloc(page_size * page_size, page->mask ? 1 : 4);
+            skyline_insert(page, pw, ph, &x, &y);
+            r->page = page_count++;
+        }
+        r->x = x + padding;
+        r->y = y + padding;
+    }
+
+    // blit with edge extrusion into the padding
+    for (int i = 0; i < rect_count; i++) {
+        Rect *r = &rects[i];
+        Page *page = &pages[r->page];
+        unsigned char *src = sheet_data[r->sheet];
+        int stride = sheet_w[r->sheet];
+        for (int y = -padding; y < r->h + padding; y++) {
+            for (int x = -padding; x < r->w + padding; x++) {
+                int sx = r->src_x + clamp(x, 0, r->w - 1);
+                int sy = r->src_y + clamp(y, 0, r->h - 1);
+                unsigned char *texel = &src[(sy*stride + sx)*4];
+                int dst = (r->y + y)*page_size + (r->x + x);
+                if (page->mask) {
+                    page->pixels[dst] = texel[3];
+                } else {
+                    memcpy(&page->pixels[dst*4], texel, 4);
+                }
+            }
+        }
+    }
+
+    char path[ATLAS_PATH_LEN];
+    for (int p = 0; p < page_count; p++) {
+        snprintf(path, sizeof(path), "%s/atlas_%d.png", out_dir, p);
+        int comp = pages[p].mask ? 1 : 4;
+        if (!stbi_write_png(path, page_size, page_size, comp, pages[p].pixels, page_size*comp)) {
+            printf("Failed to write %s\n", path);
+            return -1;
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/atlas.txt", out_dir);
+    FILE *table = fopen(path, "w");
+    if (!table) {
+        printf("Failed to write %s\n", path);
+        return -1;
+    }
+    fprintf(table, "pages %d\n", page_count);
+    for (int p = 0; p < page_count; p++) {
+        fprintf(table, "page %d atlas_%d.png %d %d %s\n", p, p, page_size, page_size,
+                pages[p].mask ? "mask" : "color");
+    }
+    qsort(rects, rect_count, sizeof(Rect), compare_name);
+    fprintf(table, "sprites %d\n", rect_count);
+    for (int i = 0; i < rect_count; i++) {
+        Rect *r = &rects[i];
+        fprintf(table, "sprite %s %d %d %d %d %d %.8f %.8f %.8f %.8f\n", r->name, r->page,
+                r->x, r->y, r->w, r->h,
+                (float)r->x / page_size, (float)r->y / page_size,
+                (float)(r->x + r->w) / page_size, (float)(r->y + r->h) / page_size);
+    }
+    fclose(table);
+
+    printf("packed %d sprites from %d sheets into %d page(s) of %dx%d\n",
+           rect_count, sheet_count, page_count, page_size, page_size);
+
+    for (int p = 0; p < page_count; p++) {
+        free(pages[p].nodes);
+        free(pages[p].pixels);
+    }
+    for (int s = 0; s < sheet_count; s++) {
+        stbi_image_free(sheet_data[s]);
+    }
+    free(rects);
+    return 0;
+}
@@ -6,3 +6,36 @@ C_FILES="instanced_quads.c glad.c"
 
 gcc -std=c99 -Werror -Wall -Wextra -Wno-unused-parameter $C_FILES -g -lX11 -pthread -lm -ldl -lpthread -lrt -lOpenGL -lglfw -o exe
 
+
+# offline tools, run from the repo root
+# gcc -std=c99 -Werror -Wall -Wextra -Wno-unused-parameter atlas_packer.c -g -lm -o atlas_packer && ./atlas_packer
+# OBJ to mesh cache, streaming under a memory ceiling (-m megabytes), for files too big for mesh_load_obj to bake
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter mesh_convert.c -lm -o mesh_convert && ./mesh_convert -m 256 ./third_party/assets/Tree.obj
+
+# headless texture load benchmark, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter texture_bench.c glad.c -lEGL -lm -ldl -o texture_bench && LIBGL_ALWAYS_SOFTWARE=1 ./texture_bench 50 stb
+
+# handmade_math.h benchmarks, add -mavx2 -mfma for the 8 wide paths
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter math_bench.c -lm -o math_bench && ./math_bench
+
+# handmade_math.h per function ns/op, one JSON document per configuration (SSE on/off x inlining on/off)
+# for flags in "" "-DHANDMADE_MATH_NO_SSE" "-DHANDMADE_MATH_NO_INLINE -fno-inline" "-DHANDMADE_MATH_NO_SSE -DHANDMADE_MATH_NO_INLINE -fno-inline"; do gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter $flags math_microbench.c -lm -o math_microbench && ./math_microbench || break; done
+
+# OBJ loader throughput on Tree.obj and a ~100 MB replicated copy, single and multi threaded, plus the mesh.h cache, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter obj_bench.c -pthread -lm -o obj_bench && ./obj_bench ./third_party/assets/Tree.obj 100
+
+# Vertex cache, overdraw and vertex fetch reordering (mesh_opt.h) on Tree.obj and a shuffled sphere clump, ACMR/ATVR/overdraw per pass
+# and the share of triangles meshlet culling (cull_cones) drops from a ring of cameras, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter mesh_opt_bench.c -pthread -lm -o mesh_opt_bench && ./mesh_opt_bench
+
+# LOD chain (mesh_opt_simplify) on a field of instanced copies, full detail vs mesh_lod_select at 1 pixel of error, headless, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter lod_bench.c glad.c -pthread -lEGL -lm -ldl -o lod_bench && LIBGL_ALWAYS_SOFTWARE=1 ./lod_bench ./third_party/assets/Tree.obj 48 10
+
+# Tree.obj's 6 usemtl runs drawn per run, per material (obj_group_by_material) and in one draw from the mesh.h material table, headless, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter material_bench.c glad.c -pthread -lEGL -lm -ldl -o material_bench && LIBGL_ALWAYS_SOFTWARE=1 ./material_bench ./third_party/assets/Tree.obj 32 10
+
+# forest stress scene: N Tree.obj copies on a terrain, scripted camera, cull_spheres + LOD + instanced draws, frame time / visible / triangles per N, headless, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter forest_bench.c glad.c -pthread -lEGL -lm -ldl -o forest_bench && LIBGL_ALWAYS_SOFTWARE=1 ./forest_bench 60 1000 10000 100000 1000000
+
+# MESH_QUANTIZE: float vs quantized (16 bit positions/uvs, octahedral normals) bake of each mesh, bytes saved, max position/normal/uv error, frame time and pixels changed, headless, JSON on stdout
+# gcc -std=c99 -O2 -Werror -Wall -Wextra -Wno-unused-parameter quantize_bench.c glad.c -pthread -lEGL -lm -ldl -o quantize_bench && LIBGL_ALWAYS_SOFTWARE=1 ./quantize_bench 48 10 ./third_party/assets/Tree.obj
@@ -0,0 +1,357 @@
+/*
+  cull.h
+
+  View frustum culling for bounding spheres and axis aligned boxes. The six
+  planes come straight out of projection * view (HMM_Perspective and
+  HMM_LookAt, so OpenGL clip space with -w <= z <= w), the bounds are
+  tested in SoA layout 8 at a time with AVX, 4 with SSE, and the indices of
+  everything that survives are written out compacted, ready to drive draw
+  calls or fill an instance buffer.
+
+  Do this:
+
+     #define CULL_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header, AFTER handmade_math.h
+  (the SIMD paths follow its HANDMADE_MATH__USE_SSE / _AVX detection).
+
+  Usage:
+
+     cull_frustum frustum = cull_frustum_from_matrix(HMM_MultiplyMat4(projection, view));
+     int visible_count = cull_spheres(&frustum, x, y, z, radius, count, visible);
+     for (int i = 0; i < visible_count; i++) draw(visible[i]);
+
+  The tests are conservative: something that straddles two planes outside
+  a corner of the frustum can be kept, nothing visible is ever dropped.
+
+  cull_cones does the sphere test plus a back facing one for meshlets
+  (mesh_opt.h), whose normals all lie in a cone: a meshlet goes when every
+  triangle in it faces away from the camera. Give it the frustum of
+  projection * view * model and the camera position in model space, the
+  bounds are in model space too.
+*/
+
+#ifndef CULL_H
+#define CULL_H
+
+// plane i is x[i]*X + y[i]*Y + z[i]*Z + d[i] >= 0 on the inside, normals are unit length
+// order: left, right, bottom, top, near, far
+typedef struct
+{
+    float x[6], y[6], z[6], d[6];
+} cull_frustum;
+
+cull_frustum cull_frustum_from_matrix(hmm_mat4 projection_view);
+
+// visible must have room for count indices, returns how many were written
+int cull_spheres(const cull_frustum *frustum, const float *x, const float *y, const float *z,
+                 const float *radius, int count, int *visible);
+// boxes as center and half extents
+int cull_aabbs(const cull_frustum *frustum, const float *cx, const float *cy, const float *cz,
+               const float *ex, const float *ey, const float *ez, int count, int *visible);
+// spheres that also carry a normal cone, cutoff is the sine of its half angle (1 never faces away)
+int cull_cones(const cull_frustum *frustum, hmm_vec3 camera, const float *x, const float *y, const float *z,
+               const float *radius, const float *axis_x, const float *axis_y, const float *axis_z,
+               const float *cutoff, int count, int *visible);
+
+#endif // CULL_H
+
+#ifdef CULL_IMPLEMENTATION
+
+cull_frustum
+cull_frustum_from_matrix(hmm_mat4 m)
+{
+    // Gribb/Hartmann: the planes are row 3 -/+ rows 0, 1, 2 of the clip matrix
+    // (Elements is [column][row])
+    cull_frustum f;
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        float a = m.Elements[0][3] + sign * m.Elements[0][row];
+        float b = m.Elements[1][3] + sign * m.Elements[1][row];
+        float c = m.Elements[2][3] + sign * m.Elements[2][row];
+        float d = m.Elements[3][3] + sign * m.Elements[3][row];
+        float inv_length = 1.0f / HMM_SquareRootF(a*a + b*b + c*c);
+        f.x[i] = a * inv_length;
+        f.y[i] = b * inv_length;
+        f.z[i] = c * inv_length;
+        f.d[i] = d * inv_length;
+    }
+    return f;
+}
+
+#ifdef HANDMADE_MATH__USE_SSE
+// the indices of the set lanes of mask: a full group is written in one run, otherwise one index per
+// set bit, lowest first
+static int
+cull_compact(int *visible, int count, int base, int mask, int lanes)
+{
+    if (mask == (1 << lanes) - 1) {
+        for (int lane = 0; lane < lanes; lane++) {
+            visible[count + lane] = base + lane;
+        }
+        return count + lanes;
+    }
+    // most groups are either all in or all out, an empty mask never enters the loop
+    while (mask) {
+        int lane = 0;
+        while (!((mask >> lane) & 1)) {
+            lane++;
+        }
+        visible[count++] = base + lane;
+        mask &= mask - 1;
+    }
+    return count;
+}
+#endif
+
+int
+cull_spheres(const cull_frustum *f, const float *x, const float *y, const float *z,
+             const float *radius, int count, int *visible)
+{
+    int visible_count = 0;
+    int i = 0;
+
+#ifdef HANDMADE_MATH__USE_AVX
+    __m256 plane_x[6], plane_y[6], plane_z[6], plane_d[6];
+    for (int p = 0; p < 6; p++) {
+        plane_x[p] = _mm256_set1_ps(f->x[p]);
+        plane_y[p] = _mm256_set1_ps(f->y[p]);
+        plane_z[p] = _mm256_set1_ps(f->z[p]);
+        plane_d[p] = _mm256_set1_ps(f->d[p]);
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, plane_x[p]), _mm256_mul_ps(py, plane_y[p])),
+                                        _mm256_add_ps(_mm256_mul_ps(pz, plane_z[p]), plane_d[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, neg_r, _CMP_GE_OQ));
+        }
+        visible_count = cull_compact(visible, visible_count, i, _mm256_movemask_ps(inside), 8);
+    }
+#endif
+
+#ifdef HANDMADE_MATH__USE_SSE
+    __m128 plane4_x[6], plane4_y[6], plane4_z[6], plane4_d[6];
+    for (int p = 0; p < 6; p++) {
+        plane4_x[p] = _mm_set1_ps(f->x[p]);
+        plane4_y[p] = _mm_set1_ps(f->y[p]);
+        plane4_z[p] = _mm_set1_ps(f->z[p]);
+        plane4_d[p] = _mm_set1_ps(f->d[p]);
+    }
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        int mask = 0xf;
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, plane4_x[p]), _mm_mul_ps(py, plane4_y[p])),
+                                     _mm_add_ps(_mm_mul_ps(pz, plane4_z[p]), plane4_d[p]));
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(dist, neg_r));
+        }
+        visible_count = cull_compact(visible, visible_count, i, mask, 4);
+    }
+#endif
+
+    for (; i < count; i++) {
+        int inside = 1;
+        for (int p = 0; p < 6; p++) {
+            // same association as the SIMD paths so every path keeps the same set
+            float dist = (x[i]*f->x[p] + y[i]*f->y[p]) + (z[i]*f->z[p] + f->d[p]);
+            inside &= dist >= -radius[i];
+        }
+        visible[visible_count] = i;
+        visible_count += inside;
+    }
+
+    return visible_count;
+}
+
+int
+cull_aabbs(const cull_frustum *f, const float *cx, const float *cy, const float *cz,
+           const float *ex, const float *ey, const float *ez, int count, int *visible)
+{
+    // a box is outside a plane when its center is further out than its projected radius,
+    // |n.x|*ex + |n.y|*ey + |n.z|*ez
+    float ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; p++) {
+        ax[p] = HMM_ABS(f->x[p]);
+        ay[p] = HMM_ABS(f->y[p]);
+        az[p] = HMM_ABS(f->z[p]);
+    }
+
+    int visible_count = 0;
+    int i = 0;
+
+#ifdef HANDMADE_MATH__USE_AVX
+    __m256 plane_x[6], plane_y[6], plane_z[6], plane_d[6], abs_x[6], abs_y[6], abs_z[6];
+    for (int p = 0; p < 6; p++) {
+        plane_x[p] = _mm256_set1_ps(f->x[p]);
+        plane_y[p] = _mm256_set1_ps(f->y[p]);
+        plane_z[p] = _mm256_set1_ps(f->z[p]);
+        plane_d[p] = _mm256_set1_ps(f->d[p]);
+        abs_x[p] = _mm256_set1_ps(ax[p]);
+        abs_y[p] = _mm256_set1_ps(ay[p]);
+        abs_z[p] = _mm256_set1_ps(az[p]);
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(cx + i), py = _mm256_loadu_ps(cy + i), pz = _mm256_loadu_ps(cz + i);
+        __m256 hx = _mm256_loadu_ps(ex + i), hy = _mm256_loadu_ps(ey + i), hz = _mm256_loadu_ps(ez + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, plane_x[p]), _mm256_mul_ps(py, plane_y[p])),
+                                        _mm256_add_ps(_mm256_mul_ps(pz, plane_z[p]), plane_d[p]));
+            __m256 extent = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, abs_x[p]), _mm256_mul_ps(hy, abs_y[p])),
+                                          _mm256_mul_ps(hz, abs_z[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, extent), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        visible_count = cull_compact(visible, visible_count, i, _mm256_movemask_ps(inside), 8);
+    }
+#endif
+
+#ifdef HANDMADE_MATH__USE_SSE
+    __m128 plane4_x[6], plane4_y[6], plane4_z[6], plane4_d[6], abs4_x[6], abs4_y[6], abs4_z[6];
+    for (int p = 0; p < 6; p++) {
+        plane4_x[p] = _mm_set1_ps(f->x[p]);
+        plane4_y[p] = _mm_set1_ps(f->y[p]);
+        plane4_z[p] = _mm_set1_ps(f->z[p]);
+        plane4_d[p] = _mm_set1_ps(f->d[p]);
+        abs4_x[p] = _mm_set1_ps(ax[p]);
+        abs4_y[p] = _mm_set1_ps(ay[p]);
+        abs4_z[p] = _mm_set1_ps(az[p]);
+    }
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(cx + i), py = _mm_loadu_ps(cy + i), pz = _mm_loadu_ps(cz + i);
+        __m128 hx = _mm_loadu_ps(ex + i), hy = _mm_loadu_ps(ey + i), hz = _mm_loadu_ps(ez + i);
+        int mask = 0xf;
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, plane4_x[p]), _mm_mul_ps(py, plane4_y[p])),
+                                     _mm_add_ps(_mm_mul_ps(pz, plane4_z[p]), plane4_d[p]));
+            __m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, abs4_x[p]), _mm_mul_ps(hy, abs4_y[p])),
+                                       _mm_mul_ps(hz, abs4_z[p]));
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(dist, extent), _mm_setzero_ps()));
+        }
+        visible_count = cull_compact(visible, visible_count, i, mask, 4);
+    }
+#endif
+
+    for (; i < count; i++) {
+        int inside = 1;
+        for (int p = 0; p < 6; p++) {
+            float dist = (cx[i]*f->x[p] + cy[i]*f->y[p]) + (cz[i]*f->z[p] + f->d[p]);
+            float extent = (ex[i]*ax[p] + ey[i]*ay[p]) + ez[i]*az[p];
+            inside &= dist + extent >= 0.0f;
+        }
+        visible[visible_count] = i;
+        visible_count += inside;
+    }
+
+    return visible_count;
+}
+
+int
+cull_cones(const cull_frustum *f, hmm_vec3 camera, const float *x, const float *y, const float *z,
+           const float *radius, const float *axis_x, const float *axis_y, const float *axis_z,
+           const float *cutoff, int count, int *visible)
+{
+    // every point p of the sphere sees the triangles from behind when the direction from the
+    // camera to p is within 90 - half angle of the axis. With d = center - camera that holds for
+    // the whole sphere once dot(d, axis) >= cutoff * |d| + radius * (1 + cutoff)
+    int visible_count = 0;
+    int i = 0;
+
+#ifdef HANDMADE_MATH__USE_AVX
+    __m256 plane_x[6], plane_y[6], plane_z[6], plane_d[6];
+    for (int p = 0; p < 6; p++) {
+        plane_x[p] = _mm256_set1_ps(f->x[p]);
+        plane_y[p] = _mm256_set1_ps(f->y[p]);
+        plane_z[p] = _mm256_set1_ps(f->z[p]);
+        plane_d[p] = _mm256_set1_ps(f->d[p]);
+    }
+    __m256 camera_x = _mm256_set1_ps(camera.X), camera_y = _mm256_set1_ps(camera.Y), camera_z = _mm256_set1_ps(camera.Z);
+    __m256 one = _mm256_set1_ps(1.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), r);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, plane_x[p]), _mm256_mul_ps(py, plane_y[p])),
+                                        _mm256_add_ps(_mm256_mul_ps(pz, plane_z[p]), plane_d[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, neg_r, _CMP_GE_OQ));
+        }
+        __m256 dx = _mm256_sub_ps(px, camera_x), dy = _mm256_sub_ps(py, camera_y), dz = _mm256_sub_ps(pz, camera_z);
+        __m256 c = _mm256_loadu_ps(cutoff + i);
+        __m256 along = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, _mm256_loadu_ps(axis_x + i)),
+                                                   _mm256_mul_ps(dy, _mm256_loadu_ps(axis_y + i))),
+                                     _mm256_mul_ps(dz, _mm256_loadu_ps(axis_z + i)));
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                                                     _mm256_mul_ps(dz, dz)));
+        __m256 limit = _mm256_add_ps(_mm256_mul_ps(c, length), _mm256_mul_ps(r, _mm256_add_ps(one, c)));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(along, limit, _CMP_LT_OQ));
+        visible_count = cull_compact(visible, visible_count, i, _mm256_movemask_ps(inside), 8);
+    }
+#endif
+
+#ifdef HANDMADE_MATH__USE_SSE
+    __m128 plane4_x[6], plane4_y[6], plane4_z[6], plane4_d[6];
+    for (int p = 0; p < 6; p++) {
+        plane4_x[p] = _mm_set1_ps(f->x[p]);
+        plane4_y[p] = _mm_set1_ps(f->y[p]);
+        plane4_z[p] = _mm_set1_ps(f->z[p]);
+        plane4_d[p] = _mm_set1_ps(f->d[p]);
+    }
+    __m128 camera4_x = _mm_set1_ps(camera.X), camera4_y = _mm_set1_ps(camera.Y), camera4_z = _mm_set1_ps(camera.Z);
+    __m128 one4 = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+        int mask = 0xf;
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, plane4_x[p]), _mm_mul_ps(py, plane4_y[p])),
+                                     _mm_add_ps(_mm_mul_ps(pz, plane4_z[p]), plane4_d[p]));
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(dist, neg_r));
+        }
+        __m128 dx = _mm_sub_ps(px, camera4_x);
+        __m128 dy = _mm_sub_ps(py, camera4_y);
+        __m128 dz = _mm_sub_ps(pz, camera4_z);
+        __m128 c = _mm_loadu_ps(cutoff + i);
+        __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(axis_x + i)),
+                                             _mm_mul_ps(dy, _mm_loadu_ps(axis_y + i))),
+                                  _mm_mul_ps(dz, _mm_loadu_ps(axis_z + i)));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                               _mm_mul_ps(dz, dz)));
+        __m128 limit = _mm_add_ps(_mm_mul_ps(c, length), _mm_mul_ps(r, _mm_add_ps(one4, c)));
+        mask &= _mm_movemask_ps(_mm_cmplt_ps(along, limit));
+        visible_count = cull_compact(visible, visible_count, i, mask, 4);
+    }
+#endif
+
+    for (; i < count; i++) {
+        int inside = 1;
+        for (int p = 0; p < 6; p++) {
+            float dist = (x[i]*f->x[p] + y[i]*f->y[p]) + (z[i]*f->z[p] + f->d[p]);
+            inside &= dist >= -radius[i];
+        }
+        float dx = x[i] - camera.X, dy = y[i] - camera.Y, dz = z[i] - camera.Z;
+        float along = (dx*axis_x[i] + dy*axis_y[i]) + dz*axis_z[i];
+        float length = HMM_SquareRootF((dx*dx + dy*dy) + dz*dz);
+        inside &= along < cutoff[i]*length + radius[i]*(1.0f + cutoff[i]);
+        visible[visible_count] = i;
+        visible_count += inside;
+    }
+
+    return visible_count;
+}
+
+#endif // CULL_IMPLEMENTATION
@@ -0,0 +1,444 @@
+// Forest stress scene.
+//
+// Scatters N copies of a mesh (default Tree.obj) over a rolling terrain, one
+// per grid cell with a random offset, turn and size, so the forest grows with
+// N at a fixed density, then flies a scripted camera loop low over it. Every
+// frame goes through the instanced path: cull_spheres over the copies'
+// bounding spheres, mesh_lod_select on the survivors (1 pixel of error),
+// and one instanced draw per level of detail that reads its materials from
+// the mesh.h table. Things fade into fog at a fixed view distance, so what's
+// drawn levels off while culling keeps growing with N. Prints frame times
+// and the visible copies and triangles per frame for every N as JSON. Runs
+// headless (EGL surfaceless), LIBGL_ALWAYS_SOFTWARE=1 pins it to llvmpipe.
+//
+// usage: ./forest_bench [frames] [N ...]     default 60 frames of 1000 10000 100000
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "glad.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define CULL_IMPLEMENTATION
+#include "cull.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+#define HEADLESS_IMPLEMENTATION
+#include "headless.h"
+
+#define WIDTH 1280
+#define HEIGHT 720
+#define FOV 45.0f
+#define MAX_PIXEL_ERROR 1.0f
+#define VIEW_DISTANCE 100.0f // in tree radii, the far plane, fog ends there
+#define TERRAIN_CELLS 128
+
+const char *tree_vs = "#version 450 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec3 aNormal;\n"
+    "layout (location = 3) in uint aMaterial;\n"
+    "// per instance hmm_mat3x4, the rows of the model matrix without (0, 0, 0, 1)\n"
+    "layout (location = 4) in vec4 aModel0;\n"
+    "layout (location = 5) in vec4 aModel1;\n"
+    "layout (location = 6) in vec4 aModel2;\n"
+    "\n"
+    "out vec3 Normal;\n"
+    "out float Distance;\n"
+    "flat out uint MaterialIndex;\n"
+    "\n"
+    "uniform mat4 projection_view;\n"
+    "uniform vec3 camera;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    mat4 model = transpose(mat4(aModel0, aModel1, aModel2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));\n"
+    "    vec4 world = model*vec4(aPos, 1.0f);\n"
+    "    gl_Position = projection_view*world;\n"
+    "    Normal = mat3(model)*aNormal;\n"
+    "    Distance = distance(world.xyz, camera);\n"
+    "    MaterialIndex = aMaterial;\n"
+    "}";
+
+const char *tree_fs = "#version 450 core\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "in vec3 Normal;\n"
+    "in float Distance;\n"
+    "flat in uint MaterialIndex;\n"
+    "\n"
+    "struct Material { vec4 diffuse; vec4 specular; vec4 emissive; ivec4 maps; };\n"
+    "layout (std430, binding = 0) readonly buffer Materials { Material materials[]; };\n"
+    "\n"
+    "uniform float fog_end;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    float light = max(dot(normalize(Normal), normalize(vec3(0.4f, 1.0f, 0.3f))), 0.0f);\n"
+    "    vec3 color = materials[MaterialIndex].diffuse.rgb*(0.3f + 0.7f*light);\n"
+    "    float fog = clamp(Distance/fog_end, 0.0f, 1.0f);\n"
+    "    FragColor = vec4(mix(color, vec3(0.6f, 0.7f, 0.8f), fog*fog), 1.0f);\n"
+    "}";
+
+const char *terrain_vs = "#version 450 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec3 aNormal;\n"
+    "\n"
+    "out vec3 Normal;\n"
+    "out float Distance;\n"
+    "\n"
+    "uniform mat4 projection_view;\n"
+    "uniform vec3 camera;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = projection_view*vec4(aPos, 1.0f);\n"
+    "    Normal = aNormal;\n"
+    "    Distance = distance(aPos, camera);\n"
+    "}";
+
+const char *terrain_fs = "#version 450 core\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "in vec3 Normal;\n"
+    "in float Distance;\n"
+    "\n"
+    "uniform float fog_end;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    float light = max(dot(normalize(Normal), normalize(vec3(0.4f, 1.0f, 0.3f))), 0.0f);\n"
+    "    vec3 color = vec3(0.35f, 0.3f, 0.2f)*(0.3f + 0.7f*light);\n"
+    "    float fog = clamp(Distance/fog_end, 0.0f, 1.0f);\n"
+    "    FragColor = vec4(mix(color, vec3(0.6f, 0.7f, 0.8f), fog*fog), 1.0f);\n"
+    "}";
+
+typedef struct
+{
+    int count;
+    float spacing, extent, radius; // radius of the mesh, before a copy's scale
+    float *x, *y, *z, *r;          // world space bounding spheres, SoA for cull_spheres
+    float *scale;
+    hmm_mat3x4 *models;
+} Forest;
+
+// rolling hills a few trees high, in units of the tree radius
+float terrain_height(float x, float z, float radius)
+{
+    float u = x / radius, v = z / radius;
+    return radius * (2.0f * sinf(u * 0.05f) * cosf(v * 0.04f) + 0.7f * sinf(u * 0.13f + v * 0.11f));
+}
+
+// one copy per cell of a square grid big enough for count, jittered inside its cell
+int forest_create(Forest *forest, const mesh_header *h, int count)
+{
+    hmm_vec3 center = HMM_Vec3((h->min[0] + h->max[0]) * 0.5f, (h->min[1] + h->max[1]) * 0.5f,
+                               (h->min[2] + h->max[2]) * 0.5f);
+    forest->count = count;
+    forest->radius = HMM_LengthVec3(HMM_SubtractVec3(HMM_Vec3(h->max[0], h->max[1], h->max[2]), center));
+    forest->spacing = 2.0f * forest->radius;
+    int side = (int)ceilf(sqrtf((float)count));
+    forest->extent = side * forest->spacing;
+    forest->x = malloc(count * sizeof(float));
+    forest->y = malloc(count * sizeof(float));
+    forest->z = malloc(count * sizeof(float));
+    forest->r = malloc(count * sizeof(float));
+    forest->scale = malloc(count * sizeof(float));
+    forest->models = malloc(count * sizeof(hmm_mat3x4));
+    if (!forest->x || !forest->y || !forest->z || !forest->r || !forest->scale || !forest->models) {
+        return 0;
+    }
+
+    headless_rng_seed(12345);
+    for (int i = 0; i < count; i++) {
+        float x = ((i % side) + 0.2f + 0.6f * headless_rng()) * forest->spacing;
+        float z = ((i / side) + 0.2f + 0.6f * headless_rng()) * forest->spacing;
+        float s = 0.7f + 0.6f * headless_rng();
+        // stand the mesh's bottom on the ground
+        hmm_vec3 ground = HMM_Vec3(x, terrain_height(x, z, forest->radius) - h->min[1] * s, z);
+        hmm_mat4 model = HMM_MultiplyMat4(HMM_Translate(ground),
+                                          HMM_MultiplyMat4(HMM_Rotate(360.0f * headless_rng(), HMM_Vec3(0.0f, 1.0f, 0.0f)),
+                                                           HMM_Scale(HMM_Vec3(s, s, s))));
+        forest->models[i] = HMM_Mat3x4FromMat4(model);
+        hmm_vec3 world = HMM_MultiplyMat3x4ByPoint(forest->models[i], center);
+        forest->x[i] = world.X;
+        forest->y[i] = world.Y;
+        forest->z[i] = world.Z;
+        forest->r[i] = forest->radius * s;
+        forest->scale[i] = s;
+    }
+    return 1;
+}
+
+void forest_free(Forest *forest)
+{
+    free(forest->x);
+    free(forest->y);
+    free(forest->z);
+    free(forest->r);
+    free(forest->scale);
+    free(forest->models);
+}
+
+// a TERRAIN_CELLS grid over the forest, position and normal per vertex
+GLuint terrain_create(const Forest *forest, GLuint *buffers)
+{
+    int side = TERRAIN_CELLS + 1;
+    float *vertices = malloc(side * side * 6 * sizeof(float));
+    unsigned int *indices = malloc(TERRAIN_CELLS * TERRAIN_CELLS * 6 * sizeof(unsigned int));
+    float step = forest->extent / TERRAIN_CELLS, e = 0.5f * step, radius = forest->radius;
+    for (int j = 0; j < side; j++) {
+        for (int i = 0; i < side; i++) {
+            float x = i * step, z = j * step;
+            float *v = &vertices[(j * side + i) * 6];
+            hmm_vec3 normal = HMM_NormalizeVec3(HMM_Vec3(terrain_height(x - e, z, radius) - terrain_height(x + e, z, radius),
+                                                         2.0f * e,
+                                                         terrain_height(x, z - e, radius) - terrain_height(x, z + e, radius)));
+            v[0] = x;
+            v[1] = terrain_height(x, z, radius);
+            v[2] = z;
+            v[3] = normal.X;
+            v[4] = normal.Y;
+            v[5] = normal.Z;
+        }
+    }
+    unsigned int *index = indices;
+    for (int j = 0; j < TERRAIN_CELLS; j++) {
+        for (int i = 0; i < TERRAIN_CELLS; i++) {
+            unsigned int a = j * side + i, b = a + 1, c = a + side, d = c + 1;
+            // counter clockwise seen from above
+            *index++ = a;
+            *index++ = c;
+            *index++ = b;
+            *index++ = b;
+            *index++ = c;
+            *index++ = d;
+        }
+    }
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, side * side * 6 * sizeof(float), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, TERRAIN_CELLS * TERRAIN_CELLS * 6 * sizeof(unsigned int), indices,
+                 GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+    glBindVertexArray(0);
+    free(vertices);
+    free(indices);
+    return vao;
+}
+
+// a loop around the middle of the forest, a few trees above the ground, looking along it and a little down
+void camera_path(const Forest *forest, float t, hmm_vec3 *eye, hmm_vec3 *target)
+{
+    float c = 0.5f * forest->extent, loop = 0.3f * forest->extent, radius = forest->radius;
+    float angle = 2.0f * HMM_PI32 * t;
+    float x = c + loop * cosf(angle), z = c + 0.7f * loop * sinf(angle);
+    hmm_vec3 along = HMM_NormalizeVec3(HMM_Vec3(-sinf(angle), 0.0f, 0.7f * cosf(angle)));
+    float tx = x + 20.0f * radius * along.X, tz = z + 20.0f * radius * along.Z;
+    *eye = HMM_Vec3(x, terrain_height(x, z, radius) + 6.0f * radius, z);
+    *target = HMM_Vec3(tx, terrain_height(tx, tz, radius) + radius, tz);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 60;
+    int default_counts[3] = {1000, 10000, 100000};
+    int run_count = argc > 2 ? argc - 2 : 3;
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    if (!headless_context_create()) {
+        return -1;
+    }
+    const char *path = "./third_party/assets/Tree.obj";
+    mesh_data mesh;
+    if (!mesh_load_obj(&mesh, path, 0)) {
+        return -1;
+    }
+    const mesh_header *h = mesh.header;
+    GLuint vbo, ibo;
+    GLuint vao = mesh_upload(&mesh, &vbo, &ibo);
+    GLuint materials = mesh_upload_materials(&mesh);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, materials);
+    // every submesh of a level is one run of the index buffer, one draw per level
+    uint32_t level_count[MESH_MAX_LODS] = {0}, level_triangles[MESH_MAX_LODS] = {0};
+    for (uint32_t l = 0; l < h->lod_count; l++) {
+        for (uint32_t s = 0; s < h->submesh_count; s++) {
+            level_count[l] += mesh.lods[l * h->submesh_count + s].index_count;
+        }
+        level_triangles[l] = level_count[l] / 3;
+    }
+
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    GLuint tree_program = headless_program(1, &tree_vs, &tree_fs);
+    GLuint terrain_program = headless_program(1, &terrain_vs, &terrain_fs);
+
+    double *frame_ms = malloc(frames * sizeof(double)), *cpu_ms = malloc(frames * sizeof(double));
+    printf("{\n");
+    printf("  \"mesh\": \"%s\", \"width\": %d, \"height\": %d, \"frames\": %d, \"max_pixel_error\": %.1f,\n", path,
+           WIDTH, HEIGHT, frames, MAX_PIXEL_ERROR);
+    printf("  \"levels\": [");
+    for (uint32_t l = 0; l < h->lod_count; l++) {
+        printf("%s%u", l ? ", " : "", level_triangles[l]);
+    }
+    printf("],\n");
+    printf("  \"runs\": [\n");
+    for (int run = 0; run < run_count; run++) {
+        int count = argc > 2 ? atoi(argv[2 + run]) : default_counts[run];
+        if (count < 1) {
+            count = 1;
+        }
+        Forest forest;
+        if (!forest_create(&forest, h, count)) {
+            printf("Out of memory for %d copies\n", count);
+            return -1;
+        }
+        int *visible = malloc(count * sizeof(int));
+        unsigned char *levels = malloc(count);
+        hmm_mat3x4 *sorted = malloc(count * sizeof(hmm_mat3x4));
+        GLuint terrain_buffers[2];
+        GLuint terrain = terrain_create(&forest, terrain_buffers);
+
+        GLuint instances;
+        glBindVertexArray(vao);
+        glGenBuffers(1, &instances);
+        glBindBuffer(GL_ARRAY_BUFFER, instances);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(hmm_mat3x4), NULL, GL_STREAM_DRAW);
+        for (int row = 0; row < 3; row++) {
+            glEnableVertexAttribArray(4 + row);
+            glVertexAttribPointer(4 + row, 4, GL_FLOAT, GL_FALSE, sizeof(hmm_mat3x4), (void *)(row * 4 * sizeof(float)));
+            glVertexAttribDivisor(4 + row, 1);
+        }
+
+        float view_distance = VIEW_DISTANCE * forest.radius;
+        hmm_mat4 projection = HMM_Perspective(FOV, (float)WIDTH / HEIGHT, 0.1f * forest.radius, view_distance);
+        double visible_sum = 0.0, triangle_sum = 0.0;
+        int visible_max = 0;
+        unsigned long long triangle_max = 0;
+        // one frame first to warm up the driver
+        for (int f = -1; f < frames; f++) {
+            double start = headless_now_ms();
+            hmm_vec3 eye, target;
+            camera_path(&forest, f < 0 ? 0.0f : (float)f / frames, &eye, &target);
+            hmm_mat4 view = HMM_LookAt(eye, target, HMM_Vec3(0.0f, 1.0f, 0.0f));
+            hmm_mat4 projection_view = HMM_MultiplyMat4(projection, view);
+            cull_frustum frustum = cull_frustum_from_matrix(projection_view);
+            int visible_count = cull_spheres(&frustum, forest.x, forest.y, forest.z, forest.r, count, visible);
+
+            // survivors bucketed by level, then one instanced draw each
+            unsigned int per_level[MESH_MAX_LODS] = {0}, first[MESH_MAX_LODS] = {0}, fill[MESH_MAX_LODS];
+            for (int v = 0; v < visible_count; v++) {
+                int i = visible[v];
+                float distance = HMM_LengthVec3(HMM_SubtractVec3(HMM_Vec3(forest.x[i], forest.y[i], forest.z[i]), eye));
+                float scale = mesh_lod_scale(FOV, HEIGHT, distance, forest.r[i]);
+                levels[v] = (unsigned char)mesh_lod_select(&mesh, scale * forest.scale[i], MAX_PIXEL_ERROR);
+                per_level[levels[v]]++;
+            }
+            for (uint32_t l = 1; l < h->lod_count; l++) {
+                first[l] = first[l - 1] + per_level[l - 1];
+            }
+            memcpy(fill, first, sizeof(fill));
+            for (int v = 0; v < visible_count; v++) {
+                sorted[fill[levels[v]]++] = forest.models[visible[v]];
+            }
+            double culled = headless_now_ms();
+
+            glClearColor(0.6f, 0.7f, 0.8f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUseProgram(terrain_program);
+            glUniformMatrix4fv(glGetUniformLocation(terrain_program, "projection_view"), 1, GL_FALSE,
+                               &projection_view.Elements[0][0]);
+            glUniform3f(glGetUniformLocation(terrain_program, "camera"), eye.X, eye.Y, eye.Z);
+            glUniform1f(glGetUniformLocation(terrain_program, "fog_end"), view_distance);
+            glBindVertexArray(terrain);
+            glDrawElements(GL_TRIANGLES, TERRAIN_CELLS * TERRAIN_CELLS * 6, GL_UNSIGNED_INT, (void *)0);
+
+            glUseProgram(tree_program);
+            glUniformMatrix4fv(glGetUniformLocation(tree_program, "projection_view"), 1, GL_FALSE,
+                               &projection_view.Elements[0][0]);
+            glUniform3f(glGetUniformLocation(tree_program, "camera"), eye.X, eye.Y, eye.Z);
+            glUniform1f(glGetUniformLocation(tree_program, "fog_end"), view_distance);
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, instances);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, visible_count * sizeof(hmm_mat3x4), sorted);
+            unsigned long long triangles = 0;
+            for (uint32_t l = 0; l < h->lod_count; l++) {
+                if (per_level[l]) {
+                    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, level_count[l], GL_UNSIGNED_INT,
+                                                        (void *)(mesh.lods[l * h->submesh_count].index_offset * sizeof(uint32_t)),
+                                                        per_level[l], first[l]);
+                    triangles += (unsigned long long)level_triangles[l] * per_level[l];
+                }
+            }
+            glFinish();
+            if (f >= 0) {
+                frame_ms[f] = headless_now_ms() - start;
+                cpu_ms[f] = culled - start;
+                visible_sum += visible_count;
+                triangle_sum += (double)triangles;
+                visible_max = visible_count > visible_max ? visible_count : visible_max;
+                triangle_max = triangles > triangle_max ? triangles : triangle_max;
+            }
+        }
+
+        qsort(frame_ms, frames, sizeof(double), headless_compare_double);
+        qsort(cpu_ms, frames, sizeof(double), headless_compare_double);
+        printf("    {\"instances\": %d, \"frame_ms_median\": %.2f, \"frame_ms_p95\": %.2f, \"cull_lod_ms_median\": %.3f, \"visible_avg\": %.0f, \"visible_max\": %d, \"triangles_avg\": %.0f, \"triangles_max\": %llu}%s\n",
+               count, frame_ms[frames / 2], frame_ms[frames * 95 / 100], cpu_ms[frames / 2], visible_sum / frames,
+               visible_max, triangle_sum / frames, triangle_max, run + 1 < run_count ? "," : "");
+        fflush(stdout);
+
+        glDeleteBuffers(1, &instances);
+        glDeleteBuffers(2, terrain_buffers);
+        glDeleteVertexArrays(1, &terrain);
+        free(visible);
+        free(levels);
+        free(sorted);
+        forest_free(&forest);
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    free(frame_ms);
+    free(cpu_ms);
+    mesh_close(&mesh);
+    headless_context_destroy();
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+  headless.h
+
+  Creates an OpenGL context without a window (EGL surfaceless, e.g. Mesa
+  llvmpipe on a CI box) so benchmarks can run where GLFW can't open a
+  display. Render into your own framebuffer object, there is no default
+  framebuffer.
+
+  Do this:
+
+     #define HEADLESS_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header, AFTER glad.h. Link with
+  -lEGL.
+
+  Usage:
+
+     if (!headless_context_create()) return -1;
+     ... gl calls ...
+     headless_context_destroy();
+
+  LIBGL_ALWAYS_SOFTWARE=1 forces llvmpipe if a GPU driver gets picked.
+
+  The benchmarks share a few helpers from here as well: a millisecond
+  clock, a qsort comparison for medians, shader compile and link, and a
+  seeded random number generator so every run scatters things the same
+  way.
+*/
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// returns 0 on failure, glad is loaded on success
+int headless_context_create(void);
+void headless_context_destroy(void);
+
+// CLOCK_MONOTONIC in milliseconds
+double headless_now_ms(void);
+// qsort comparison for ascending doubles
+int headless_compare_double(const void *a, const void *b);
+// compiles count source strings as one shader, prints the log if it fails
+GLuint headless_compile(GLenum type, int count, const char **sources);
+// links the vertex and fragment shaders made of count source strings each
+GLuint headless_program(int count, const char **vertex_sources, const char **fragment_sources);
+// [0, 1), the same sequence every run
+float headless_rng(void);
+// restarts the sequence, so something rebuilt comes out the same
+void headless_rng_seed(unsigned int seed);
+
+#endif // HEADLESS_H
+
+#ifdef HEADLESS_IMPLEMENTATION
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <time.h>
+
+static EGLDisplay headless_display = EGL_NO_DISPLAY;
+static EGLContext headless_context = EGL_NO_CONTEXT;
+
+int
+headless_context_create(void)
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+        headless_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (headless_display == EGL_NO_DISPLAY) {
+        headless_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major, minor;
+    if (headless_display == EGL_NO_DISPLAY || !eglInitialize(headless_display, &major, &minor)) {
+        printf("Failed to initialize EGL\n");
+        return 0;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        printf("EGL has no desktop OpenGL\n");
+        return 0;
+    }
+
+    EGLint config_attribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(headless_display, config_attribs, &config, 1, &config_count) || config_count == 0) {
+        // surfaceless displays may expose no configs at all, that's fine for EGL_KHR_no_config_context
+        config = (EGLConfig)0;
+    }
+
+    EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    headless_context = eglCreateContext(headless_display, config, EGL_NO_CONTEXT, context_attribs);
+    if (headless_context == EGL_NO_CONTEXT) {
+        printf("Failed to create a GL 4.5 core context\n");
+        return 0;
+    }
+
+    if (!eglMakeCurrent(headless_display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless_context)) {
+        printf("Failed to make the context current (no EGL_KHR_surfaceless_context?)\n");
+        return 0;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        printf("Failed to initialize GLAD");
+        return 0;
+    }
+
+    return 1;
+}
+
+void
+headless_context_destroy(void)
+{
+    if (headless_display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(headless_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (headless_context != EGL_NO_CONTEXT) {
+            eglDestroyContext(headless_display, headless_context);
+        }
+        eglTerminate(headless_display);
+    }
+    headless_display = EGL_NO_DISPLAY;
+    headless_context = EGL_NO_CONTEXT;
+}
+
+double
+headless_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int
+headless_compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+GLuint
+headless_compile(GLenum type, int count, const char **sources)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, count, sources, NULL);
+    glCompileShader(shader);
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        printf("Failed to compile shader: %s\n", log);
+    }
+    return shader;
+}
+
+GLuint
+headless_program(int count, const char **vertex_sources, const char **fragment_sources)
+{
+    GLuint program = glCreateProgram();
+    GLuint vertex_shader = headless_compile(GL_VERTEX_SHADER, count, vertex_sources);
+    GLuint fragment_shader = headless_compile(GL_FRAGMENT_SHADER, count, fragment_sources);
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    return program;
+}
+
+static unsigned int headless_rng_state = 12345;
+
+float
+headless_rng(void)
+{
+    headless_rng_state = headless_rng_state * 1664525u + 1013904223u;
+    return (headless_rng_state >> 8) / 16777216.0f;
+}
+
+void
+headless_rng_seed(unsigned int seed)
+{
+    headless_rng_state = seed;
+}
+
+#endif // HEADLESS_IMPLEMENTATION
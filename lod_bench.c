@@ -0,0 +1,259 @@
+// Level of detail benchmark.
+//
+// Draws a field of instanced copies of a mesh (default Tree.obj) stretching
+// away from the camera, once with every copy at full detail and once with
+// mesh_lod_select picking each copy's level from the projected size of its
+// bounding sphere (at most 1 pixel of error), then prints the triangles
+// submitted, frame times and how many pixels came out different as JSON.
+// Every copy is drawn, no culling, so the difference is the LOD alone. Runs
+// headless (EGL surfaceless), LIBGL_ALWAYS_SOFTWARE=1 pins it to llvmpipe.
+//
+// usage: ./lod_bench [path] [copies per side] [frames]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "glad.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+#define HEADLESS_IMPLEMENTATION
+#include "headless.h"
+
+#define WIDTH 1280
+#define HEIGHT 720
+#define FOV 45.0f
+#define MAX_PIXEL_ERROR 1.0f
+
+const char *vs = "#version 450 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec3 aNormal;\n"
+    "// per instance hmm_mat3x4, the rows of the model matrix without (0, 0, 0, 1)\n"
+    "layout (location = 4) in vec4 aModel0;\n"
+    "layout (location = 5) in vec4 aModel1;\n"
+    "layout (location = 6) in vec4 aModel2;\n"
+    "\n"
+    "out vec3 Normal;\n"
+    "\n"
+    "uniform mat4 projection_view;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    mat4 model = transpose(mat4(aModel0, aModel1, aModel2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));\n"
+    "    gl_Position = projection_view*model*vec4(aPos, 1.0f);\n"
+    "    Normal = mat3(model)*aNormal;\n"
+    "}";
+
+const char *fs = "#version 450 core\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "in vec3 Normal;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    float light = max(dot(normalize(Normal), normalize(vec3(0.4f, 1.0f, 0.3f))), 0.0f);\n"
+    "    FragColor = vec4(vec3(0.2f + 0.8f*light), 1.0f);\n"
+    "}";
+
+typedef struct {
+    double *frame_ms;
+    double select_us;
+    unsigned long long triangles;
+    unsigned int copies_per_level[MESH_MAX_LODS];
+} Mode;
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "./third_party/assets/Tree.obj";
+    int side = argc > 2 ? atoi(argv[2]) : 48;
+    int frames = argc > 3 ? atoi(argv[3]) : 10;
+    if (side < 1) {
+        side = 1;
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    if (!headless_context_create()) {
+        return -1;
+    }
+    mesh_data mesh;
+    if (!mesh_load_obj(&mesh, path, 0)) {
+        return -1;
+    }
+    const mesh_header *h = mesh.header;
+    GLuint vbo, ibo;
+    GLuint vao = mesh_upload(&mesh, &vbo, &ibo);
+
+    // the field: copies with a random turn and size, spaced so they don't overlap
+    hmm_vec3 center = HMM_Vec3((h->min[0] + h->max[0]) * 0.5f, (h->min[1] + h->max[1]) * 0.5f,
+                               (h->min[2] + h->max[2]) * 0.5f);
+    float radius = HMM_LengthVec3(HMM_SubtractVec3(HMM_Vec3(h->max[0], h->max[1], h->max[2]), center));
+    float spacing = 2.0f * radius;
+    int copies = side * side;
+    hmm_mat3x4 *models = malloc(copies * sizeof(hmm_mat3x4));
+    hmm_mat3x4 *sorted = malloc(copies * sizeof(hmm_mat3x4));
+    float *scales = malloc(copies * sizeof(float));
+    unsigned char *levels = malloc(copies);
+    for (int i = 0; i < copies; i++) {
+        scales[i] = 0.8f + 0.4f * headless_rng();
+        hmm_mat4 model = HMM_MultiplyMat4(HMM_Translate(HMM_Vec3((i % side) * spacing, 0.0f, (i / side) * spacing)),
+                                          HMM_MultiplyMat4(HMM_Rotate(360.0f * headless_rng(), HMM_Vec3(0.0f, 1.0f, 0.0f)),
+                                                           HMM_Scale(HMM_Vec3(scales[i], scales[i], scales[i]))));
+        models[i] = HMM_Mat3x4FromMat4(model);
+    }
+
+    GLuint instances;
+    glBindVertexArray(vao);
+    glGenBuffers(1, &instances);
+    glBindBuffer(GL_ARRAY_BUFFER, instances);
+    glBufferData(GL_ARRAY_BUFFER, copies * sizeof(hmm_mat3x4), NULL, GL_STREAM_DRAW);
+    for (int row = 0; row < 3; row++) {
+        glEnableVertexAttribArray(4 + row);
+        glVertexAttribPointer(4 + row, 4, GL_FLOAT, GL_FALSE, sizeof(hmm_mat3x4), (void *)(row * 4 * sizeof(float)));
+        glVertexAttribDivisor(4 + row, 1);
+    }
+
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    GLuint program = headless_program(1, &vs, &fs);
+    glUseProgram(program);
+
+    // from a corner, a little above the trees, looking across the field
+    float extent = side * spacing;
+    hmm_vec3 camera = HMM_Vec3(-spacing, 2.0f * radius, -spacing);
+    hmm_mat4 projection = HMM_Perspective(FOV, (float)WIDTH / HEIGHT, 0.1f * radius, 4.0f * extent);
+    hmm_mat4 view = HMM_LookAt(camera, HMM_Vec3(0.5f * extent, 0.0f, 0.5f * extent), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    hmm_mat4 projection_view = HMM_MultiplyMat4(projection, view);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection_view"), 1, GL_FALSE, &projection_view.Elements[0][0]);
+
+    const char *mode_names[2] = {"full", "lod"};
+    Mode modes[2];
+    unsigned char *pixels[2];
+    memset(modes, 0, sizeof(modes));
+    for (int m = 0; m < 2; m++) {
+        modes[m].frame_ms = calloc(frames, sizeof(double));
+        pixels[m] = malloc(WIDTH * HEIGHT * 4);
+        // one frame first to warm up the driver
+        for (int f = -1; f < frames; f++) {
+            double start = headless_now_ms();
+            unsigned int per_level[MESH_MAX_LODS] = {0}, first[MESH_MAX_LODS] = {0};
+            for (int i = 0; i < copies; i++) {
+                hmm_vec3 world = HMM_MultiplyMat3x4ByPoint(models[i], center);
+                float distance = HMM_LengthVec3(HMM_SubtractVec3(world, camera));
+                float scale = mesh_lod_scale(FOV, HEIGHT, distance, radius * scales[i]);
+                // model units of this copy are scales[i] world units
+                levels[i] = m ? (unsigned char)mesh_lod_select(&mesh, scale * scales[i], MAX_PIXEL_ERROR) : 0;
+                per_level[levels[i]]++;
+            }
+            for (uint32_t l = 1; l < h->lod_count; l++) {
+                first[l] = first[l - 1] + per_level[l - 1];
+            }
+            unsigned int fill[MESH_MAX_LODS];
+            memcpy(fill, first, sizeof(fill));
+            for (int i = 0; i < copies; i++) {
+                sorted[fill[levels[i]]++] = models[i];
+            }
+            double selected = headless_now_ms();
+
+            glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, copies * sizeof(hmm_mat3x4), sorted);
+            unsigned long long triangles = 0;
+            for (uint32_t l = 0; l < h->lod_count; l++) {
+                for (uint32_t s = 0; per_level[l] && s < h->submesh_count; s++) {
+                    const mesh_lod *lod = &mesh.lods[l * h->submesh_count + s];
+                    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, lod->index_count, GL_UNSIGNED_INT,
+                                                        (void *)(lod->index_offset * sizeof(uint32_t)), per_level[l],
+                                                        first[l]);
+                    triangles += (unsigned long long)lod->index_count / 3 * per_level[l];
+                }
+            }
+            glFinish();
+            if (f >= 0) {
+                modes[m].frame_ms[f] = headless_now_ms() - start;
+                modes[m].select_us += (selected - start) * 1e3 / frames;
+            }
+            modes[m].triangles = triangles;
+            memcpy(modes[m].copies_per_level, per_level, sizeof(per_level));
+        }
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels[m]);
+    }
+
+    // pixels where any channel moved by more than a couple of steps
+    int changed = 0;
+    for (int p = 0; p < WIDTH * HEIGHT; p++) {
+        int differs = 0;
+        for (int c = 0; c < 3; c++) {
+            differs |= abs(pixels[0][p * 4 + c] - pixels[1][p * 4 + c]) > 2;
+        }
+        changed += differs;
+    }
+
+    printf("{\n");
+    printf("  \"mesh\": \"%s\",\n", path);
+    printf("  \"copies\": %d, \"frames\": %d, \"width\": %d, \"height\": %d, \"fov\": %.1f, \"max_pixel_error\": %.1f,\n",
+           copies, frames, WIDTH, HEIGHT, FOV, MAX_PIXEL_ERROR);
+    printf("  \"levels\": [");
+    for (uint32_t l = 0; l < h->lod_count; l++) {
+        uint32_t triangles = 0;
+        for (uint32_t s = 0; s < h->submesh_count; s++) {
+            triangles += mesh.lods[l * h->submesh_count + s].index_count / 3;
+        }
+        printf("%s{\"triangles\": %u, \"error\": %.4f}", l ? ", " : "", triangles, h->lod_error[l]);
+    }
+    printf("],\n");
+    printf("  \"modes\": [\n");
+    for (int m = 0; m < 2; m++) {
+        qsort(modes[m].frame_ms, frames, sizeof(double), headless_compare_double);
+        printf("    {\"name\": \"%s\", \"triangles\": %llu, \"frame_ms_min\": %.2f, \"frame_ms_median\": %.2f, \"select_us\": %.1f, \"copies_per_level\": [",
+               mode_names[m], modes[m].triangles, modes[m].frame_ms[0], modes[m].frame_ms[frames / 2], modes[m].select_us);
+        for (uint32_t l = 0; l < h->lod_count; l++) {
+            printf("%s%u", l ? ", " : "", modes[m].copies_per_level[l]);
+        }
+        printf("]}%s\n", m ? "" : ",");
+    }
+    printf("  ],\n");
+    printf("  \"pixels_changed\": %.5f\n", (double)changed / (WIDTH * HEIGHT));
+    printf("}\n");
+
+    for (int m = 0; m < 2; m++) {
+        free(modes[m].frame_ms);
+        free(pixels[m]);
+    }
+    free(models);
+    free(sorted);
+    free(scales);
+    free(levels);
+    mesh_close(&mesh);
+    headless_context_destroy();
+    return 0;
+}
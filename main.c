@@ -15,6 +15,15 @@
 #define HANDMADE_MATH_IMPLEMENTATION
 #include "handmade_math.h"
 
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define TEXTURE_IMPLEMENTATION
+#include "texture.h"
+
+#define CULL_IMPLEMENTATION
+#include "cull.h"
+
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -41,15 +50,19 @@ float lastFrame = 0.0f;
 const char *vs = "#version 460 core\n"
     "layout (location = 0) in vec3 aPos;\n"
     "layout (location = 1) in vec2 aTexCoord;\n"
+    "// per instance hmm_mat3x4, the rows of the model matrix without (0, 0, 0, 1)\n"
+    "layout (location = 2) in vec4 aModel0;\n"
+    "layout (location = 3) in vec4 aModel1;\n"
+    "layout (location = 4) in vec4 aModel2;\n"
     "\n"
     "out vec2 TexCoord;\n"
     "\n"
-    "uniform mat4 model;\n"
     "uniform mat4 view;\n"
     "uniform mat4 projection;\n"
     "\n"
     "void main()\n"
     "{\n"
+    "    mat4 model = transpose(mat4(aModel0, aModel1, aModel2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));\n"
     "    gl_Position = projection*view*model*vec4(aPos, 1.0f);\n"
     "    TexCoord = vec2(aTexCoord.x, aTexCoord.y);\n"
     "}";
@@ -204,18 +217,15 @@ int main(void)
     
     // font setup
     // ----
-    /* long size; */
-    /* unsigned char* fontBuffer; */
-    /* FILE* fontFile = fopen("./third_party/fonts/Hack-Regular.ttf", "rb"); */
-    /* fseek(fontFile, 0, SEEK_END); */
-    /* size = ftell(fontFile); */
-    /* fseek(fontFile, 0, SEEK_SET); */
-    /* fontBuffer = malloc(size); */
-    /* fread(fontBuffer, size, 1, fontFile); */
-    /* fclose(fontFile); */
+    /* // stb_truetype reads straight from the mapping, keep it mapped while info is in use */
+    /* asset_file fontFile; */
+    /* if (!asset_map(&fontFile, "./third_party/fonts/Hack-Regular.ttf")) */
+    /* { */
+    /*     return -1; */
+    /* } */
 
     /* stbtt_fontinfo info; */
-    /* if (!stbtt_InitFont(&info, fontBuffer, 0)) */
+    /* if (!stbtt_InitFont(&info, fontFile.data, stbtt_GetFontOffsetForIndex(fontFile.data, 0))) */
     /* { */
     /*     printf("failed\n"); */
     /* } */
@@ -408,30 +418,26 @@ int main(void)
     // texture coord attribute
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+    // model matrix attributes, one hmm_mat3x4 per cube
+    unsigned int instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, 10 * sizeof(hmm_mat3x4), NULL, GL_STREAM_DRAW);
+    for (int row = 0; row < 3; row++) {
+        glVertexAttribPointer(2 + row, 4, GL_FLOAT, GL_FALSE, sizeof(hmm_mat3x4), (void*)(row * 4 * sizeof(float)));
+        glVertexAttribDivisor(2 + row, 1);
+        glEnableVertexAttribArray(2 + row);
+    }
 
     // doge and jeremey textures
-    unsigned int texture1;
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1); 
+    // load image, create texture and generate mipmaps
+    stbi_set_flip_vertically_on_load(1); // tell stb_image.h to flip loaded texture's on the y-advance_widthis.
+    unsigned int texture1 = texture_load("./third_party/images/pp.jpg", TEXTURE_USAGE_COLOR, 1, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// set texture wrapping to GL_REPEAT (default wrapping method)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     // set texture filtering parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(1); // tell stb_image.h to flip loaded texture's on the y-advance_widthis.
-    unsigned char *data = stbi_load("./third_party/images/pp.jpg", &width, &height, &nrChannels, 4);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        printf("Failed to load texture\n");
-    }
-    stbi_image_free(data);
     
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
@@ -444,7 +450,6 @@ int main(void)
     // view is the "camera" -- think FPS view
     GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
     GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
 
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
@@ -479,18 +484,42 @@ int main(void)
 
 
         // draw cubes
+        hmm_transform cubes[10];
+        hmm_quaternion rotations[10];
+        float angles[10];
         for (int i = 0; i < 10; i++) {
-            hmm_mat4 model = HMM_Translate(cubePositions[i]);
             int n = i;
             if (n == 0) {
                 n = 1;
             }
             float angle = 20.0f*n;
-            model = HMM_Rotate_With_Mat4(model, ((float)glfwGetTime() * HMM_ToRadians(angle)*100), HMM_Vec3(1.0f, 0.3f, 0.5f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, (const GLfloat*)model.Elements);
+            angles[i] = HMM_ToRadians((float)glfwGetTime() * HMM_ToRadians(angle)*100);
+        }
+        HMM_QuaternionsFromAxisAngle(HMM_Vec3(1.0f, 0.3f, 0.5f), angles, rotations, 10);
+        for (int i = 0; i < 10; i++) {
+            cubes[i] = HMM_Transform(cubePositions[i], rotations[i], HMM_Vec3(1.0f, 1.0f, 1.0f));
+        }
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+        // bounding spheres around the unit cubes, whatever rotation they're in
+        float cube_x[10], cube_y[10], cube_z[10], cube_r[10];
+        for (int i = 0; i < 10; i++) {
+            cube_x[i] = cubePositions[i].X;
+            cube_y[i] = cubePositions[i].Y;
+            cube_z[i] = cubePositions[i].Z;
+            cube_r[i] = 0.87f; // sqrt(3) / 2
         }
+        cull_frustum frustum = cull_frustum_from_matrix(HMM_MultiplyMat4(projection, view));
+        int visible[10];
+        int visible_count = cull_spheres(&frustum, cube_x, cube_y, cube_z, cube_r, 10, visible);
+
+        // one instanced draw for everything that survived
+        hmm_mat3x4 models[10];
+        for (int v = 0; v < visible_count; v++) {
+            models[v] = HMM_TransformToMat3x4(cubes[visible[v]]);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, visible_count * sizeof(hmm_mat3x4), models);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, visible_count);
         glBindVertexArray(0);
         glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -575,10 +604,15 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     if (pitch < -89.0f)
         pitch = -89.0f;
 
+    // yaw and pitch in one go instead of four libm calls
+    float angles[2] = {HMM_ToRadians(yaw), HMM_ToRadians(pitch)};
+    float sines[2], cosines[2];
+    HMM_SinCos(angles, sines, cosines, 2);
+
     hmm_vec3 front = {
-        .X = cos(HMM_ToRadians(yaw)) * cos(HMM_ToRadians(pitch)),
-        .Y = sin(HMM_ToRadians(pitch)),
-        .Z = sin(HMM_ToRadians(yaw)) * cos(HMM_ToRadians(pitch))
+        .X = cosines[0] * cosines[1],
+        .Y = sines[1],
+        .Z = sines[0] * cosines[1]
     };
 
     cameraFront = HMM_NormalizeVec3(front);
@@ -0,0 +1,320 @@
+// Material batching benchmark.
+//
+// Draws a grid of copies of a multi-material mesh (default Tree.obj, 6
+// usemtl runs over 2 materials), one draw per copy the way a scene of
+// separate objects would, three ways: a draw and a color uniform per usemtl
+// run as the file has them (obj_load), a draw per material from the
+// mesh.h cache (obj_group_by_material), and a single draw per copy that
+// reads the material from the table mesh_upload_materials builds. Then
+// every copy in one instanced draw. Prints draws per frame, CPU submit
+// and frame times, and how many pixels differ from the first way, as
+// JSON. Runs headless (EGL surfaceless), LIBGL_ALWAYS_SOFTWARE=1 pins it
+// to llvmpipe.
+//
+// usage: ./material_bench [path] [copies per side] [frames]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "glad.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+#define HEADLESS_IMPLEMENTATION
+#include "headless.h"
+
+#define WIDTH 1280
+#define HEIGHT 720
+
+// the variants below switch on TABLE (material from the table, else the diffuse uniform) and
+// INSTANCED (model rows per instance, else the model uniform)
+const char *vs = "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec3 aNormal;\n"
+    "#ifdef TABLE\n"
+    "layout (location = 3) in uint aMaterial;\n"
+    "flat out uint MaterialIndex;\n"
+    "#endif\n"
+    "#ifdef INSTANCED\n"
+    "layout (location = 4) in vec4 aModel0;\n"
+    "layout (location = 5) in vec4 aModel1;\n"
+    "layout (location = 6) in vec4 aModel2;\n"
+    "#else\n"
+    "uniform vec4 model[3];\n"
+    "#endif\n"
+    "\n"
+    "out vec3 Normal;\n"
+    "\n"
+    "uniform mat4 projection_view;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "#ifdef INSTANCED\n"
+    "    mat4 world = transpose(mat4(aModel0, aModel1, aModel2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));\n"
+    "#else\n"
+    "    mat4 world = transpose(mat4(model[0], model[1], model[2], vec4(0.0f, 0.0f, 0.0f, 1.0f)));\n"
+    "#endif\n"
+    "    gl_Position = projection_view*world*vec4(aPos, 1.0f);\n"
+    "    Normal = mat3(world)*aNormal;\n"
+    "#ifdef TABLE\n"
+    "    MaterialIndex = aMaterial;\n"
+    "#endif\n"
+    "}";
+
+const char *fs = "out vec4 FragColor;\n"
+    "\n"
+    "in vec3 Normal;\n"
+    "\n"
+    "#ifdef TABLE\n"
+    "struct Material { vec4 diffuse; vec4 specular; vec4 emissive; ivec4 maps; };\n"
+    "layout (std430, binding = 0) readonly buffer Materials { Material materials[]; };\n"
+    "flat in uint MaterialIndex;\n"
+    "#else\n"
+    "uniform vec4 diffuse;\n"
+    "#endif\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "#ifdef TABLE\n"
+    "    vec4 color = materials[MaterialIndex].diffuse;\n"
+    "#else\n"
+    "    vec4 color = diffuse;\n"
+    "#endif\n"
+    "    float light = max(dot(normalize(Normal), normalize(vec3(0.4f, 1.0f, 0.3f))), 0.0f);\n"
+    "    FragColor = vec4(color.rgb*(0.2f + 0.8f*light), color.a);\n"
+    "}";
+
+enum
+{
+    MODE_PER_USEMTL,
+    MODE_PER_MATERIAL,
+    MODE_TABLE,
+    MODE_TABLE_INSTANCED,
+    MODE_COUNT
+};
+
+const char *mode_names[MODE_COUNT] = {"per_usemtl", "per_material", "table", "table_instanced"};
+
+// the shaders with the mode's defines after the version line
+GLuint program_create(const char *defines)
+{
+    const char *vertex_sources[3] = {"#version 450 core\n", defines, vs};
+    const char *fragment_sources[3] = {"#version 450 core\n", defines, fs};
+    return headless_program(3, vertex_sources, fragment_sources);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "./third_party/assets/Tree.obj";
+    int side = argc > 2 ? atoi(argv[2]) : 32;
+    int frames = argc > 3 ? atoi(argv[3]) : 10;
+    if (side < 1) {
+        side = 1;
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    if (!headless_context_create()) {
+        return -1;
+    }
+
+    // as the file has it, with the library looked up by hand
+    obj_mesh raw;
+    if (!obj_load(&raw, path)) {
+        return -1;
+    }
+    char mtl_path[1024];
+    const char *slash = strrchr(path, '/');
+    snprintf(mtl_path, sizeof(mtl_path), "%.*s%s", slash ? (int)(slash - path + 1) : 0, path, raw.mtllib);
+    obj_material_lib lib;
+    if (!raw.mtllib[0] || !obj_load_mtl(&lib, mtl_path)) {
+        memset(&lib, 0, sizeof(lib));
+    }
+    float (*raw_colors)[4] = malloc(raw.group_count * sizeof(*raw_colors));
+    for (int g = 0; g < raw.group_count; g++) {
+        obj_material material;
+        int m = obj_find_material(&lib, raw.groups[g].material);
+        if (m >= 0) {
+            material = lib.materials[m];
+        } else {
+            obj_default_material(&material, raw.groups[g].material);
+        }
+        memcpy(raw_colors[g], material.diffuse, 3 * sizeof(float));
+        raw_colors[g][3] = material.opacity;
+    }
+    GLuint raw_vao, raw_buffers[2];
+    glGenVertexArrays(1, &raw_vao);
+    glBindVertexArray(raw_vao);
+    glGenBuffers(2, raw_buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, raw_buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, raw.vertex_count * sizeof(obj_vertex), raw.vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, raw_buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, raw.index_count * sizeof(unsigned int), raw.indices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(obj_vertex), (void *)offsetof(obj_vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(obj_vertex), (void *)offsetof(obj_vertex, normal));
+
+    // the cache, grouped by material
+    mesh_data mesh;
+    if (!mesh_load_obj(&mesh, path, 0)) {
+        return -1;
+    }
+    const mesh_header *h = mesh.header;
+    GLuint vbo, ibo;
+    GLuint vao = mesh_upload(&mesh, &vbo, &ibo);
+    GLuint materials = mesh_upload_materials(&mesh);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, materials);
+    // level 0 of every submesh is one run from the start of the index buffer
+    uint32_t full_count = 0;
+    for (uint32_t s = 0; s < h->submesh_count; s++) {
+        full_count += mesh.lods[s].index_count;
+    }
+
+    // a grid on the ground, looked at from above one corner
+    float radius = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        radius += (h->max[k] - h->min[k]) * (h->max[k] - h->min[k]) * 0.25f;
+    }
+    radius = HMM_SquareRootF(radius);
+    float spacing = 2.0f * radius, extent = side * spacing;
+    int copies = side * side;
+    hmm_mat3x4 *models = malloc(copies * sizeof(hmm_mat3x4));
+    for (int i = 0; i < copies; i++) {
+        hmm_mat4 model = HMM_MultiplyMat4(HMM_Translate(HMM_Vec3((i % side) * spacing, 0.0f, (i / side) * spacing)),
+                                          HMM_Rotate((float)(i * 37 % 360), HMM_Vec3(0.0f, 1.0f, 0.0f)));
+        models[i] = HMM_Mat3x4FromMat4(model);
+    }
+    GLuint instances;
+    glBindVertexArray(vao);
+    glGenBuffers(1, &instances);
+    glBindBuffer(GL_ARRAY_BUFFER, instances);
+    glBufferData(GL_ARRAY_BUFFER, copies * sizeof(hmm_mat3x4), models, GL_STATIC_DRAW);
+    for (int row = 0; row < 3; row++) {
+        glEnableVertexAttribArray(4 + row);
+        glVertexAttribPointer(4 + row, 4, GL_FLOAT, GL_FALSE, sizeof(hmm_mat3x4), (void *)(row * 4 * sizeof(float)));
+        glVertexAttribDivisor(4 + row, 1);
+    }
+
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    hmm_vec3 camera = HMM_Vec3(-spacing, 0.5f * extent, -spacing);
+    hmm_mat4 projection = HMM_Perspective(45.0f, (float)WIDTH / HEIGHT, 0.1f * radius, 4.0f * extent);
+    hmm_mat4 view = HMM_LookAt(camera, HMM_Vec3(0.5f * extent, 0.0f, 0.5f * extent), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    hmm_mat4 projection_view = HMM_MultiplyMat4(projection, view);
+    GLuint programs[MODE_COUNT] = {
+        program_create(""),
+        program_create(""),
+        program_create("#define TABLE\n"),
+        program_create("#define TABLE\n#define INSTANCED\n"),
+    };
+
+    double *submit_ms = malloc(frames * sizeof(double)), *frame_ms = malloc(frames * sizeof(double));
+    unsigned char *pixels[MODE_COUNT];
+    printf("{\n");
+    printf("  \"mesh\": \"%s\", \"usemtl_runs\": %d, \"materials\": %u, \"copies\": %d, \"frames\": %d,\n", path,
+           raw.group_count, h->material_count, copies, frames);
+    printf("  \"modes\": [\n");
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        GLuint program = programs[mode];
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection_view"), 1, GL_FALSE,
+                           &projection_view.Elements[0][0]);
+        GLint model_location = glGetUniformLocation(program, "model");
+        GLint diffuse_location = glGetUniformLocation(program, "diffuse");
+        glBindVertexArray(mode == MODE_PER_USEMTL ? raw_vao : vao);
+        int draws = 0;
+        // one frame first to warm up the driver
+        for (int f = -1; f < frames; f++) {
+            double start = headless_now_ms();
+            glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            draws = 0;
+            if (mode == MODE_TABLE_INSTANCED) {
+                glDrawElementsInstanced(GL_TRIANGLES, full_count, GL_UNSIGNED_INT, (void *)0, copies);
+                draws++;
+            }
+            for (int i = 0; mode != MODE_TABLE_INSTANCED && i < copies; i++) {
+                glUniform4fv(model_location, 3, &models[i].Elements[0][0]);
+                if (mode == MODE_PER_USEMTL) {
+                    for (int g = 0; g < raw.group_count; g++, draws++) {
+                        glUniform4fv(diffuse_location, 1, raw_colors[g]);
+                        glDrawElements(GL_TRIANGLES, raw.groups[g].index_count, GL_UNSIGNED_INT,
+                                       (void *)(raw.groups[g].index_offset * sizeof(unsigned int)));
+                    }
+                } else if (mode == MODE_PER_MATERIAL) {
+                    for (uint32_t s = 0; s < h->submesh_count; s++, draws++) {
+                        const mesh_material *material = &mesh.materials[mesh.submeshes[s].material_index];
+                        float color[4] = {material->diffuse[0], material->diffuse[1], material->diffuse[2],
+                                          material->opacity};
+                        glUniform4fv(diffuse_location, 1, color);
+                        glDrawElements(GL_TRIANGLES, mesh.submeshes[s].index_count, GL_UNSIGNED_INT,
+                                       (void *)(mesh.submeshes[s].index_offset * sizeof(uint32_t)));
+                    }
+                } else {
+                    glDrawElements(GL_TRIANGLES, full_count, GL_UNSIGNED_INT, (void *)0);
+                    draws++;
+                }
+            }
+            double submitted = headless_now_ms();
+            glFinish();
+            if (f >= 0) {
+                submit_ms[f] = submitted - start;
+                frame_ms[f] = headless_now_ms() - start;
+            }
+        }
+        pixels[mode] = malloc(WIDTH * HEIGHT * 4);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels[mode]);
+        int changed = 0;
+        for (int p = 0; p < WIDTH * HEIGHT * 4; p += 4) {
+            changed += memcmp(pixels[mode] + p, pixels[0] + p, 4) != 0;
+        }
+        qsort(submit_ms, frames, sizeof(double), headless_compare_double);
+        qsort(frame_ms, frames, sizeof(double), headless_compare_double);
+        printf("    {\"name\": \"%s\", \"draws\": %d, \"submit_ms_median\": %.2f, \"frame_ms_min\": %.2f, \"frame_ms_median\": %.2f, \"pixels_changed\": %.5f}%s\n",
+               mode_names[mode], draws, submit_ms[frames / 2], frame_ms[0], frame_ms[frames / 2],
+               (double)changed / (WIDTH * HEIGHT), mode + 1 < MODE_COUNT ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        free(pixels[mode]);
+    }
+    free(submit_ms);
+    free(frame_ms);
+    free(models);
+    free(raw_colors);
+    obj_free_mtl(&lib);
+    obj_free(&raw);
+    mesh_close(&mesh);
+    headless_context_destroy();
+    return 0;
+}
@@ -0,0 +1,903 @@
+// handmade_math.h benchmarks.
+//
+// Times handmade_math.h's batch and SIMD paths against what callers wrote
+// before, and checks both produce the same numbers:
+//   - batch point/direction transforms against per-vertex HMM_MultiplyMat4ByVec4
+//   - HMM_MultiplyMat4 against the old transposing SSE version, plus the batch multiply
+//   - the mat4 inverses against a double precision reference
+//   - HMM_TransformsToMat4 against HMM_Translate * HMM_QuaternionToMat4 * HMM_Scale
+//   - hmm_mat3x4 compose/inverse/transform against the same transforms as hmm_mat4
+//   - the polynomial sin/cos against libm
+//   - SoA nlerp/slerp and quaternion to instance matrices against the one at a time calls
+//   - cull.h frustum culling against a one object at a time loop
+//
+// usage: ./math_bench [count]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define CULL_IMPLEMENTATION
+#include "cull.h"
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+float randf(void)
+{
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// keeps the optimizer from dropping work whose result we never look at
+volatile float sink;
+
+float max_error(const float *a, const float *b, int count)
+{
+    float worst = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float d = HMM_ABS(a[i] - b[i]);
+        if (d > worst) {
+            worst = d;
+        }
+    }
+    return worst;
+}
+
+const char *simd_name(void)
+{
+#if defined(HANDMADE_MATH__USE_AVX) && defined(HANDMADE_MATH__USE_FMA)
+    return "avx+fma";
+#elif defined(HANDMADE_MATH__USE_AVX)
+    return "avx";
+#elif defined(HANDMADE_MATH__USE_SSE)
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
+
+hmm_mat4 random_mat4(void)
+{
+    hmm_mat4 m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            m.Elements[c][r] = randf();
+        }
+    }
+    return m;
+}
+
+// plain column-major reference, independent of whatever path the header picked
+hmm_mat4 reference_multiply(hmm_mat4 a, hmm_mat4 b)
+{
+    hmm_mat4 m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a.Elements[k][r] * b.Elements[c][k];
+            }
+            m.Elements[c][r] = sum;
+        }
+    }
+    return m;
+}
+
+#ifdef HANDMADE_MATH__USE_SSE
+// the SSE multiply before it stopped transposing, kept to compare against
+hmm_mat4 transposing_multiply(hmm_mat4 Left, hmm_mat4 Right)
+{
+    hmm_mat4 Result;
+    hmm_mat4 TransposedLeft = HMM_Transpose(Left);
+    hmm_mat4 TransposedRight = HMM_Transpose(Right);
+    Result.Rows[0] = HMM_LinearCombineSSE(TransposedLeft.Rows[0], TransposedRight);
+    Result.Rows[1] = HMM_LinearCombineSSE(TransposedLeft.Rows[1], TransposedRight);
+    Result.Rows[2] = HMM_LinearCombineSSE(TransposedLeft.Rows[2], TransposedRight);
+    Result.Rows[3] = HMM_LinearCombineSSE(TransposedLeft.Rows[3], TransposedRight);
+    return HMM_Transpose(Result);
+}
+#endif
+
+// count is kept small enough to stay in cache, past that both paths just
+// stream 128 bytes per product and time the memory bus instead
+int bench_multiply(int count)
+{
+    int reps = 1000;
+    int failed = 0;
+
+    hmm_mat4 vp = random_mat4();
+    hmm_mat4 *models = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *out = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *batch = malloc(count * sizeof(hmm_mat4));
+    for (int i = 0; i < count; i++) {
+        models[i] = random_mat4();
+    }
+    // fault the outputs in up front so the first timed loop doesn't pay for it
+    memset(out, 0, count * sizeof(hmm_mat4));
+    memset(batch, 0, count * sizeof(hmm_mat4));
+
+    double start;
+#ifdef HANDMADE_MATH__USE_SSE
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            out[i] = transposing_multiply(vp, models[i]);
+        }
+        sink = out[r % count].Elements[0][0];
+    }
+    double transposing_ns = (now_ns() - start) / reps / count;
+    printf("multiply mat4 transposing: %6.2f ns/op\n", transposing_ns);
+#endif
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            out[i] = HMM_MultiplyMat4(vp, models[i]);
+        }
+        sink = out[r % count].Elements[0][0];
+    }
+    double multiply_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_MultiplyMat4Batch(vp, models, batch, count);
+        sink = batch[r % count].Elements[0][0];
+    }
+    double batch_ns = (now_ns() - start) / reps / count;
+
+    float err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        hmm_mat4 ref = reference_multiply(vp, models[i]);
+        err = HMM_MAX(err, max_error(&ref.Elements[0][0], &out[i].Elements[0][0], 16));
+        err = HMM_MAX(err, max_error(&ref.Elements[0][0], &batch[i].Elements[0][0], 16));
+    }
+
+    printf("multiply mat4:             %6.2f ns/op\n", multiply_ns);
+    printf("multiply mat4 batch:       %6.2f ns/op (%.1fx) max err %g\n", batch_ns, multiply_ns / batch_ns, err);
+    if (err > 1e-5f) {
+        printf("FAILED: mat4 products differ from the reference\n");
+        failed = 1;
+    }
+
+    free(models); free(out); free(batch);
+    return failed;
+}
+
+// Gauss-Jordan in double, the reference the float inverses are measured against
+hmm_mat4 reference_inverse(hmm_mat4 m)
+{
+    double a[4][8];
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            a[r][c] = m.Elements[c][r];
+            a[r][c + 4] = r == c;
+        }
+    }
+    for (int c = 0; c < 4; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < 4; r++) {
+            if (fabs(a[r][c]) > fabs(a[pivot][c])) {
+                pivot = r;
+            }
+        }
+        for (int k = 0; k < 8; k++) {
+            double t = a[c][k]; a[c][k] = a[pivot][k]; a[pivot][k] = t;
+        }
+        double inv = 1.0 / a[c][c];
+        for (int k = 0; k < 8; k++) {
+            a[c][k] *= inv;
+        }
+        for (int r = 0; r < 4; r++) {
+            if (r != c) {
+                double f = a[r][c];
+                for (int k = 0; k < 8; k++) {
+                    a[r][k] -= f * a[c][k];
+                }
+            }
+        }
+    }
+    hmm_mat4 result;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            result.Elements[c][r] = (float)a[r][c + 4];
+        }
+    }
+    return result;
+}
+
+hmm_mat4 random_trs(int scaled)
+{
+    hmm_vec3 axis = HMM_Vec3(randf(), randf(), randf() + 1.5f);
+    hmm_vec3 scale = scaled ? HMM_Vec3(1.5f + randf(), 1.5f + randf(), 1.5f + randf()) : HMM_Vec3(1.0f, 1.0f, 1.0f);
+    hmm_mat4 m = HMM_MultiplyMat4(HMM_Rotate(randf() * 180.0f, axis), HMM_Scale(scale));
+    return HMM_MultiplyMat4(HMM_Translate(HMM_Vec3(randf() * 10.0f, randf() * 10.0f, randf() * 10.0f)), m);
+}
+
+// a macro rather than a function pointer so the inverse still gets inlined into the loop
+#define TIME_INVERSE(ns, f, in, out, count, reps)                \
+    do {                                                         \
+        double start_ = now_ns();                                \
+        for (int r_ = 0; r_ < (reps); r_++) {                    \
+            for (int i_ = 0; i_ < (count); i_++) {               \
+                (out)[i_] = f((in)[i_]);                         \
+            }                                                    \
+            sink = (out)[r_ % (count)].Elements[0][0];           \
+        }                                                        \
+        ns = (now_ns() - start_) / (reps) / (count);             \
+    } while (0)
+
+// worst element error against the double reference and of M * inverse against identity
+float check_inverse(const char *name, double ns, hmm_mat4 *in, hmm_mat4 *out, int count)
+{
+    float err = 0.0f, residual = 0.0f;
+    for (int i = 0; i < count; i++) {
+        hmm_mat4 ref = reference_inverse(in[i]);
+        err = HMM_MAX(err, max_error(&ref.Elements[0][0], &out[i].Elements[0][0], 16));
+        hmm_mat4 identity = HMM_Mat4d(1.0f);
+        hmm_mat4 product = HMM_MultiplyMat4(in[i], out[i]);
+        residual = HMM_MAX(residual, max_error(&identity.Elements[0][0], &product.Elements[0][0], 16));
+    }
+    printf("%-26s %6.2f ns/op max err %g, |M*inv - I| %g\n", name, ns, err, residual);
+    return HMM_MAX(err, residual);
+}
+
+int bench_inverse(int count)
+{
+    int reps = 1000;
+    int failed = 0;
+
+    hmm_mat4 *general = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *affine = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *rigid = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *out = malloc(count * sizeof(hmm_mat4));
+    for (int i = 0; i < count; i++) {
+        // a projection * view style matrix, dominant diagonal keeps it well conditioned
+        general[i] = random_mat4();
+        for (int k = 0; k < 4; k++) {
+            general[i].Elements[k][k] += 4.0f;
+        }
+        affine[i] = random_trs(1);
+        rigid[i] = random_trs(0);
+    }
+    memset(out, 0, count * sizeof(hmm_mat4));
+
+    double ns;
+    TIME_INVERSE(ns, HMM_InverseMat4, general, out, count, reps);
+    failed |= check_inverse("inverse general", ns, general, out, count) > 1e-4f;
+    TIME_INVERSE(ns, HMM_InverseMat4, affine, out, count, reps);
+    failed |= check_inverse("inverse general on trs", ns, affine, out, count) > 1e-4f;
+    TIME_INVERSE(ns, HMM_InverseAffineMat4, affine, out, count, reps);
+    failed |= check_inverse("inverse affine on trs", ns, affine, out, count) > 1e-4f;
+    TIME_INVERSE(ns, HMM_InverseRigidMat4, rigid, out, count, reps);
+    failed |= check_inverse("inverse rigid on rt", ns, rigid, out, count) > 1e-4f;
+    if (failed) {
+        printf("FAILED: inverses differ from the reference\n");
+    }
+
+    free(general); free(affine); free(rigid); free(out);
+    return failed;
+}
+
+hmm_transform random_transform(void)
+{
+    hmm_quaternion rotation = HMM_QuaternionFromAxisAngle(HMM_Vec3(randf(), randf(), randf() + 1.5f), randf() * 3.0f);
+    return HMM_Transform(HMM_Vec3(randf() * 10.0f, randf() * 10.0f, randf() * 10.0f), rotation,
+                         HMM_Vec3(1.5f + randf(), 1.5f + randf(), 1.5f + randf()));
+}
+
+int bench_trs(int count)
+{
+    int reps = 1000;
+    int failed = 0;
+
+    hmm_transform *transforms = malloc(count * sizeof(hmm_transform));
+    int *parents = malloc(count * sizeof(int));
+    hmm_mat4 *chain = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *batch = malloc(count * sizeof(hmm_mat4));
+    for (int i = 0; i < count; i++) {
+        transforms[i] = random_transform();
+        // short chains, every fourth node is a root
+        parents[i] = i % 4 ? i - 1 : -1;
+    }
+    memset(chain, 0, count * sizeof(hmm_mat4));
+    memset(batch, 0, count * sizeof(hmm_mat4));
+
+    // what building a model matrix looked like before
+    double start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            hmm_transform *t = &transforms[i];
+            chain[i] = HMM_MultiplyMat4(HMM_Translate(t->Translation),
+                                        HMM_MultiplyMat4(HMM_QuaternionToMat4(t->Rotation), HMM_Scale(t->Scale)));
+        }
+        sink = chain[r % count].Elements[0][0];
+    }
+    double chain_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_TransformsToMat4(transforms, NULL, batch, count);
+        sink = batch[r % count].Elements[0][0];
+    }
+    double batch_ns = (now_ns() - start) / reps / count;
+
+    float err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        err = HMM_MAX(err, max_error(&chain[i].Elements[0][0], &batch[i].Elements[0][0], 16));
+    }
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_TransformsToMat4(transforms, parents, batch, count);
+        sink = batch[r % count].Elements[0][0];
+    }
+    double parents_ns = (now_ns() - start) / reps / count;
+
+    for (int i = 0; i < count; i++) {
+        if (parents[i] >= 0) {
+            chain[i] = HMM_MultiplyMat4(chain[parents[i]], chain[i]);
+        }
+        // children sit up to four levels deep with scales up to 2.5, compare relative to magnitude
+        float scale = 1.0f;
+        for (int k = 0; k < 16; k++) {
+            scale = HMM_MAX(scale, HMM_ABS((&chain[i].Elements[0][0])[k]));
+        }
+        err = HMM_MAX(err, max_error(&chain[i].Elements[0][0], &batch[i].Elements[0][0], 16) / scale);
+    }
+
+    printf("trs translate*rotate*scale: %6.2f ns/op\n", chain_ns);
+    printf("trs batch:                  %6.2f ns/op (%.1fx)\n", batch_ns, chain_ns / batch_ns);
+    printf("trs batch with parents:     %6.2f ns/op max err %g\n", parents_ns, err);
+    if (err > 1e-5f) {
+        printf("FAILED: TRS matrices differ from the HMM_Translate/Rotate/Scale chain\n");
+        failed = 1;
+    }
+
+    free(transforms); free(parents); free(chain); free(batch);
+    return failed;
+}
+
+// same transforms as mat4 and as mat3x4, the instance data the renderers upload
+int bench_mat3x4(int count)
+{
+    int reps = 1000;
+    int failed = 0;
+
+    hmm_transform *transforms = malloc(count * sizeof(hmm_transform));
+    hmm_mat4 *full = malloc(count * sizeof(hmm_mat4));
+    hmm_mat4 *full_out = malloc(count * sizeof(hmm_mat4));
+    hmm_mat3x4 *affine = malloc(count * sizeof(hmm_mat3x4));
+    hmm_mat3x4 *affine_out = malloc(count * sizeof(hmm_mat3x4));
+    for (int i = 0; i < count; i++) {
+        transforms[i] = random_transform();
+    }
+    memset(full, 0, count * sizeof(hmm_mat4));
+    memset(full_out, 0, count * sizeof(hmm_mat4));
+    memset(affine, 0, count * sizeof(hmm_mat3x4));
+    memset(affine_out, 0, count * sizeof(hmm_mat3x4));
+
+    double start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            full[i] = HMM_TransformToMat4(transforms[i]);
+        }
+        sink = full[r % count].Elements[0][0];
+    }
+    double trs_full_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            affine[i] = HMM_TransformToMat3x4(transforms[i]);
+        }
+        sink = affine[r % count].Elements[0][0];
+    }
+    double trs_affine_ns = (now_ns() - start) / reps / count;
+
+    // parent * child, what a scene graph does per node
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            full_out[i] = HMM_MultiplyMat4(full[i], full[count - 1 - i]);
+        }
+        sink = full_out[r % count].Elements[0][0];
+    }
+    double multiply_full_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            affine_out[i] = HMM_MultiplyMat3x4(affine[i], affine[count - 1 - i]);
+        }
+        sink = affine_out[r % count].Elements[0][0];
+    }
+    double multiply_affine_ns = (now_ns() - start) / reps / count;
+
+    float err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        hmm_mat4 expand = HMM_Mat3x4ToMat4(affine_out[i]);
+        err = HMM_MAX(err, max_error(&expand.Elements[0][0], &full_out[i].Elements[0][0], 16));
+        expand = HMM_Mat3x4ToMat4(HMM_Mat3x4FromMat4(full[i]));
+        err = HMM_MAX(err, max_error(&expand.Elements[0][0], &full[i].Elements[0][0], 16));
+    }
+    err /= 100.0f; // products of two scaled transforms with translations up to 10
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            full_out[i] = HMM_InverseAffineMat4(full[i]);
+        }
+        sink = full_out[r % count].Elements[0][0];
+    }
+    double inverse_full_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            affine_out[i] = HMM_InverseMat3x4(affine[i]);
+        }
+        sink = affine_out[r % count].Elements[0][0];
+    }
+    double inverse_affine_ns = (now_ns() - start) / reps / count;
+
+    float inverse_err = 0.0f, point_err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        hmm_mat4 expand = HMM_Mat3x4ToMat4(affine_out[i]);
+        inverse_err = HMM_MAX(inverse_err, max_error(&expand.Elements[0][0], &full_out[i].Elements[0][0], 16));
+
+        hmm_vec3 p = HMM_Vec3(randf(), randf(), randf());
+        hmm_vec4 expect = HMM_MultiplyMat4ByVec4(full[i], HMM_Vec4(p.X, p.Y, p.Z, 1.0f));
+        hmm_vec3 got = HMM_MultiplyMat3x4ByPoint(affine[i], p);
+        point_err = HMM_MAX(point_err, max_error(got.Elements, expect.Elements, 3));
+        expect = HMM_MultiplyMat4ByVec4(full[i], HMM_Vec4(p.X, p.Y, p.Z, 0.0f));
+        got = HMM_MultiplyMat3x4ByVector(affine[i], p);
+        point_err = HMM_MAX(point_err, max_error(got.Elements, expect.Elements, 3));
+    }
+
+    printf("trs to mat4:                %6.2f ns/op, mat3x4 %6.2f ns/op\n", trs_full_ns, trs_affine_ns);
+    printf("multiply mat4:              %6.2f ns/op, mat3x4 %6.2f ns/op (%.1fx) max err %g\n",
+           multiply_full_ns, multiply_affine_ns, multiply_full_ns / multiply_affine_ns, err);
+    printf("inverse affine mat4:        %6.2f ns/op, mat3x4 %6.2f ns/op (%.1fx) max err %g\n",
+           inverse_full_ns, inverse_affine_ns, inverse_full_ns / inverse_affine_ns, inverse_err);
+    printf("mat3x4 point/vector:        max err %g\n", point_err);
+    if (err > 1e-6f || inverse_err > 1e-5f || point_err > 1e-5f) {
+        printf("FAILED: mat3x4 results differ from the mat4 ones\n");
+        failed = 1;
+    }
+
+    free(transforms); free(full); free(full_out); free(affine); free(affine_out);
+    return failed;
+}
+
+// max abs error of HMM_SinCos against double precision over [-range, range]
+float sincos_error(float range, int count, float *angles, float *sn, float *cs)
+{
+    for (int i = 0; i < count; i++) {
+        angles[i] = randf() * range;
+    }
+    HMM_SinCos(angles, sn, cs, count);
+    float err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        err = HMM_MAX(err, (float)fabs(sin((double)angles[i]) - sn[i]));
+        err = HMM_MAX(err, (float)fabs(cos((double)angles[i]) - cs[i]));
+        float s1, c1;
+        HMM_SinCosF(angles[i], &s1, &c1);
+        err = HMM_MAX(err, (float)fabs(sin((double)angles[i]) - s1));
+        err = HMM_MAX(err, (float)fabs(cos((double)angles[i]) - c1));
+    }
+    return err;
+}
+
+int bench_sincos(int count)
+{
+    int reps = 100;
+    int failed = 0;
+
+    float *angles = malloc(count * sizeof(float));
+    float *sn = malloc(count * sizeof(float));
+    float *cs = malloc(count * sizeof(float));
+    hmm_quaternion *quats = malloc(count * sizeof(hmm_quaternion));
+    for (int i = 0; i < count; i++) {
+        angles[i] = randf() * 10.0f;
+    }
+    memset(sn, 0, count * sizeof(float));
+    memset(cs, 0, count * sizeof(float));
+    memset(quats, 0, count * sizeof(hmm_quaternion));
+
+    double start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            sn[i] = HMM_SinF(angles[i]);
+            cs[i] = HMM_CosF(angles[i]);
+        }
+        sink = sn[r % count];
+    }
+    double libm_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            HMM_SinCosF(angles[i], &sn[i], &cs[i]);
+        }
+        sink = sn[r % count];
+    }
+    double scalar_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_SinCos(angles, sn, cs, count);
+        sink = sn[r % count];
+    }
+    double batch_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            quats[i] = HMM_QuaternionFromAxisAngle(HMM_Vec3(1.0f, 0.3f, 0.5f), angles[i]);
+        }
+        sink = quats[r % count].W;
+    }
+    double quat_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_QuaternionsFromAxisAngle(HMM_Vec3(1.0f, 0.3f, 0.5f), angles, quats, count);
+        sink = quats[r % count].W;
+    }
+    double quat_batch_ns = (now_ns() - start) / reps / count;
+
+    float err_pi = sincos_error(HMM_PI32, count, angles, sn, cs);
+    float err_8k = sincos_error(8192.0f, count, angles, sn, cs);
+
+    printf("sin+cos libm:              %6.2f ns/op\n", libm_ns);
+    printf("sincos scalar polynomial:  %6.2f ns/op\n", scalar_ns);
+    printf("sincos batch:              %6.2f ns/op (%.1fx) max err %g in [-pi, pi], %g in [-8192, 8192]\n",
+           batch_ns, libm_ns / batch_ns, err_pi, err_8k);
+    printf("quaternion from axis angle %6.2f ns/op, batch %6.2f ns/op (%.1fx)\n",
+           quat_ns, quat_batch_ns, quat_ns / quat_batch_ns);
+    if (err_pi > 1e-7f || err_8k > 1e-7f) {
+        printf("FAILED: sin/cos error above the documented bound\n");
+        failed = 1;
+    }
+
+    free(angles); free(sn); free(cs); free(quats);
+    return failed;
+}
+
+// shortest arc slerp in double precision
+void reference_slerp(const double *a, const double *b_in, double t, double *out)
+{
+    double b[4], dot = 0.0;
+    for (int k = 0; k < 4; k++) {
+        dot += a[k] * b_in[k];
+    }
+    double sign = dot < 0.0 ? -1.0 : 1.0;
+    dot *= sign;
+    for (int k = 0; k < 4; k++) {
+        b[k] = b_in[k] * sign;
+    }
+    double wa = 1.0 - t, wb = t;
+    if (dot < 1.0 - 1e-12) {
+        double angle = acos(dot);
+        wa = sin((1.0 - t) * angle) / sin(angle);
+        wb = sin(t * angle) / sin(angle);
+    }
+    for (int k = 0; k < 4; k++) {
+        out[k] = wa * a[k] + wb * b[k];
+    }
+}
+
+int bench_quat(int count)
+{
+    int reps = 100;
+    int failed = 0;
+
+    // one float array per component, 4 for each side plus the results
+    float *data = malloc(13 * count * sizeof(float));
+    hmm_quaternion_soa a = {data, data + count, data + 2*count, data + 3*count};
+    hmm_quaternion_soa b = {data + 4*count, data + 5*count, data + 6*count, data + 7*count};
+    hmm_quaternion_soa out = {data + 8*count, data + 9*count, data + 10*count, data + 11*count};
+    float *t = data + 12*count;
+    hmm_quaternion *qa = malloc(count * sizeof(hmm_quaternion));
+    hmm_quaternion *qb = malloc(count * sizeof(hmm_quaternion));
+    hmm_quaternion *qout = malloc(count * sizeof(hmm_quaternion));
+    // instance layout of a model matrix plus a colour
+    int stride = 20 * sizeof(float);
+    float *instances = malloc(count * stride);
+    hmm_mat4 *matrices = malloc(count * sizeof(hmm_mat4));
+    for (int i = 0; i < count; i++) {
+        qa[i] = HMM_QuaternionFromAxisAngle(HMM_Vec3(randf(), randf(), randf() + 1.5f), randf() * 3.0f);
+        // a mix of nearby keys (animation) and anything goes, including the long way round
+        float spread = i % 2 ? 0.2f : 3.0f;
+        qb[i] = HMM_MultiplyQuaternion(qa[i], HMM_QuaternionFromAxisAngle(HMM_Vec3(randf(), randf() + 1.5f, randf()),
+                                                                          randf() * spread));
+        if (i % 3 == 0) {
+            qb[i] = HMM_MultiplyQuaternionF(qb[i], -1.0f);
+        }
+        t[i] = (randf() + 1.0f) * 0.5f;
+        a.X[i] = qa[i].X; a.Y[i] = qa[i].Y; a.Z[i] = qa[i].Z; a.W[i] = qa[i].W;
+        b.X[i] = qb[i].X; b.Y[i] = qb[i].Y; b.Z[i] = qb[i].Z; b.W[i] = qb[i].W;
+    }
+    memset(out.X, 0, 4 * count * sizeof(float));
+    memset(qout, 0, count * sizeof(hmm_quaternion));
+    memset(instances, 0, count * stride);
+    memset(matrices, 0, count * sizeof(hmm_mat4));
+
+    // the AoS calls do the long way round on a third of these, only the timing is comparable
+    double start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            qout[i] = HMM_NLerp(qa[i], t[i], qb[i]);
+        }
+        sink = qout[r % count].W;
+    }
+    double nlerp_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            qout[i] = HMM_Slerp(qa[i], t[i], qb[i]);
+        }
+        sink = qout[r % count].W;
+    }
+    double slerp_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_NLerpSoA(a, t, b, out, count);
+        sink = out.W[r % count];
+    }
+    double nlerp_soa_ns = (now_ns() - start) / reps / count;
+
+    float nlerp_err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        double qd[4] = {a.X[i], a.Y[i], a.Z[i], a.W[i]}, rd[4] = {b.X[i], b.Y[i], b.Z[i], b.W[i]};
+        double sign = qd[0]*rd[0] + qd[1]*rd[1] + qd[2]*rd[2] + qd[3]*rd[3] < 0.0 ? -1.0 : 1.0;
+        double lerp[4], length = 0.0;
+        for (int k = 0; k < 4; k++) {
+            lerp[k] = (1.0 - t[i]) * qd[k] + t[i] * sign * rd[k];
+            length += lerp[k] * lerp[k];
+        }
+        float got[4] = {out.X[i], out.Y[i], out.Z[i], out.W[i]};
+        for (int k = 0; k < 4; k++) {
+            nlerp_err = HMM_MAX(nlerp_err, (float)fabs(lerp[k] / sqrt(length) - got[k]));
+        }
+    }
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_SlerpSoA(a, t, b, out, count);
+        sink = out.W[r % count];
+    }
+    double slerp_soa_ns = (now_ns() - start) / reps / count;
+
+    // the odd ones are nearby keys, where the polynomial is tighter
+    float slerp_err = 0.0f, slerp_near_err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        double qd[4] = {a.X[i], a.Y[i], a.Z[i], a.W[i]}, rd[4] = {b.X[i], b.Y[i], b.Z[i], b.W[i]};
+        double expect[4];
+        reference_slerp(qd, rd, t[i], expect);
+        float got[4] = {out.X[i], out.Y[i], out.Z[i], out.W[i]};
+        for (int k = 0; k < 4; k++) {
+            slerp_err = HMM_MAX(slerp_err, (float)fabs(expect[k] - got[k]));
+            if (i % 2) {
+                slerp_near_err = HMM_MAX(slerp_near_err, (float)fabs(expect[k] - got[k]));
+            }
+        }
+    }
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            matrices[i] = HMM_QuaternionToMat4(qa[i]);
+        }
+        sink = matrices[r % count].Elements[0][0];
+    }
+    double matrix_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_QuaternionsToMat4SoA(a, instances, stride, count);
+        sink = instances[r % count];
+    }
+    double matrix_soa_ns = (now_ns() - start) / reps / count;
+
+    float matrix_err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        matrix_err = HMM_MAX(matrix_err, max_error(&matrices[i].Elements[0][0], instances + i * 20, 16));
+    }
+
+    printf("nlerp:                     %6.2f ns/op\n", nlerp_ns);
+    printf("nlerp soa:                 %6.2f ns/op (%.1fx) max err %g\n", nlerp_soa_ns, nlerp_ns / nlerp_soa_ns, nlerp_err);
+    printf("slerp:                     %6.2f ns/op\n", slerp_ns);
+    printf("slerp soa:                 %6.2f ns/op (%.1fx) max err %g, %g for nearby keys\n",
+           slerp_soa_ns, slerp_ns / slerp_soa_ns, slerp_err, slerp_near_err);
+    printf("quaternion to mat4:        %6.2f ns/op\n", matrix_ns);
+    printf("quaternions to instances:  %6.2f ns/op (%.1fx) max err %g\n", matrix_soa_ns, matrix_ns / matrix_soa_ns, matrix_err);
+    if (nlerp_err > 1e-6f || slerp_err > 3e-5f || slerp_near_err > 1e-6f || matrix_err > 1e-6f) {
+        printf("FAILED: batch quaternion results off by more than the documented bound\n");
+        failed = 1;
+    }
+
+    free(data); free(qa); free(qb); free(qout); free(instances); free(matrices);
+    return failed;
+}
+
+// one object at a time, the obvious loop the SIMD culling replaces
+int reference_cull_spheres(const cull_frustum *f, const float *x, const float *y, const float *z,
+                           const float *radius, int count, int *visible)
+{
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        int inside = 1;
+        for (int p = 0; p < 6 && inside; p++) {
+            inside = (x[i]*f->x[p] + y[i]*f->y[p]) + (z[i]*f->z[p] + f->d[p]) >= -radius[i];
+        }
+        if (inside) {
+            visible[n++] = i;
+        }
+    }
+    return n;
+}
+
+int bench_cull(int count)
+{
+    int reps = 100;
+    int failed = 0;
+
+    hmm_mat4 projection = HMM_Perspective(45.0f, 16.0f / 9.0f, 0.1f, 500.0f); // FOV in degrees
+    hmm_mat4 view = HMM_LookAt(HMM_Vec3(10.0f, 20.0f, 30.0f), HMM_Vec3(0.0f, 0.0f, 0.0f), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    cull_frustum frustum = cull_frustum_from_matrix(HMM_MultiplyMat4(projection, view));
+
+    float *x = malloc(count * sizeof(float)), *y = malloc(count * sizeof(float)), *z = malloc(count * sizeof(float));
+    float *r = malloc(count * sizeof(float));
+    int *visible = malloc(count * sizeof(int)), *expected = malloc(count * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        x[i] = randf() * 400.0f;
+        y[i] = randf() * 400.0f;
+        z[i] = randf() * 400.0f;
+        r[i] = 1.0f + randf() * 0.5f;
+    }
+    memset(visible, 0, count * sizeof(int));
+
+    double start = now_ns();
+    int expected_count = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        expected_count = reference_cull_spheres(&frustum, x, y, z, r, count, expected);
+    }
+    double scalar_ms = (now_ns() - start) / reps / 1e6;
+
+    start = now_ns();
+    int visible_count = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        visible_count = cull_spheres(&frustum, x, y, z, r, count, visible);
+    }
+    double sphere_ms = (now_ns() - start) / reps / 1e6;
+
+    int mismatch = visible_count != expected_count ||
+                   memcmp(visible, expected, visible_count * sizeof(int)) != 0;
+
+    // the boxes reuse the centers, with the radius as half extent the box test can only keep more
+    start = now_ns();
+    int box_count = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        box_count = cull_aabbs(&frustum, x, y, z, r, r, r, count, visible);
+    }
+    double box_ms = (now_ns() - start) / reps / 1e6;
+    mismatch |= box_count < expected_count;
+
+    printf("cull spheres scalar:   %7.0f tests/ms\n", count / scalar_ms);
+    printf("cull spheres:          %7.0f tests/ms (%.1fx), %d of %d visible\n",
+           count / sphere_ms, scalar_ms / sphere_ms, visible_count, count);
+    printf("cull aabbs:            %7.0f tests/ms, %d of %d visible\n", count / box_ms, box_count, count);
+    if (mismatch) {
+        printf("FAILED: culling results differ from the scalar reference\n");
+        failed = 1;
+    }
+
+    free(x); free(y); free(z); free(r); free(visible); free(expected);
+    return failed;
+}
+
+int bench_transform(int count)
+{
+    int reps = 10;
+    int failed = 0;
+
+    hmm_mat4 model = HMM_MultiplyMat4(HMM_Translate(HMM_Vec3(1.0f, -2.0f, 3.0f)),
+                                      HMM_MultiplyMat4(HMM_Rotate(33.0f, HMM_Vec3(1.0f, 0.3f, 0.5f)),
+                                                       HMM_Scale(HMM_Vec3(2.0f, 2.0f, 2.0f))));
+
+    hmm_vec3 *points = malloc(count * sizeof(hmm_vec3));
+    hmm_vec3 *scalar = malloc(count * sizeof(hmm_vec3));
+    hmm_vec3 *batch = malloc(count * sizeof(hmm_vec3));
+    float *x = malloc(count * sizeof(float)), *y = malloc(count * sizeof(float)), *z = malloc(count * sizeof(float));
+    float *ox = malloc(count * sizeof(float)), *oy = malloc(count * sizeof(float)), *oz = malloc(count * sizeof(float));
+    for (int i = 0; i < count; i++) {
+        points[i] = HMM_Vec3(randf() * 100.0f, randf() * 100.0f, randf() * 100.0f);
+        x[i] = points[i].X;
+        y[i] = points[i].Y;
+        z[i] = points[i].Z;
+    }
+
+    // scalar baseline, what callers had to write before
+    double start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < count; i++) {
+            scalar[i] = HMM_MultiplyMat4ByVec4(model, HMM_Vec4v(points[i], 1.0f)).XYZ;
+        }
+        sink = scalar[r % count].X;
+    }
+    double scalar_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_TransformPoints(model, points, batch, count);
+        sink = batch[r % count].X;
+    }
+    double aos_ns = (now_ns() - start) / reps / count;
+
+    start = now_ns();
+    for (int r = 0; r < reps; r++) {
+        HMM_TransformPointsSoA(model, x, y, z, ox, oy, oz, count);
+        sink = ox[r % count];
+    }
+    double soa_ns = (now_ns() - start) / reps / count;
+
+    float aos_err = max_error(&scalar[0].X, &batch[0].X, count * 3);
+    float soa_err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        hmm_vec3 v = HMM_Vec3(ox[i], oy[i], oz[i]);
+        soa_err = HMM_MAX(soa_err, max_error(scalar[i].Elements, v.Elements, 3));
+    }
+
+    printf("transform points scalar: %6.2f ns/vertex\n", scalar_ns);
+    printf("transform points aos:    %6.2f ns/vertex (%.1fx) max err %g\n", aos_ns, scalar_ns / aos_ns, aos_err);
+    printf("transform points soa:    %6.2f ns/vertex (%.1fx) max err %g\n", soa_ns, scalar_ns / soa_ns, soa_err);
+
+    // directions ignore translation
+    HMM_TransformDirections(model, points, batch, count);
+    float dir_err = 0.0f;
+    for (int i = 0; i < count; i++) {
+        hmm_vec3 v = HMM_MultiplyMat4ByVec4(model, HMM_Vec4v(points[i], 0.0f)).XYZ;
+        dir_err = HMM_MAX(dir_err, max_error(v.Elements, batch[i].Elements, 3));
+    }
+    printf("transform directions max err %g\n", dir_err);
+
+    if (aos_err > 1e-3f || soa_err > 1e-3f || dir_err > 1e-3f) {
+        printf("FAILED: batch results differ from the scalar path\n");
+        failed = 1;
+    }
+
+    free(points); free(scalar); free(batch);
+    free(x); free(y); free(z); free(ox); free(oy); free(oz);
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int failed = 0;
+
+    printf("simd: %s, count: %d\n", simd_name(), count);
+    failed |= bench_transform(count);
+    failed |= bench_multiply(count / 200 + 1);
+    failed |= bench_inverse(count / 200 + 1);
+    failed |= bench_trs(count / 200 + 1);
+    failed |= bench_mat3x4(count / 200 + 1);
+    failed |= bench_sincos(count / 100 + 1);
+    failed |= bench_quat(count / 100 + 1);
+    failed |= bench_cull(count / 10 + 1);
+    return failed;
+}
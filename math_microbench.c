@@ -0,0 +1,642 @@
+// handmade_math.h microbenchmarks.
+//
+// Times the per call cost of the hot handmade_math.h functions in ns/op and
+// checks every result against a double precision reference, so the SSE and
+// the scalar build are held to the same tolerance. Build it once per
+// configuration (see build.sh) and diff the JSON:
+//
+//   SSE on/off  -DHANDMADE_MATH_NO_SSE
+//   inline off  -DHANDMADE_MATH_NO_INLINE -fno-inline, every HMM_ call is a real call
+//
+// Each function runs over POOL cache resident inputs, `reps` times per run,
+// and the best of RUNS runs is reported. Exits nonzero if a result is out of
+// tolerance.
+//
+// usage: ./math_microbench [reps]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define POOL 256
+#define RUNS 5
+
+typedef struct {
+    const char *name;
+    double ns;
+    double error;     // worst element error against the reference, relative above magnitude 1
+    double tolerance;
+} Result;
+
+Result results[64];
+int result_count = 0;
+int reps = 1000;
+
+// inputs
+hmm_mat4 mat_a[POOL], mat_b[POOL], trs[POOL];
+hmm_vec4 vec4_a[POOL];
+hmm_vec3 vec3_a[POOL], vec3_b[POOL], vec3_c[POOL];
+hmm_quaternion quat_a[POOL], quat_b[POOL];
+hmm_transform transforms[POOL];
+float scalar_a[POOL], scalar_b[POOL], angles[POOL], times[POOL];
+
+// outputs
+hmm_mat4 out_mat[POOL];
+hmm_vec4 out_vec4[POOL];
+hmm_vec3 out_vec3[POOL];
+hmm_quaternion out_quat[POOL];
+float out_float[POOL], out_float_b[POOL];
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+float randf(void)
+{
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// the outputs are rewritten with the same values every rep, the barrier keeps the
+// compiler from noticing and running the loop once
+#if defined(__GNUC__)
+#define BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+volatile int barrier_sink;
+#define BARRIER() (barrier_sink = 0)
+#endif
+
+// times `statement` for i in [0, POOL), a macro so the call can still be inlined
+#define TIME(name_, tolerance_, statement)                                 \
+    do {                                                                   \
+        Result *r_ = &results[result_count++];                             \
+        r_->name = name_;                                                  \
+        r_->tolerance = tolerance_;                                        \
+        r_->ns = 1e30;                                                     \
+        for (int run_ = 0; run_ < RUNS; run_++) {                          \
+            double start_ = now_ns();                                      \
+            for (int rep_ = 0; rep_ < reps; rep_++) {                      \
+                for (int i = 0; i < POOL; i++) {                           \
+                    statement;                                             \
+                }                                                          \
+                BARRIER();                                                 \
+            }                                                              \
+            double ns_ = (now_ns() - start_) / ((double)reps * POOL);      \
+            r_->ns = ns_ < r_->ns ? ns_ : r_->ns;                          \
+        }                                                                  \
+        r_->error = 0.0;                                                   \
+    } while (0)
+
+void check(const float *got, const double *expect, int count)
+{
+    Result *r = &results[result_count - 1];
+    for (int k = 0; k < count; k++) {
+        double magnitude = fabs(expect[k]) > 1.0 ? fabs(expect[k]) : 1.0;
+        double e = fabs(got[k] - expect[k]) / magnitude;
+        r->error = e > r->error ? e : r->error;
+    }
+}
+
+void check_mat(const hmm_mat4 *got, const double *expect)
+{
+    check(&got->Elements[0][0], expect, 16);
+}
+
+// double precision references, column-major like hmm_mat4, written from the
+// definitions rather than the header so both builds are measured against the same thing
+
+void identity(double *m)
+{
+    for (int k = 0; k < 16; k++) {
+        m[k] = k % 5 == 0;
+    }
+}
+
+void ref_multiply(const hmm_mat4 *a, const hmm_mat4 *b, double *m)
+{
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            double sum = 0.0;
+            for (int k = 0; k < 4; k++) {
+                sum += (double)a->Elements[k][r] * b->Elements[c][k];
+            }
+            m[c*4 + r] = sum;
+        }
+    }
+}
+
+void ref_inverse(const hmm_mat4 *in, double *m)
+{
+    double a[4][8];
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            a[r][c] = in->Elements[c][r];
+            a[r][c + 4] = r == c;
+        }
+    }
+    for (int c = 0; c < 4; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < 4; r++) {
+            if (fabs(a[r][c]) > fabs(a[pivot][c])) {
+                pivot = r;
+            }
+        }
+        for (int k = 0; k < 8; k++) {
+            double t = a[c][k]; a[c][k] = a[pivot][k]; a[pivot][k] = t;
+        }
+        double inv = 1.0 / a[c][c];
+        for (int k = 0; k < 8; k++) {
+            a[c][k] *= inv;
+        }
+        for (int r = 0; r < 4; r++) {
+            if (r != c) {
+                double f = a[r][c];
+                for (int k = 0; k < 8; k++) {
+                    a[r][k] -= f * a[c][k];
+                }
+            }
+        }
+    }
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            m[c*4 + r] = a[r][c + 4];
+        }
+    }
+}
+
+void normalize3(double *v)
+{
+    double length = sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    v[0] /= length; v[1] /= length; v[2] /= length;
+}
+
+void cross3(const double *a, const double *b, double *out)
+{
+    out[0] = a[1]*b[2] - a[2]*b[1];
+    out[1] = a[2]*b[0] - a[0]*b[2];
+    out[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+void ref_look_at(hmm_vec3 eye, hmm_vec3 center, hmm_vec3 up, double *m)
+{
+    double e[3] = {eye.X, eye.Y, eye.Z}, u0[3] = {up.X, up.Y, up.Z};
+    double f[3] = {(double)center.X - eye.X, (double)center.Y - eye.Y, (double)center.Z - eye.Z};
+    double s[3], u[3];
+    normalize3(f);
+    cross3(f, u0, s);
+    normalize3(s);
+    cross3(s, f, u);
+    identity(m);
+    for (int k = 0; k < 3; k++) {
+        m[k*4 + 0] = s[k];
+        m[k*4 + 1] = u[k];
+        m[k*4 + 2] = -f[k];
+    }
+    m[12] = -(s[0]*e[0] + s[1]*e[1] + s[2]*e[2]);
+    m[13] = -(u[0]*e[0] + u[1]*e[1] + u[2]*e[2]);
+    m[14] = f[0]*e[0] + f[1]*e[1] + f[2]*e[2];
+}
+
+// HMM_Perspective's own convention, FOV in degrees and aspect applied to y
+void ref_perspective(double fov, double aspect, double n, double f, double *m)
+{
+    double t = tan(fov * HMM_PI / 360.0);
+    for (int k = 0; k < 16; k++) {
+        m[k] = 0.0;
+    }
+    m[0] = 1.0 / t;
+    m[5] = aspect / t;
+    m[10] = (n + f) / (n - f);
+    m[11] = -1.0;
+    m[14] = 2.0 * n * f / (n - f);
+}
+
+void ref_orthographic(double l, double r, double b, double t, double n, double f, double *m)
+{
+    identity(m);
+    m[0] = 2.0 / (r - l);
+    m[5] = 2.0 / (t - b);
+    m[10] = 2.0 / (n - f);
+    m[12] = (l + r) / (l - r);
+    m[13] = (b + t) / (b - t);
+    m[14] = (f + n) / (n - f);
+}
+
+// Rodrigues, angle in degrees like HMM_Rotate
+void ref_rotate(double degrees, hmm_vec3 axis, double *m)
+{
+    double a[3] = {axis.X, axis.Y, axis.Z};
+    normalize3(a);
+    double s = sin(degrees * HMM_PI / 180.0), c = cos(degrees * HMM_PI / 180.0);
+    identity(m);
+    for (int col = 0; col < 3; col++) {
+        for (int row = 0; row < 3; row++) {
+            m[col*4 + row] = a[col]*a[row]*(1.0 - c) + (col == row ? c : 0.0);
+        }
+    }
+    m[1] += a[2]*s; m[2] -= a[1]*s;
+    m[4] -= a[2]*s; m[6] += a[0]*s;
+    m[8] += a[1]*s; m[9] -= a[0]*s;
+}
+
+void ref_quaternion_to_mat4(const double *q_in, double *m)
+{
+    double length = sqrt(q_in[0]*q_in[0] + q_in[1]*q_in[1] + q_in[2]*q_in[2] + q_in[3]*q_in[3]);
+    double x = q_in[0] / length, y = q_in[1] / length, z = q_in[2] / length, w = q_in[3] / length;
+    identity(m);
+    m[0] = 1.0 - 2.0*(y*y + z*z); m[1] = 2.0*(x*y + w*z);       m[2] = 2.0*(x*z - w*y);
+    m[4] = 2.0*(x*y - w*z);       m[5] = 1.0 - 2.0*(x*x + z*z); m[6] = 2.0*(y*z + w*x);
+    m[8] = 2.0*(x*z + w*y);       m[9] = 2.0*(y*z - w*x);       m[10] = 1.0 - 2.0*(x*x + y*y);
+}
+
+void ref_quaternion_multiply(hmm_quaternion a, hmm_quaternion b, double *q)
+{
+    double ax = a.X, ay = a.Y, az = a.Z, aw = a.W, bx = b.X, by = b.Y, bz = b.Z, bw = b.W;
+    q[0] = aw*bx + ax*bw + ay*bz - az*by;
+    q[1] = aw*by - ax*bz + ay*bw + az*bx;
+    q[2] = aw*bz + ax*by - ay*bx + az*bw;
+    q[3] = aw*bw - ax*bx - ay*by - az*bz;
+}
+
+void to_double(const float *in, double *out, int count)
+{
+    for (int k = 0; k < count; k++) {
+        out[k] = in[k];
+    }
+}
+
+void setup(void)
+{
+    for (int i = 0; i < POOL; i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                mat_a[i].Elements[c][r] = randf();
+                mat_b[i].Elements[c][r] = randf();
+            }
+        }
+        vec4_a[i] = HMM_Vec4(randf(), randf(), randf(), 1.0f);
+        vec3_a[i] = HMM_Vec3(randf() * 10.0f, randf() * 10.0f, randf() * 10.0f);
+        vec3_b[i] = HMM_Vec3(randf(), randf(), randf() + 1.5f);
+        // up vectors, never parallel to center - eye
+        vec3_c[i] = HMM_Vec3(randf() * 0.1f, 1.0f, randf() * 0.1f);
+        scalar_a[i] = 0.5f + (randf() + 1.0f) * 50.0f;
+        scalar_b[i] = 1.0f + (randf() + 1.0f) * 0.5f;
+        angles[i] = randf() * 180.0f;
+        times[i] = (randf() + 1.0f) * 0.5f;
+        quat_a[i] = HMM_QuaternionFromAxisAngle(vec3_b[i], randf() * 3.0f);
+        // nearby keys, HMM_Slerp and HMM_NLerp don't pick the short way round
+        quat_b[i] = HMM_MultiplyQuaternion(quat_a[i], HMM_QuaternionFromAxisAngle(HMM_Vec3(randf(), 1.0f, randf()),
+                                                                                  0.1f + (randf() + 1.0f) * 0.7f));
+        transforms[i] = HMM_Transform(vec3_a[i], quat_a[i], HMM_Vec3(scalar_b[i], 2.0f - randf(), scalar_b[i]));
+        trs[i] = HMM_TransformToMat4(transforms[i]);
+    }
+}
+
+hmm_mat4 identity_mat4 = {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+
+// translate * rotate * scale in double
+void chain_check(void)
+{
+    for (int i = 0; i < POOL; i++) {
+        double rotation[16], m[16];
+        ref_rotate(angles[i], vec3_b[i], rotation);
+        for (int c = 0; c < 3; c++) {
+            for (int r = 0; r < 3; r++) {
+                m[c*4 + r] = rotation[c*4 + r] * vec3_c[i].Elements[c];
+            }
+            m[c*4 + 3] = 0.0;
+        }
+        to_double(vec3_a[i].Elements, m + 12, 3);
+        m[15] = 1.0;
+        check_mat(&out_mat[i], m);
+    }
+}
+
+void bench_matrices(void)
+{
+    double m[16], v[4];
+
+    TIME("HMM_MultiplyMat4", 1e-6, out_mat[i] = HMM_MultiplyMat4(mat_a[i], mat_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_multiply(&mat_a[i], &mat_b[i], m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_MultiplyMat4To", 1e-6, HMM_MultiplyMat4To(&mat_a[i], &mat_b[i], &out_mat[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_multiply(&mat_a[i], &mat_b[i], m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_MultiplyMat4ByVec4", 1e-6, out_vec4[i] = HMM_MultiplyMat4ByVec4(mat_a[i], vec4_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        for (int r = 0; r < 4; r++) {
+            v[r] = 0.0;
+            for (int c = 0; c < 4; c++) {
+                v[r] += (double)mat_a[i].Elements[c][r] * vec4_a[i].Elements[c];
+            }
+        }
+        check(out_vec4[i].Elements, v, 4);
+    }
+
+    TIME("HMM_MultiplyMat4ByVec4To", 1e-6, HMM_MultiplyMat4ByVec4To(&mat_a[i], &vec4_a[i], &out_vec4[i]));
+    for (int i = 0; i < POOL; i++) {
+        for (int r = 0; r < 4; r++) {
+            v[r] = 0.0;
+            for (int c = 0; c < 4; c++) {
+                v[r] += (double)mat_a[i].Elements[c][r] * vec4_a[i].Elements[c];
+            }
+        }
+        check(out_vec4[i].Elements, v, 4);
+    }
+
+    TIME("HMM_Transpose", 0.0, out_mat[i] = HMM_Transpose(mat_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                m[c*4 + r] = mat_a[i].Elements[r][c];
+            }
+        }
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_InverseMat4", 1e-5, out_mat[i] = HMM_InverseMat4(trs[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_inverse(&trs[i], m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_LookAt", 2e-6, out_mat[i] = HMM_LookAt(vec3_a[i], vec3_b[i], vec3_c[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_look_at(vec3_a[i], vec3_b[i], vec3_c[i], m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_Perspective", 1e-6, out_mat[i] = HMM_Perspective(30.0f + times[i] * 90.0f, scalar_b[i], 0.1f, scalar_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_perspective(30.0f + times[i] * 90.0f, scalar_b[i], 0.1f, scalar_a[i], m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_Orthographic", 1e-6, out_mat[i] = HMM_Orthographic(-scalar_a[i], scalar_a[i], -scalar_b[i], scalar_b[i], 0.1f, 100.0f));
+    for (int i = 0; i < POOL; i++) {
+        ref_orthographic(-scalar_a[i], scalar_a[i], -scalar_b[i], scalar_b[i], 0.1f, 100.0f, m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_Rotate", 1e-6, out_mat[i] = HMM_Rotate(angles[i], vec3_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_rotate(angles[i], vec3_b[i], m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_Translate", 0.0, out_mat[i] = HMM_Translate(vec3_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        identity(m);
+        to_double(vec3_a[i].Elements, m + 12, 3);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_Scale", 0.0, out_mat[i] = HMM_Scale(vec3_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        identity(m);
+        m[0] = vec3_a[i].X; m[5] = vec3_a[i].Y; m[10] = vec3_a[i].Z;
+        check_mat(&out_mat[i], m);
+    }
+
+    // a model matrix the way main.c used to build one, by value and in place
+    TIME("chain HMM_Translate*HMM_Rotate*HMM_Scale", 1e-6,
+         out_mat[i] = HMM_MultiplyMat4(HMM_MultiplyMat4(HMM_Translate(vec3_a[i]), HMM_Rotate(angles[i], vec3_b[i])),
+                                       HMM_Scale(vec3_c[i])));
+    chain_check();
+
+    TIME("chain HMM_TranslateInPlace/RotateInPlace/ScaleInPlace", 1e-6,
+         out_mat[i] = identity_mat4;
+         HMM_TranslateInPlace(&out_mat[i], vec3_a[i]);
+         HMM_RotateInPlace(&out_mat[i], angles[i], vec3_b[i]);
+         HMM_ScaleInPlace(&out_mat[i], vec3_c[i]));
+    chain_check();
+
+    TIME("HMM_TransformToMat4", 1e-6, out_mat[i] = HMM_TransformToMat4(transforms[i]));
+    for (int i = 0; i < POOL; i++) {
+        double q[4], rotation[16];
+        to_double(transforms[i].Rotation.Elements, q, 4);
+        ref_quaternion_to_mat4(q, rotation);
+        identity(m);
+        for (int c = 0; c < 3; c++) {
+            for (int r = 0; r < 3; r++) {
+                m[c*4 + r] = rotation[c*4 + r] * transforms[i].Scale.Elements[c];
+            }
+        }
+        to_double(transforms[i].Translation.Elements, m + 12, 3);
+        check_mat(&out_mat[i], m);
+    }
+}
+
+void bench_vectors(void)
+{
+    double v[4];
+
+    TIME("HMM_NormalizeVec3", 1e-6, out_vec3[i] = HMM_NormalizeVec3(vec3_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        to_double(vec3_a[i].Elements, v, 3);
+        normalize3(v);
+        check(out_vec3[i].Elements, v, 3);
+    }
+
+    TIME("HMM_Cross", 1e-6, out_vec3[i] = HMM_Cross(vec3_a[i], vec3_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        double a[3], b[3];
+        to_double(vec3_a[i].Elements, a, 3);
+        to_double(vec3_b[i].Elements, b, 3);
+        cross3(a, b, v);
+        check(out_vec3[i].Elements, v, 3);
+    }
+
+    TIME("HMM_DotVec3", 1e-6, out_float[i] = HMM_DotVec3(vec3_a[i], vec3_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        v[0] = (double)vec3_a[i].X*vec3_b[i].X + (double)vec3_a[i].Y*vec3_b[i].Y + (double)vec3_a[i].Z*vec3_b[i].Z;
+        check(&out_float[i], v, 1);
+    }
+
+    TIME("HMM_LengthVec3", 1e-6, out_float[i] = HMM_LengthVec3(vec3_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        v[0] = sqrt((double)vec3_a[i].X*vec3_a[i].X + (double)vec3_a[i].Y*vec3_a[i].Y + (double)vec3_a[i].Z*vec3_a[i].Z);
+        check(&out_float[i], v, 1);
+    }
+}
+
+void bench_scalars(void)
+{
+    double v[1];
+
+    TIME("HMM_SquareRootF", 1e-7, out_float[i] = HMM_SquareRootF(scalar_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        v[0] = sqrt(scalar_a[i]);
+        check(&out_float[i], v, 1);
+    }
+
+    // with SSE this is the bare rsqrtss estimate, 1.5 * 2^-12 relative error by Intel's spec
+    TIME("HMM_RSquareRootF", 3.7e-4, out_float[i] = HMM_RSquareRootF(scalar_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        v[0] = 1.0 / sqrt(scalar_b[i]);
+        check(&out_float[i], v, 1);
+    }
+
+    TIME("HMM_SinF", 1e-7, out_float[i] = HMM_SinF(angles[i] * 0.1f));
+    for (int i = 0; i < POOL; i++) {
+        v[0] = sin(angles[i] * 0.1f);
+        check(&out_float[i], v, 1);
+    }
+
+    TIME("HMM_SinCosF", 1e-7, HMM_SinCosF(angles[i] * 0.1f, &out_float[i], &out_float_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        v[0] = sin(angles[i] * 0.1f);
+        check(&out_float[i], v, 1);
+        v[0] = cos(angles[i] * 0.1f);
+        check(&out_float_b[i], v, 1);
+    }
+}
+
+void bench_quaternions(void)
+{
+    double q[4], m[16];
+
+    TIME("HMM_MultiplyQuaternion", 1e-6, out_quat[i] = HMM_MultiplyQuaternion(quat_a[i], quat_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        ref_quaternion_multiply(quat_a[i], quat_b[i], q);
+        check(out_quat[i].Elements, q, 4);
+    }
+
+    TIME("HMM_DotQuaternion", 1e-6, out_float[i] = HMM_DotQuaternion(quat_a[i], quat_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        q[0] = 0.0;
+        for (int k = 0; k < 4; k++) {
+            q[0] += (double)quat_a[i].Elements[k] * quat_b[i].Elements[k];
+        }
+        check(&out_float[i], q, 1);
+    }
+
+    TIME("HMM_NormalizeQuaternion", 1e-6, out_quat[i] = HMM_NormalizeQuaternion(HMM_Quaternion(quat_a[i].X, quat_a[i].Y, 2.0f, quat_a[i].W)));
+    for (int i = 0; i < POOL; i++) {
+        q[0] = quat_a[i].X; q[1] = quat_a[i].Y; q[2] = 2.0; q[3] = quat_a[i].W;
+        double length = sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+        for (int k = 0; k < 4; k++) {
+            q[k] /= length;
+        }
+        check(out_quat[i].Elements, q, 4);
+    }
+
+    TIME("HMM_InverseQuaternion", 1e-6, out_quat[i] = HMM_InverseQuaternion(quat_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        double n = 0.0;
+        for (int k = 0; k < 4; k++) {
+            n += (double)quat_a[i].Elements[k] * quat_a[i].Elements[k];
+        }
+        q[0] = -quat_a[i].X / n; q[1] = -quat_a[i].Y / n; q[2] = -quat_a[i].Z / n; q[3] = quat_a[i].W / n;
+        check(out_quat[i].Elements, q, 4);
+    }
+
+    TIME("HMM_NLerp", 1e-6, out_quat[i] = HMM_NLerp(quat_a[i], times[i], quat_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        double n = 0.0;
+        for (int k = 0; k < 4; k++) {
+            q[k] = (1.0 - times[i]) * quat_a[i].Elements[k] + (double)times[i] * quat_b[i].Elements[k];
+            n += q[k] * q[k];
+        }
+        for (int k = 0; k < 4; k++) {
+            q[k] /= sqrt(n);
+        }
+        check(out_quat[i].Elements, q, 4);
+    }
+
+    TIME("HMM_Slerp", 1e-5, out_quat[i] = HMM_Slerp(quat_a[i], times[i], quat_b[i]));
+    for (int i = 0; i < POOL; i++) {
+        double dot = 0.0;
+        for (int k = 0; k < 4; k++) {
+            dot += (double)quat_a[i].Elements[k] * quat_b[i].Elements[k];
+        }
+        double angle = acos(dot);
+        double wa = sin((1.0 - times[i]) * angle) / sin(angle), wb = sin(times[i] * angle) / sin(angle);
+        for (int k = 0; k < 4; k++) {
+            q[k] = wa * quat_a[i].Elements[k] + wb * quat_b[i].Elements[k];
+        }
+        check(out_quat[i].Elements, q, 4);
+    }
+
+    TIME("HMM_QuaternionToMat4", 1e-6, out_mat[i] = HMM_QuaternionToMat4(quat_a[i]));
+    for (int i = 0; i < POOL; i++) {
+        to_double(quat_a[i].Elements, q, 4);
+        ref_quaternion_to_mat4(q, m);
+        check_mat(&out_mat[i], m);
+    }
+
+    TIME("HMM_QuaternionFromAxisAngle", 1e-6, out_quat[i] = HMM_QuaternionFromAxisAngle(vec3_b[i], angles[i] * 0.01f));
+    for (int i = 0; i < POOL; i++) {
+        double axis[3], half = angles[i] * 0.01f * 0.5;
+        to_double(vec3_b[i].Elements, axis, 3);
+        normalize3(axis);
+        q[0] = axis[0] * sin(half); q[1] = axis[1] * sin(half); q[2] = axis[2] * sin(half); q[3] = cos(half);
+        check(out_quat[i].Elements, q, 4);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        reps = atoi(argv[1]);
+    }
+    if (reps < 1) {
+        reps = 1;
+    }
+
+    setup();
+    bench_matrices();
+    bench_vectors();
+    bench_scalars();
+    bench_quaternions();
+
+    int failed = 0;
+    printf("{\n");
+#if defined(HANDMADE_MATH__USE_AVX) && defined(HANDMADE_MATH__USE_FMA)
+    printf("  \"simd\": \"avx+fma\",\n");
+#elif defined(HANDMADE_MATH__USE_AVX)
+    printf("  \"simd\": \"avx\",\n");
+#elif defined(HANDMADE_MATH__USE_SSE)
+    printf("  \"simd\": \"sse\",\n");
+#else
+    printf("  \"simd\": \"scalar\",\n");
+#endif
+    // gcc and clang define __NO_INLINE__ under -O0 and -fno-inline
+#ifdef __NO_INLINE__
+    printf("  \"inline\": false,\n");
+#else
+    printf("  \"inline\": true,\n");
+#endif
+#ifdef __VERSION__
+    printf("  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    printf("  \"pool\": %d,\n", POOL);
+    printf("  \"reps\": %d,\n", reps);
+    printf("  \"unit\": \"ns/op\",\n");
+    printf("  \"functions\": [\n");
+    for (int i = 0; i < result_count; i++) {
+        Result *r = &results[i];
+        int ok = r->error <= r->tolerance;
+        failed |= !ok;
+        printf("    {\"name\": \"%s\", \"ns\": %.3f, \"max_error\": %.3g, \"tolerance\": %.3g, \"ok\": %s}%s\n",
+               r->name, r->ns, r->error, r->tolerance, ok ? "true" : "false", i + 1 < result_count ? "," : "");
+    }
+    printf("  ],\n");
+    printf("  \"ok\": %s\n", failed ? "false" : "true");
+    printf("}\n");
+    return failed;
+}
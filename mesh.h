@@ -0,0 +1,1973 @@
+/*
+  mesh.h
+
+  Binary mesh cache. The first time an OBJ is loaded through
+  mesh_load_obj it's parsed with obj.h and written next to the source as
+  <path>.mesh; later runs map that file and hand the vertex and index
+  blobs straight to GL, no parsing, no copies on the CPU side. The cache
+  stores a hash of the OBJ bytes and is rebuilt when the source changes,
+  when the format version changes, or when it doesn't validate: every
+  blob inside the file, and every index, range and table entry inside
+  what it points into, so a damaged cache is rebuilt, never read past.
+
+  Baking runs the mesh_opt.h passes over every submesh (vertex cache
+  order, then overdraw clusters) and renumbers the vertices in fetch
+  order, so the cache holds the optimized mesh and runs pay nothing for it.
+  Every submesh also gets up to MESH_MAX_LODS - 1 simplified levels of
+  detail (mesh_opt_simplify, half the triangles each step), appended to
+  the index buffer after the full detail indices and sharing its vertices,
+  and each level's error, so a mesh far away can draw with fewer
+  triangles without a visible change. Each full detail submesh is also cut
+  into meshlets, runs of at most 64 vertices and
+  124 triangles with a bounding sphere and normal cone, stored SoA so
+  cull_cones (cull.h) reads them straight from the mapping.
+
+  Submeshes are one per material: mesh_optimize merges every usemtl run
+  of a material into one range (obj_group_by_material) and gives each
+  material its own copy of vertices they share. The mtllib next to the OBJ
+  is baked into a material table, and its texture paths into a texture
+  table. Every vertex carries its submesh's material number
+  (attribute 3, an unsigned int in the shader), so a mesh with any number
+  of materials draws in one call that indexes the table. An edited .mtl
+  rebuilds the cache like an edited OBJ. Materials the library doesn't
+  have, or all of them when there's no library, get
+  obj_default_material.
+
+  Baked with MESH_QUANTIZE (mesh_load_obj_flags, cached as <path>.q.mesh
+  so it doesn't fight the float cache) a vertex is 16 bytes instead of
+  36: the position as three 16 bit fixed point values across the mesh's
+  bounds, the material, the normal octahedral encoded into two 16 bit
+  values and the uv as two 16 bit values across the uv bounds. GL turns
+  the fixed point back into [0, 1] / [-1, 1] floats on fetch, the vertex
+  shader does the rest with MESH_GLSL_DECODE, which also passes float
+  meshes through, so one shader draws both:
+
+     vertex shader: "#version 450 core\n" MESH_GLSL_DECODE "...",
+         gl_Position = projection_view * model * vec4(mesh_position(aPos), 1.0f);
+         Normal = mesh_normal(aNormal); // aNormal declared vec3 either way
+     after linking:
+         mesh_decode_uniforms(&mesh, program);
+
+  The header keeps the largest error quantizing made (position_error in
+  model units, normal_error in degrees, uv_error).
+
+  OBJs too big to parse in memory, multi gigabyte scans and the like, are
+  baked offline by mesh_convert_obj into the same cache
+  mesh_load_obj_flags looks for, so the program that draws them gets a
+  hit. It streams the OBJ through obj_stream and bakes a chunk of faces
+  at a time: every chunk becomes a submesh with its own vertices, levels
+  of detail and meshlets, and is written out as soon as it's done. The
+  vertices go straight into the cache, the blobs after them collect in
+  temporary files next to it and are copied into place at the end. Memory
+  stays under the limit it's given whatever the file's size, so files
+  bigger than RAM convert too:
+
+     if (mesh_convert_obj("scan.obj", 0, 256 << 20)) {
+         mesh_load_obj(&mesh, "scan.obj", 0); // a hit, maps the cache
+     }
+
+  Unlike mesh_load_obj's bake, a material gets a submesh per run of faces
+  that use it (and per chunk) rather than one, vertices on chunk borders
+  are stored once per chunk, and the bounds cover every v and vt line, not
+  only the ones faces use.
+
+  Do this:
+
+     #define MESH_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header, AFTER glad.h, asset_io.h,
+  obj.h and mesh_opt.h. Define MESH_NO_GL to leave out mesh_upload (tools that never
+  touch GL).
+
+  Usage:
+
+     mesh_data mesh;
+     if (mesh_load_obj(&mesh, "./third_party/assets/Tree.obj", 0)) {
+         GLuint vbo, ibo;
+         GLuint vao = mesh_upload(&mesh, &vbo, &ibo);
+         for (uint32_t s = 0; s < mesh.header->submesh_count; s++) {
+             glDrawElements(GL_TRIANGLES, mesh.submeshes[s].index_count, GL_UNSIGNED_INT,
+                            (void *)(mesh.submeshes[s].index_offset * sizeof(uint32_t)));
+         }
+         mesh_close(&mesh);
+     }
+
+  Picking a level of detail for a mesh whose bounding sphere (radius from
+  the header's bounds) is distance away, drawn with HMM_Perspective(fov, ...)
+  into a viewport height pixels tall, at most a pixel off:
+
+     float scale = mesh_lod_scale(fov, height, distance, radius);
+     uint32_t level = mesh_lod_select(&mesh, scale, 1.0f);
+     const mesh_lod *lod = &mesh.lods[level * mesh.header->submesh_count + s];
+     glDrawElements(GL_TRIANGLES, lod->index_count, GL_UNSIGNED_INT, (void *)(lod->index_offset * sizeof(uint32_t)));
+
+  Drawing only the meshlets that face the camera and touch the frustum,
+  camera in model space:
+
+     const mesh_meshlets *ml = &mesh.meshlets;
+     int visible_count = cull_cones(&frustum, camera, ml->x, ml->y, ml->z, ml->radius,
+                                    ml->axis_x, ml->axis_y, ml->axis_z, ml->cutoff,
+                                    mesh.header->meshlet_count, visible);
+     uint32_t command_count = mesh_meshlet_commands(&mesh, 0, visible, visible_count, 1, commands);
+     // upload commands to a GL_DRAW_INDIRECT_BUFFER, then
+     glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, command_count, 0);
+
+  The whole mesh in one draw, materials from a shader storage buffer:
+
+     GLuint materials = mesh_upload_materials(&mesh);
+     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, materials);
+     glDrawElements(GL_TRIANGLES, mesh.lods[level * submesh_count].index_count, ...); // every submesh of a level
+
+     // vertex shader                              // fragment shader
+     layout (location = 3) in uint aMaterial;      struct Material { vec4 diffuse; vec4 specular; vec4 emissive; ivec4 maps; };
+     flat out uint Material;                       layout (std430, binding = 0) readonly buffer Materials { Material materials[]; };
+     ... Material = aMaterial;                     ... materials[Material].diffuse
+
+  maps holds texture table numbers (mesh.textures, paths as the .mtl
+  wrote them, relative to it) or -1. Loading them, e.g. into the layers of
+  a GL_TEXTURE_2D_ARRAY so one sampler covers them all, is up to the
+  caller.
+
+  File layout, little endian, every offset from the start of the file:
+
+     mesh_header                    magic, version, source hash, counts, bounds,
+                                    vertex layout (GL type/components/offset per attribute)
+     vertices   at vertex_offset    vertex_count * vertex_stride bytes
+     indices    at index_offset     index_count * index_size bytes
+     submeshes  at submesh_offset   submesh_count mesh_submesh
+     materials  at material_offset  material_count mesh_material
+     textures   at texture_offset   texture_count mesh_texture
+     lods       at lod_offset       lod_count * submesh_count mesh_lod, level
+                                    major, level 0 repeats the submesh ranges
+     meshlets   at meshlet_offset   ten arrays of meshlet_count values, each
+                                    starting MESH_ALIGN aligned: index offset,
+                                    index count (uint32), center x, y, z,
+                                    radius, cone axis x, y, z, cone cutoff (float)
+
+  Blobs start on MESH_ALIGN byte boundaries so the mapped pointers are
+  aligned for SIMD loads and whole cache lines.
+*/
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESH_MAGIC 0x4853454du // "MESH" read as a little endian uint32
+#define MESH_VERSION 6 // also bumped when baking changes, so older caches get rebuilt
+#define MESH_ALIGN 64
+#define MESH_MAX_ATTRIBUTES 8
+#define MESH_NAME_LEN 64
+#define MESH_PATH_LEN 256
+#define MESH_MAX_LODS 5
+#define MESH_CONVERT_MIN_MEMORY (16 << 20) // the smallest memory_limit mesh_convert_obj takes
+
+// attribute types, same values as the GL enums so they go straight to glVertexAttribPointer
+#define MESH_FLOAT 0x1406
+#define MESH_UNSIGNED_SHORT 0x1403
+#define MESH_SHORT 0x1402
+
+// mesh_load_obj_flags
+#define MESH_QUANTIZE 1u // 16 byte vertices, see above
+
+// what a vertex shader needs to read either kind of vertex, after #version. Float meshes
+// decode with offset 0, scale 1 and mesh_octahedral false
+#define MESH_GLSL_DECODE \
+    "uniform vec3 mesh_position_offset;\n" \
+    "uniform vec3 mesh_position_scale;\n" \
+    "uniform vec2 mesh_uv_offset;\n" \
+    "uniform vec2 mesh_uv_scale;\n" \
+    "uniform bool mesh_octahedral;\n" \
+    "vec3 mesh_position(vec3 p) { return mesh_position_offset + p*mesh_position_scale; }\n" \
+    "vec2 mesh_uv(vec2 uv) { return mesh_uv_offset + uv*mesh_uv_scale; }\n" \
+    "vec3 mesh_normal(vec3 n)\n" \
+    "{\n" \
+    "    if (!mesh_octahedral) {\n" \
+    "        return n;\n" \
+    "    }\n" \
+    "    // the lower half was folded over the diagonals of the upper one\n" \
+    "    vec3 o = vec3(n.xy, 1.0f - abs(n.x) - abs(n.y));\n" \
+    "    float t = max(-o.z, 0.0f);\n" \
+    "    o.xy += vec2(o.x >= 0.0f ? -t : t, o.y >= 0.0f ? -t : t);\n" \
+    "    return normalize(o);\n" \
+    "}\n"
+
+typedef struct
+{
+    uint32_t location;   // shader attribute location
+    uint32_t type;       // MESH_FLOAT, ...
+    uint32_t components;
+    uint32_t normalized; // for integer types, 1 = fixed point [0, 1] / [-1, 1], 0 = read as an integer
+    uint32_t offset;     // bytes into the vertex
+} mesh_attribute;
+
+typedef struct
+{
+    char object[MESH_NAME_LEN];
+    char material[MESH_NAME_LEN];
+    uint32_t index_offset;
+    uint32_t index_count;
+    uint32_t meshlet_offset; // its meshlets, in index order
+    uint32_t meshlet_count;
+    uint32_t material_index; // into the material table, also in every one of its vertices
+} mesh_submesh;
+
+typedef struct
+{
+    char name[MESH_NAME_LEN];
+    float ambient[3], diffuse[3], specular[3], emissive[3];
+    float shininess, opacity, ior;
+    int32_t illum;
+    int32_t maps[4]; // OBJ_MAP_DIFFUSE, ...: into the texture table, -1 for none
+} mesh_material;
+
+typedef struct
+{
+    char path[MESH_PATH_LEN]; // as the .mtl has it
+} mesh_texture;
+
+// one entry of the table shaders index, std430 layout: vec4 diffuse, specular, emissive, ivec4 maps
+typedef struct
+{
+    float diffuse[4];  // rgb, opacity
+    float specular[4]; // rgb, shininess
+    float emissive[4]; // rgb, unused
+    int32_t maps[4];
+} mesh_gpu_material;
+
+// one submesh at one level of detail, a range of the index buffer
+typedef struct
+{
+    uint32_t index_offset;
+    uint32_t index_count;
+} mesh_lod;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash; // mesh_hash of the OBJ bytes
+    uint64_t source_size;
+    uint64_t material_hash; // mesh_hash of the .mtl bytes, 0 when there's none
+    char mtllib[MESH_NAME_LEN];
+    uint32_t vertex_count;
+    uint32_t vertex_stride;
+    uint32_t index_count;
+    uint32_t index_size;  // bytes per index
+    uint32_t submesh_count;
+    uint32_t attribute_count;
+    uint32_t meshlet_count;
+    uint32_t lod_count;                 // levels of detail, 1 is just the full mesh
+    uint32_t material_count;
+    uint32_t texture_count;
+    uint32_t flags;                     // MESH_QUANTIZE, ...
+    float uv_min[2], uv_max[2];
+    float position_error, normal_error, uv_error; // largest made quantizing, 0 for float vertices
+    float lod_error[MESH_MAX_LODS];     // how far each level's surface may be from level 0, model units
+    uint64_t vertex_offset;
+    uint64_t index_offset;              // all levels, level 0 first
+    uint64_t submesh_offset;
+    uint64_t meshlet_offset;
+    uint64_t lod_offset;
+    uint64_t material_offset;
+    uint64_t texture_offset;
+    uint64_t file_size;
+    float min[3], max[3];
+    mesh_attribute attributes[MESH_MAX_ATTRIBUTES];
+} mesh_header;
+
+// meshlet i draws index_count[i] indices from index_offset[i], bounds in model space
+typedef struct
+{
+    const uint32_t *index_offset;
+    const uint32_t *index_count;
+    const float *x, *y, *z, *radius;
+    const float *axis_x, *axis_y, *axis_z, *cutoff;
+} mesh_meshlets;
+
+// same layout as GL's DrawElementsIndirectCommand
+typedef struct
+{
+    uint32_t count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t base_instance;
+} mesh_draw_command;
+
+typedef struct
+{
+    const mesh_header *header;
+    const void *vertices;
+    const void *indices;
+    const mesh_submesh *submeshes;
+    const mesh_lod *lods;
+    const mesh_material *materials;
+    const mesh_texture *textures;
+    mesh_meshlets meshlets;
+
+    asset_file file; // the mapped cache
+    void *owned;     // or a copy in memory, when the cache couldn't be written
+} mesh_data;
+
+// cache next to the OBJ, rebuilt when missing or stale. threads is passed to obj_parse_threaded.
+// returns 0 on failure, m is zeroed in that case
+int mesh_load_obj(mesh_data *m, const char *obj_path, int threads);
+// same, baked with flags (MESH_QUANTIZE, ...)
+int mesh_load_obj_flags(mesh_data *m, const char *obj_path, int threads, uint32_t flags);
+// bakes the cache mesh_load_obj_flags would use for obj_path, streaming, peak memory below
+// memory_limit bytes (at least MESH_CONVERT_MIN_MEMORY). returns 0 on failure
+int mesh_convert_obj(const char *obj_path, uint32_t flags, size_t memory_limit);
+// just the cache file, fails if it doesn't validate
+int mesh_open(mesh_data *m, const char *path);
+void mesh_close(mesh_data *m);
+
+// one group per material, then reorders obj's triangles within each group and its vertices, what
+// mesh_load_obj bakes. returns 0 on allocation failure
+int mesh_optimize(obj_mesh *obj);
+// the file image of an optimized OBJ mesh plus its levels of detail, meshlets and materials (lib
+// may be NULL), malloc'd, *size is its length
+void *mesh_serialize(const obj_mesh *obj, const obj_material_lib *lib, uint64_t source_hash, uint64_t source_size,
+                     uint64_t material_hash, uint32_t flags, size_t *size);
+// writes to path.tmp and renames over path, so readers never see half a file
+int mesh_write(const char *path, const void *image, size_t size);
+uint64_t mesh_hash(const void *data, size_t size);
+
+// pixels per model space unit at the near side of a bounding sphere, for HMM_Perspective's fov in
+// degrees and a viewport height pixels tall. Times radius it's the sphere's projected radius
+float mesh_lod_scale(float fov_degrees, float viewport_height, float distance, float radius);
+// the coarsest level whose error, at scale pixels per unit, is at most max_pixel_error
+uint32_t mesh_lod_select(const mesh_data *m, float scale, float max_pixel_error);
+
+// visible holds meshlet numbers relative to first_meshlet, as cull_cones writes them. Meshlets
+// next to each other in the index buffer are merged. commands / indices need room for
+// visible_count commands / the visible meshlets' index counts, returns how many were written
+uint32_t mesh_meshlet_commands(const mesh_data *m, uint32_t first_meshlet, const int *visible, int visible_count,
+                               uint32_t instance_count, mesh_draw_command *commands);
+uint32_t mesh_meshlet_indices(const mesh_data *m, uint32_t first_meshlet, const int *visible, int visible_count,
+                              uint32_t *indices);
+
+// header->material_count entries, what mesh_upload_materials puts in its buffer
+void mesh_material_table(const mesh_data *m, mesh_gpu_material *table);
+
+// what MESH_GLSL_DECODE's uniforms are set to
+typedef struct
+{
+    float position_offset[3], position_scale[3];
+    float uv_offset[2], uv_scale[2];
+    int octahedral;
+} mesh_decode;
+
+void mesh_vertex_decode(const mesh_data *m, mesh_decode *decode);
+
+#ifndef MESH_NO_GL
+// VAO with the attributes from the header, the buffers are immutable (glBufferStorage) on GL 4.4+
+GLuint mesh_upload(const mesh_data *m, GLuint *vbo, GLuint *ibo);
+// shader storage buffer holding mesh_material_table, bind it with glBindBufferBase
+GLuint mesh_upload_materials(const mesh_data *m);
+// sets program's MESH_GLSL_DECODE uniforms for m's vertices
+void mesh_decode_uniforms(const mesh_data *m, GLuint program);
+#endif
+
+#endif // MESH_H
+
+#ifdef MESH_IMPLEMENTATION
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t
+mesh_align(uint64_t offset)
+{
+    return (offset + MESH_ALIGN - 1) & ~(uint64_t)(MESH_ALIGN - 1);
+}
+
+// mesh_hash a piece at a time, for sources that are never all in memory at once
+typedef struct
+{
+    uint64_t lanes[4];
+    unsigned char tail[32]; // bytes short of a whole block so far
+    size_t tail_size;
+} mesh_hasher;
+
+static void
+mesh_hash_begin(mesh_hasher *hasher, uint64_t size)
+{
+    static const uint64_t k = 0x9e3779b97f4a7c15ull;
+    hasher->lanes[0] = k ^ size;
+    hasher->lanes[1] = k * 3;
+    hasher->lanes[2] = k * 5;
+    hasher->lanes[3] = k * 7;
+    hasher->tail_size = 0;
+}
+
+// four independent multiply-xor lanes over 32 byte blocks, so it isn't one long dependency chain
+static void
+mesh_hash_blocks(uint64_t *lanes, const unsigned char *p, size_t blocks)
+{
+    for (size_t b = 0; b < blocks; b++, p += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t word;
+            memcpy(&word, p + l * 8, 8);
+            lanes[l] = (lanes[l] ^ word) * 0xff51afd7ed558ccdull;
+            lanes[l] ^= lanes[l] >> 29;
+        }
+    }
+}
+
+static void
+mesh_hash_update(mesh_hasher *hasher, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    if (hasher->tail_size) {
+        size_t fill = 32 - hasher->tail_size < size ? 32 - hasher->tail_size : size;
+        memcpy(hasher->tail + hasher->tail_size, p, fill);
+        hasher->tail_size += fill;
+        p += fill;
+        size -= fill;
+        if (hasher->tail_size < 32) {
+            return;
+        }
+        mesh_hash_blocks(hasher->lanes, hasher->tail, 1);
+        hasher->tail_size = 0;
+    }
+    mesh_hash_blocks(hasher->lanes, p, size / 32);
+    memcpy(hasher->tail, p + size / 32 * 32, size % 32);
+    hasher->tail_size = size % 32;
+}
+
+static uint64_t
+mesh_hash_end(const mesh_hasher *hasher)
+{
+    const uint64_t *lanes = hasher->lanes;
+    uint64_t h = lanes[0] ^ (lanes[1] * 31) ^ (lanes[2] * 37) ^ (lanes[3] * 41);
+    for (size_t i = 0; i < hasher->tail_size; i++) {
+        h = (h ^ hasher->tail[i]) * 0x100000001b3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t
+mesh_hash(const void *data, size_t size)
+{
+    mesh_hasher hasher;
+    mesh_hash_begin(&hasher, size);
+    mesh_hash_update(&hasher, data, size);
+    return mesh_hash_end(&hasher);
+}
+
+// renumbering one group at a time to its own vertices, so the mesh_opt passes' per vertex tables
+// stay the size of the group
+typedef struct
+{
+    unsigned int *local;  // mesh vertex -> group vertex, ~0 when unused
+    unsigned int *global; // group vertex -> mesh vertex
+    float *positions;     // group vertex positions, packed
+    size_t used;
+} mesh_group_vertices;
+
+static int
+mesh_group_init(mesh_group_vertices *group, const obj_mesh *obj)
+{
+    group->local = malloc((obj->vertex_count ? obj->vertex_count : 1) * sizeof(unsigned int));
+    group->global = malloc((obj->vertex_count ? obj->vertex_count : 1) * sizeof(unsigned int));
+    group->positions = malloc((obj->vertex_count ? obj->vertex_count : 1) * 3 * sizeof(float));
+    group->used = 0;
+    if (!group->local || !group->global || !group->positions) {
+        free(group->local);
+        free(group->global);
+        free(group->positions);
+        return 0;
+    }
+    memset(group->local, 0xff, obj->vertex_count * sizeof(unsigned int));
+    return 1;
+}
+
+static void
+mesh_group_free(mesh_group_vertices *group)
+{
+    free(group->local);
+    free(group->global);
+    free(group->positions);
+}
+
+// rewrites indices to group vertices
+static void
+mesh_group_enter(mesh_group_vertices *group, const obj_mesh *obj, unsigned int *indices, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        unsigned int v = indices[i];
+        if (group->local[v] == 0xffffffffu) {
+            group->local[v] = (unsigned int)group->used;
+            group->global[group->used] = v;
+            memcpy(&group->positions[group->used * 3], obj->vertices[v].position, 3 * sizeof(float));
+            group->used++;
+        }
+        indices[i] = group->local[v];
+    }
+}
+
+// group vertex indices back to mesh vertices
+static void
+mesh_group_leave(const mesh_group_vertices *group, unsigned int *indices, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        indices[i] = group->global[indices[i]];
+    }
+}
+
+// ready for the next group
+static void
+mesh_group_reset(mesh_group_vertices *group)
+{
+    for (size_t u = 0; u < group->used; u++) {
+        group->local[group->global[u]] = 0xffffffffu;
+    }
+    group->used = 0;
+}
+
+// a vertex used by more than one group gets a copy for every group past the first, so each
+// vertex belongs to exactly one material
+static int
+mesh_split_materials(obj_mesh *obj)
+{
+    size_t vertex_count = obj->vertex_count, capacity = vertex_count;
+    int *owner = malloc((vertex_count ? vertex_count : 1) * sizeof(int));
+    int *copy_group = malloc((vertex_count ? vertex_count : 1) * sizeof(int));
+    unsigned int *copy = malloc((vertex_count ? vertex_count : 1) * sizeof(unsigned int));
+    int ok = owner && copy_group && copy;
+    if (ok) {
+        memset(owner, 0xff, vertex_count * sizeof(int));
+        memset(copy_group, 0xff, vertex_count * sizeof(int));
+    }
+    for (int g = 0; ok && g < obj->group_count; g++) {
+        unsigned int *indices = obj->indices + obj->groups[g].index_offset;
+        for (size_t i = 0; i < obj->groups[g].index_count; i++) {
+            unsigned int v = indices[i];
+            if (owner[v] < 0) {
+                owner[v] = g;
+            } else if (owner[v] != g) {
+                if (copy_group[v] != g) {
+                    if (obj->vertex_count == capacity) {
+                        capacity *= 2;
+                        obj_vertex *grown = realloc(obj->vertices, capacity * sizeof(obj_vertex));
+                        if (!grown) {
+                            ok = 0;
+                            break;
+                        }
+                        obj->vertices = grown;
+                    }
+                    obj->vertices[obj->vertex_count] = obj->vertices[v];
+                    copy[v] = obj->vertex_count++;
+                    copy_group[v] = g;
+                }
+                indices[i] = copy[v];
+            }
+        }
+    }
+    free(owner);
+    free(copy_group);
+    free(copy);
+    return ok;
+}
+
+int
+mesh_optimize(obj_mesh *obj)
+{
+    if (!obj_group_by_material(obj) || !mesh_split_materials(obj)) {
+        return 0;
+    }
+
+    // groups are material ranges, triangles can only move inside one
+    mesh_group_vertices group;
+    if (!mesh_group_init(&group, obj)) {
+        return 0;
+    }
+    for (int g = 0; g < obj->group_count; g++) {
+        unsigned int *indices = obj->indices + obj->groups[g].index_offset;
+        size_t count = obj->groups[g].index_count;
+        mesh_group_enter(&group, obj, indices, count);
+        mesh_opt_vertex_cache(indices, count, group.used, MESH_OPT_CACHE_SIZE);
+        mesh_opt_overdraw(indices, count, group.positions, 3 * sizeof(float), group.used, MESH_OPT_CACHE_SIZE, 1.05f);
+        mesh_group_leave(&group, indices, count);
+        mesh_group_reset(&group);
+    }
+    mesh_group_free(&group);
+    obj->vertex_count = (unsigned int)mesh_opt_vertex_fetch(obj->vertices, sizeof(obj_vertex), obj->indices,
+                                                            obj->index_count, obj->vertex_count);
+    return 1;
+}
+
+// levels 1 and up of every group, levels[level] malloc'd (the caller frees them), level_counts[level]
+// indices long. lods[level * group_count + g] index into levels[level]. Each level has half the
+// triangles of the one before, and is simplified from it, so its error adds to the one before's;
+// lod_error[level] is the largest over the groups. returns 0 on allocation failure
+static int
+mesh_simplify_levels(const obj_mesh *obj, unsigned int **levels, size_t *level_counts, mesh_lod *lods, float *lod_error)
+{
+    size_t largest = 0;
+    for (int g = 0; g < obj->group_count; g++) {
+        largest = obj->groups[g].index_count > largest ? obj->groups[g].index_count : largest;
+    }
+    int ok = 1;
+    for (int level = 1; level < MESH_MAX_LODS; level++) {
+        levels[level] = malloc((obj->index_count ? obj->index_count : 1) * sizeof(unsigned int));
+        ok &= levels[level] != NULL;
+        level_counts[level] = 0;
+        lod_error[level] = 0.0f;
+    }
+    unsigned int *source = malloc((largest ? largest : 1) * sizeof(unsigned int));
+    mesh_group_vertices group;
+    if (!ok || !source || !mesh_group_init(&group, obj)) {
+        for (int level = 1; level < MESH_MAX_LODS; level++) {
+            free(levels[level]);
+            levels[level] = NULL;
+        }
+        free(source);
+        return 0;
+    }
+
+    for (int g = 0; g < obj->group_count; g++) {
+        size_t count = obj->groups[g].index_count;
+        memcpy(source, obj->indices + obj->groups[g].index_offset, count * sizeof(unsigned int));
+        mesh_group_enter(&group, obj, source, count);
+        float error = 0.0f;
+        for (int level = 1; level < MESH_MAX_LODS; level++) {
+            unsigned int *destination = levels[level] + level_counts[level];
+            size_t target = (obj->groups[g].index_count / 3 >> level) * 3;
+            float step;
+            count = mesh_opt_simplify(destination, source, count, group.positions, 3 * sizeof(float), group.used,
+                                      target, &step);
+            error += step;
+            lod_error[level] = error > lod_error[level] ? error : lod_error[level];
+            mesh_opt_vertex_cache(destination, count, group.used, MESH_OPT_CACHE_SIZE);
+            memcpy(source, destination, count * sizeof(unsigned int));
+            mesh_group_leave(&group, destination, count);
+            lods[level * obj->group_count + g].index_offset = (uint32_t)level_counts[level];
+            lods[level * obj->group_count + g].index_count = (uint32_t)count;
+            level_counts[level] += count;
+        }
+        mesh_group_reset(&group);
+    }
+
+    mesh_group_free(&group);
+    free(source);
+    return 1;
+}
+
+// mesh_simplify_levels, then the levels that made it one after the other, malloc'd. A level that
+// doesn't get below 80% of the one before ends the chain.
+static unsigned int *
+mesh_build_lods(const obj_mesh *obj, mesh_lod *lods, float *lod_error, uint32_t *lod_count, size_t *index_count)
+{
+    *lod_count = 1;
+    *index_count = 0;
+    unsigned int *levels[MESH_MAX_LODS] = {NULL};
+    size_t level_counts[MESH_MAX_LODS] = {0};
+    if (!mesh_simplify_levels(obj, levels, level_counts, lods, lod_error)) {
+        return NULL;
+    }
+
+    size_t total = 0;
+    for (int level = 1; level < MESH_MAX_LODS; level++) {
+        total += level_counts[level];
+    }
+    unsigned int *joined = malloc((total ? total : 1) * sizeof(unsigned int));
+    size_t previous = obj->index_count;
+    for (int level = 1; joined && level < MESH_MAX_LODS && level_counts[level] <= previous * 4 / 5; level++) {
+        memcpy(joined + *index_count, levels[level], level_counts[level] * sizeof(unsigned int));
+        for (int g = 0; g < obj->group_count; g++) {
+            lods[level * obj->group_count + g].index_offset += (uint32_t)*index_count;
+        }
+        *index_count += level_counts[level];
+        previous = level_counts[level];
+        (*lod_count)++;
+    }
+    for (int level = 1; level < MESH_MAX_LODS; level++) {
+        free(levels[level]);
+    }
+    return joined;
+}
+
+// the material called name from lib (may be NULL), or obj_default_material, its texture paths added
+// to textures unless they're there already
+static void
+mesh_make_material(const char *name, const obj_material_lib *lib, mesh_material *material, mesh_texture *textures,
+                   uint32_t *texture_count)
+{
+    obj_material source;
+    int found = lib ? obj_find_material(lib, name) : -1;
+    if (found >= 0) {
+        source = lib->materials[found];
+    } else {
+        obj_default_material(&source, name);
+    }
+    memset(material, 0, sizeof(*material));
+    memcpy(material->name, source.name, MESH_NAME_LEN);
+    memcpy(material->ambient, source.ambient, sizeof(material->ambient));
+    memcpy(material->diffuse, source.diffuse, sizeof(material->diffuse));
+    memcpy(material->specular, source.specular, sizeof(material->specular));
+    memcpy(material->emissive, source.emissive, sizeof(material->emissive));
+    material->shininess = source.shininess;
+    material->opacity = source.opacity;
+    material->ior = source.ior;
+    material->illum = source.illum;
+    for (int k = 0; k < OBJ_MAP_COUNT; k++) {
+        material->maps[k] = -1;
+        if (!source.maps[k][0]) {
+            continue;
+        }
+        uint32_t t = 0;
+        while (t < *texture_count && strncmp(textures[t].path, source.maps[k], MESH_PATH_LEN)) {
+            t++;
+        }
+        if (t == *texture_count) {
+            memcpy(textures[t].path, source.maps[k], MESH_PATH_LEN);
+            (*texture_count)++;
+        }
+        material->maps[k] = (int32_t)t;
+    }
+}
+
+// one material per distinct group material, from lib or obj_default_material, and the texture paths
+// they use, each once. group_materials[g] is group g's. returns the material count, 0 on failure
+static uint32_t
+mesh_build_materials(const obj_mesh *obj, const obj_material_lib *lib, mesh_material *materials,
+                     uint32_t *group_materials, mesh_texture *textures, uint32_t *texture_count)
+{
+    uint32_t material_count = 0;
+    *texture_count = 0;
+    for (int g = 0; g < obj->group_count; g++) {
+        const char *name = obj->groups[g].material;
+        uint32_t m = 0;
+        while (m < material_count && strncmp(materials[m].name, name, MESH_NAME_LEN)) {
+            m++;
+        }
+        group_materials[g] = m;
+        if (m < material_count) {
+            continue;
+        }
+        if (material_count == 0xffff) {
+            printf("More than %d materials\n", 0xffff);
+            return 0;
+        }
+        mesh_make_material(name, lib, &materials[material_count++], textures, texture_count);
+    }
+    return material_count;
+}
+
+// a MESH_QUANTIZE vertex, the fixed point values GL normalizes on fetch
+typedef struct
+{
+    uint16_t position[3]; // [0, 1] across the mesh's bounds
+    uint16_t material;
+    int16_t normal[2];    // octahedral, [-1, 1]
+    uint16_t uv[2];       // [0, 1] across the uv bounds
+} mesh_quantized_vertex;
+
+static uint16_t
+mesh_unorm16(float x)
+{
+    x = x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f;
+    return (uint16_t)(x * 65535.0f + 0.5f);
+}
+
+static int16_t
+mesh_snorm16(float x)
+{
+    x = x > -1.0f ? (x < 1.0f ? x : 1.0f) : -1.0f;
+    return (int16_t)(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+}
+
+// the unit normal n onto the octahedron |x| + |y| + |z| = 1, the lower half folded out over
+// the upper one's diagonals, so it fits the [-1, 1] square. MESH_GLSL_DECODE undoes it
+static void
+mesh_octahedral_encode(const float *n, float *e)
+{
+    float length = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (length == 0.0f) {
+        e[0] = e[1] = 0.0f; // missing normals stay up, whatever they decode to is as good
+        return;
+    }
+    float x = n[0] / length, y = n[1] / length;
+    if (n[2] < 0.0f) {
+        float folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+    e[0] = x;
+    e[1] = y;
+}
+
+// what the vertex shader gets back out of the 16 bit values, for the error report
+static void
+mesh_octahedral_decode(const int16_t *e, float *n)
+{
+    float x = e[0] / 32767.0f, y = e[1] / 32767.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float length = sqrtf(x * x + y * y + z * z);
+    n[0] = x / length;
+    n[1] = y / length;
+    n[2] = z / length;
+}
+
+// errors[] takes the max of the position (model units), normal (degrees) and uv error
+static void
+mesh_quantize_vertex(const obj_vertex *vertex, const mesh_header *h, mesh_quantized_vertex *out, float *errors)
+{
+    for (int k = 0; k < 3; k++) {
+        float extent = h->max[k] - h->min[k];
+        out->position[k] = extent > 0.0f ? mesh_unorm16((vertex->position[k] - h->min[k]) / extent) : 0;
+        float decoded = h->min[k] + out->position[k] / 65535.0f * extent;
+        float error = fabsf(decoded - vertex->position[k]);
+        errors[0] = error > errors[0] ? error : errors[0];
+    }
+
+    float e[2], n[3];
+    mesh_octahedral_encode(vertex->normal, e);
+    out->normal[0] = mesh_snorm16(e[0]);
+    out->normal[1] = mesh_snorm16(e[1]);
+    float length = sqrtf(vertex->normal[0] * vertex->normal[0] + vertex->normal[1] * vertex->normal[1] +
+                         vertex->normal[2] * vertex->normal[2]);
+    if (length > 0.0f) {
+        mesh_octahedral_decode(out->normal, n);
+        float cosine = (n[0] * vertex->normal[0] + n[1] * vertex->normal[1] + n[2] * vertex->normal[2]) / length;
+        float degrees = acosf(cosine < 1.0f ? cosine : 1.0f) * (180.0f / 3.14159265f);
+        errors[1] = degrees > errors[1] ? degrees : errors[1];
+    }
+
+    for (int k = 0; k < 2; k++) {
+        float extent = h->uv_max[k] - h->uv_min[k];
+        out->uv[k] = extent > 0.0f ? mesh_unorm16((vertex->uv[k] - h->uv_min[k]) / extent) : 0;
+        float decoded = h->uv_min[k] + out->uv[k] / 65535.0f * extent;
+        float error = fabsf(decoded - vertex->uv[k]);
+        errors[2] = error > errors[2] ? error : errors[2];
+    }
+}
+
+// vertex stride and attributes for flags, 32 bit indices
+static void
+mesh_vertex_layout(mesh_header *h, uint32_t flags)
+{
+    mesh_attribute layout[4] = {
+        {0, MESH_FLOAT, 3, 0, offsetof(obj_vertex, position)},
+        {1, MESH_FLOAT, 3, 0, offsetof(obj_vertex, normal)},
+        {2, MESH_FLOAT, 2, 0, offsetof(obj_vertex, uv)},
+        {3, MESH_UNSIGNED_SHORT, 1, 0, sizeof(obj_vertex)},
+    };
+    mesh_attribute quantized[4] = {
+        {0, MESH_UNSIGNED_SHORT, 3, 1, offsetof(mesh_quantized_vertex, position)},
+        {1, MESH_SHORT, 2, 1, offsetof(mesh_quantized_vertex, normal)},
+        {2, MESH_UNSIGNED_SHORT, 2, 1, offsetof(mesh_quantized_vertex, uv)},
+        {3, MESH_UNSIGNED_SHORT, 1, 0, offsetof(mesh_quantized_vertex, material)},
+    };
+    h->flags = flags;
+    // and the material, uint16 plus padding
+    h->vertex_stride = flags & MESH_QUANTIZE ? sizeof(mesh_quantized_vertex) : sizeof(obj_vertex) + 4;
+    h->index_size = sizeof(uint32_t);
+    h->attribute_count = 4;
+    memcpy(h->attributes, flags & MESH_QUANTIZE ? quantized : layout, sizeof(layout));
+}
+
+// blob offsets and the file size from the counts
+static void
+mesh_layout(mesh_header *h)
+{
+    h->vertex_offset = mesh_align(sizeof(mesh_header));
+    h->index_offset = mesh_align(h->vertex_offset + (uint64_t)h->vertex_count * h->vertex_stride);
+    h->submesh_offset = mesh_align(h->index_offset + (uint64_t)h->index_count * h->index_size);
+    h->meshlet_offset = mesh_align(h->submesh_offset + (uint64_t)h->submesh_count * sizeof(mesh_submesh));
+    h->lod_offset = mesh_align(h->meshlet_offset + 10 * mesh_align((uint64_t)h->meshlet_count * 4));
+    h->material_offset = mesh_align(h->lod_offset + (uint64_t)h->lod_count * h->submesh_count * sizeof(mesh_lod));
+    h->texture_offset = mesh_align(h->material_offset + (uint64_t)h->material_count * sizeof(mesh_material));
+    h->file_size = h->texture_offset + (uint64_t)h->texture_count * sizeof(mesh_texture);
+}
+
+// points the meshlet arrays into image
+static void
+mesh_meshlet_arrays(mesh_data *m, const unsigned char *image, const mesh_header *h)
+{
+    const unsigned char *p = image + h->meshlet_offset;
+    uint64_t array_size = mesh_align((uint64_t)h->meshlet_count * 4);
+    const void *arrays[10];
+    for (int a = 0; a < 10; a++) {
+        arrays[a] = p + a * array_size;
+    }
+    m->meshlets.index_offset = arrays[0];
+    m->meshlets.index_count = arrays[1];
+    m->meshlets.x = arrays[2];
+    m->meshlets.y = arrays[3];
+    m->meshlets.z = arrays[4];
+    m->meshlets.radius = arrays[5];
+    m->meshlets.axis_x = arrays[6];
+    m->meshlets.axis_y = arrays[7];
+    m->meshlets.axis_z = arrays[8];
+    m->meshlets.cutoff = arrays[9];
+}
+
+void *
+mesh_serialize(const obj_mesh *obj, const obj_material_lib *lib, uint64_t source_hash, uint64_t source_size,
+               uint64_t material_hash, uint32_t flags, size_t *size)
+{
+    // levels of detail, meshlets and materials first, their counts size the file
+    size_t groups = obj->group_count > 0 ? (size_t)obj->group_count : 1;
+    mesh_lod *lods = calloc((size_t)MESH_MAX_LODS * (obj->group_count > 0 ? (size_t)obj->group_count : 1), sizeof(mesh_lod));
+    float lod_error[MESH_MAX_LODS] = {0};
+    uint32_t lod_count = 1;
+    size_t lod_index_count = 0;
+    unsigned int *lod_indices = lods ? mesh_build_lods(obj, lods, lod_error, &lod_count, &lod_index_count) : NULL;
+    size_t meshlet_bound = 0;
+    for (int g = 0; g < obj->group_count; g++) {
+        meshlet_bound += mesh_opt_meshlet_bound(obj->groups[g].index_count, MESH_OPT_MESHLET_VERTICES,
+                                                MESH_OPT_MESHLET_TRIANGLES);
+    }
+    mesh_opt_meshlet *meshlets = malloc((meshlet_bound ? meshlet_bound : 1) * sizeof(mesh_opt_meshlet));
+    uint32_t *group_meshlets = malloc(groups * sizeof(uint32_t));
+    mesh_material *materials = malloc(groups * sizeof(mesh_material));
+    uint32_t *group_materials = malloc(groups * sizeof(uint32_t));
+    mesh_texture *textures = malloc(groups * OBJ_MAP_COUNT * sizeof(mesh_texture));
+    uint32_t material_count = 0, texture_count = 0;
+    if (materials && group_materials && textures) {
+        material_count = mesh_build_materials(obj, lib, materials, group_materials, textures, &texture_count);
+    }
+    if (!lod_indices || !meshlets || !group_meshlets || !material_count) {
+        free(lods);
+        free(lod_indices);
+        free(meshlets);
+        free(group_meshlets);
+        free(materials);
+        free(group_materials);
+        free(textures);
+        return NULL;
+    }
+    size_t meshlet_count = 0;
+    for (int g = 0; g < obj->group_count; g++) {
+        mesh_opt_meshlet *first = meshlets + meshlet_count;
+        group_meshlets[g] = (uint32_t)mesh_opt_meshlets(first, obj->indices + obj->groups[g].index_offset,
+                                                        obj->groups[g].index_count, obj->vertices[0].position,
+                                                        sizeof(obj_vertex), MESH_OPT_MESHLET_VERTICES,
+                                                        MESH_OPT_MESHLET_TRIANGLES);
+        for (uint32_t i = 0; i < group_meshlets[g]; i++) {
+            first[i].index_offset += obj->groups[g].index_offset;
+        }
+        meshlet_count += group_meshlets[g];
+    }
+
+    mesh_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MESH_MAGIC;
+    header.version = MESH_VERSION;
+    header.source_hash = source_hash;
+    header.source_size = source_size;
+    header.material_hash = material_hash;
+    memcpy(header.mtllib, obj->mtllib, MESH_NAME_LEN);
+    header.vertex_count = obj->vertex_count;
+    mesh_vertex_layout(&header, flags);
+    header.index_count = (uint32_t)(obj->index_count + lod_index_count);
+    header.submesh_count = (uint32_t)obj->group_count;
+    header.meshlet_count = (uint32_t)meshlet_count;
+    header.lod_count = lod_count;
+    header.material_count = material_count;
+    header.texture_count = texture_count;
+    memcpy(header.lod_error, lod_error, sizeof(lod_error));
+    mesh_layout(&header);
+    memcpy(header.min, obj->min, sizeof(header.min));
+    memcpy(header.max, obj->max, sizeof(header.max));
+    for (int k = 0; k < 2; k++) {
+        header.uv_min[k] = header.uv_max[k] = obj->vertices[0].uv[k];
+    }
+    for (size_t v = 1; v < obj->vertex_count; v++) {
+        for (int k = 0; k < 2; k++) {
+            float u = obj->vertices[v].uv[k];
+            header.uv_min[k] = u < header.uv_min[k] ? u : header.uv_min[k];
+            header.uv_max[k] = u > header.uv_max[k] ? u : header.uv_max[k];
+        }
+    }
+
+
+    // calloc so the padding between blobs is zeros, not whatever the heap had
+    unsigned char *image = calloc(1, header.file_size);
+    if (!image) {
+        free(lods);
+        free(lod_indices);
+        free(meshlets);
+        free(group_meshlets);
+        free(materials);
+        free(group_materials);
+        free(textures);
+        return NULL;
+    }
+    unsigned char *vertices = image + header.vertex_offset;
+    if (flags & MESH_QUANTIZE) {
+        float errors[3] = {0.0f, 0.0f, 0.0f};
+        for (size_t v = 0; v < header.vertex_count; v++) {
+            mesh_quantized_vertex quantized_vertex;
+            memset(&quantized_vertex, 0, sizeof(quantized_vertex));
+            mesh_quantize_vertex(&obj->vertices[v], &header, &quantized_vertex, errors);
+            memcpy(vertices + v * header.vertex_stride, &quantized_vertex, sizeof(quantized_vertex));
+        }
+        header.position_error = errors[0];
+        header.normal_error = errors[1];
+        header.uv_error = errors[2];
+    } else {
+        for (size_t v = 0; v < header.vertex_count; v++) {
+            memcpy(vertices + v * header.vertex_stride, &obj->vertices[v], sizeof(obj_vertex));
+        }
+    }
+    memcpy(image, &header, sizeof(header));
+    // mesh_split_materials left every vertex in one group
+    for (int g = 0; g < obj->group_count; g++) {
+        uint16_t material = (uint16_t)group_materials[g];
+        const unsigned int *indices = obj->indices + obj->groups[g].index_offset;
+        for (size_t i = 0; i < obj->groups[g].index_count; i++) {
+            memcpy(vertices + (size_t)indices[i] * header.vertex_stride + header.attributes[3].offset, &material, 2);
+        }
+    }
+    memcpy(image + header.index_offset, obj->indices, (size_t)obj->index_count * sizeof(uint32_t));
+    memcpy(image + header.index_offset + (size_t)obj->index_count * sizeof(uint32_t), lod_indices,
+           lod_index_count * sizeof(uint32_t));
+    mesh_submesh *submeshes = (mesh_submesh *)(image + header.submesh_offset);
+    uint32_t meshlet_offset = 0;
+    for (int g = 0; g < obj->group_count; g++) {
+        memcpy(submeshes[g].object, obj->groups[g].object, MESH_NAME_LEN);
+        memcpy(submeshes[g].material, obj->groups[g].material, MESH_NAME_LEN);
+        submeshes[g].index_offset = obj->groups[g].index_offset;
+        submeshes[g].index_count = obj->groups[g].index_count;
+        submeshes[g].meshlet_offset = meshlet_offset;
+        submeshes[g].meshlet_count = group_meshlets[g];
+        submeshes[g].material_index = group_materials[g];
+        meshlet_offset += group_meshlets[g];
+        lods[g].index_offset = obj->groups[g].index_offset;
+        lods[g].index_count = obj->groups[g].index_count;
+    }
+    // levels 1 and up sit after the full mesh
+    for (size_t l = obj->group_count; l < (size_t)lod_count * obj->group_count; l++) {
+        lods[l].index_offset += obj->index_count;
+    }
+    memcpy(image + header.lod_offset, lods, (size_t)lod_count * obj->group_count * sizeof(mesh_lod));
+    memcpy(image + header.material_offset, materials, material_count * sizeof(mesh_material));
+    memcpy(image + header.texture_offset, textures, texture_count * sizeof(mesh_texture));
+    // SoA, in the order mesh_meshlet_arrays reads them back
+    unsigned char *arrays = image + header.meshlet_offset;
+    size_t array_size = (size_t)mesh_align((uint64_t)meshlet_count * 4);
+    for (size_t i = 0; i < meshlet_count; i++) {
+        const mesh_opt_meshlet *meshlet = &meshlets[i];
+        uint32_t ranges[2] = {meshlet->index_offset, meshlet->triangle_count * 3};
+        float bounds[8] = {meshlet->center[0], meshlet->center[1], meshlet->center[2], meshlet->radius,
+                           meshlet->cone_axis[0], meshlet->cone_axis[1], meshlet->cone_axis[2], meshlet->cone_cutoff};
+        for (int f = 0; f < 2; f++) {
+            memcpy(arrays + f * array_size + i * 4, &ranges[f], 4);
+        }
+        for (int f = 0; f < 8; f++) {
+            memcpy(arrays + (f + 2) * array_size + i * 4, &bounds[f], 4);
+        }
+    }
+    free(lods);
+    free(lod_indices);
+    free(meshlets);
+    free(group_meshlets);
+    free(materials);
+    free(group_materials);
+    free(textures);
+    *size = header.file_size;
+    return image;
+}
+
+int
+mesh_write(const char *path, const void *image, size_t size)
+{
+    char tmp[1024];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        return 0;
+    }
+    FILE *file = fopen(tmp, "wb");
+    if (!file) {
+        printf("Failed to write mesh cache: %s\n", path);
+        return 0;
+    }
+    int ok = fwrite(image, 1, size, file) == size;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        printf("Failed to write mesh cache: %s\n", path);
+        remove(tmp);
+        return 0;
+    }
+    return 1;
+}
+
+// an aligned blob of count items of item_size bytes at offset, inside size bytes
+static int
+mesh_blob_fits(uint64_t offset, uint64_t count, uint64_t item_size, uint64_t size)
+{
+    return offset % MESH_ALIGN == 0 && offset <= size && count <= (size - offset) / item_size;
+}
+
+static uint32_t
+mesh_type_size(uint32_t type)
+{
+    return type == MESH_FLOAT ? 4 : type == MESH_UNSIGNED_SHORT || type == MESH_SHORT ? 2 : 0;
+}
+
+// what the header says against itself and the blobs: only flags this version knows, attributes
+// inside the vertex, every range of indices, meshlets and levels of detail inside its table, every
+// material and texture number inside its table, every index below vertex_count. The blobs have to
+// fit in the image already
+static int
+mesh_image_consistent(const unsigned char *image, const mesh_header *h)
+{
+    if (h->flags & ~MESH_QUANTIZE) {
+        return 0;
+    }
+    for (uint32_t a = 0; a < h->attribute_count; a++) {
+        const mesh_attribute *attribute = &h->attributes[a];
+        uint32_t type_size = mesh_type_size(attribute->type);
+        if (!type_size || !attribute->components || attribute->components > 4 ||
+            (uint64_t)attribute->offset + attribute->components * type_size > h->vertex_stride) {
+            return 0;
+        }
+    }
+    const mesh_submesh *submeshes = (const mesh_submesh *)(image + h->submesh_offset);
+    for (uint32_t s = 0; s < h->submesh_count; s++) {
+        const mesh_submesh *submesh = &submeshes[s];
+        if ((uint64_t)submesh->index_offset + submesh->index_count > h->index_count ||
+            (uint64_t)submesh->meshlet_offset + submesh->meshlet_count > h->meshlet_count ||
+            submesh->material_index >= h->material_count) {
+            return 0;
+        }
+    }
+    const mesh_lod *lods = (const mesh_lod *)(image + h->lod_offset);
+    for (uint64_t l = 0; l < (uint64_t)h->lod_count * h->submesh_count; l++) {
+        if ((uint64_t)lods[l].index_offset + lods[l].index_count > h->index_count) {
+            return 0;
+        }
+    }
+    // the first two of the meshlet arrays, see mesh_meshlet_arrays
+    uint64_t array_size = mesh_align((uint64_t)h->meshlet_count * 4);
+    const uint32_t *meshlet_offsets = (const uint32_t *)(image + h->meshlet_offset);
+    const uint32_t *meshlet_counts = (const uint32_t *)(image + h->meshlet_offset + array_size);
+    for (uint32_t i = 0; i < h->meshlet_count; i++) {
+        if ((uint64_t)meshlet_offsets[i] + meshlet_counts[i] > h->index_count) {
+            return 0;
+        }
+    }
+    const mesh_material *materials = (const mesh_material *)(image + h->material_offset);
+    for (uint32_t i = 0; i < h->material_count; i++) {
+        for (int k = 0; k < 4; k++) {
+            if (materials[i].maps[k] < -1 || materials[i].maps[k] >= (int64_t)h->texture_count) {
+                return 0;
+            }
+        }
+    }
+    uint32_t largest = 0;
+    if (h->index_size == 4) {
+        const uint32_t *indices = (const uint32_t *)(image + h->index_offset);
+        for (uint32_t i = 0; i < h->index_count; i++) {
+            largest = indices[i] > largest ? indices[i] : largest;
+        }
+    } else {
+        const uint16_t *indices = (const uint16_t *)(image + h->index_offset);
+        for (uint32_t i = 0; i < h->index_count; i++) {
+            largest = indices[i] > largest ? indices[i] : largest;
+        }
+    }
+    return !h->index_count || largest < h->vertex_count;
+}
+
+// points m into image after checking every blob is inside it and what's in them is consistent
+static int
+mesh_from_image(mesh_data *m, const unsigned char *image, size_t size)
+{
+    const mesh_header *h = (const mesh_header *)image;
+    if (size < sizeof(mesh_header) || h->magic != MESH_MAGIC || h->version != MESH_VERSION ||
+        h->file_size != size || h->attribute_count > MESH_MAX_ATTRIBUTES || !h->vertex_stride ||
+        (h->index_size != 2 && h->index_size != 4) || !h->lod_count || h->lod_count > MESH_MAX_LODS ||
+        !mesh_blob_fits(h->vertex_offset, h->vertex_count, h->vertex_stride, size) ||
+        !mesh_blob_fits(h->index_offset, h->index_count, h->index_size, size) ||
+        !mesh_blob_fits(h->submesh_offset, h->submesh_count, sizeof(mesh_submesh), size) ||
+        !mesh_blob_fits(h->meshlet_offset, 10 * mesh_align((uint64_t)h->meshlet_count * 4), 1, size) ||
+        !mesh_blob_fits(h->lod_offset, (uint64_t)h->lod_count * h->submesh_count, sizeof(mesh_lod), size) ||
+        !mesh_blob_fits(h->material_offset, h->material_count, sizeof(mesh_material), size) ||
+        !mesh_blob_fits(h->texture_offset, h->texture_count, sizeof(mesh_texture), size) ||
+        !mesh_image_consistent(image, h)) {
+        return 0;
+    }
+    m->header = h;
+    m->vertices = image + h->vertex_offset;
+    m->indices = image + h->index_offset;
+    m->submeshes = (const mesh_submesh *)(image + h->submesh_offset);
+    m->lods = (const mesh_lod *)(image + h->lod_offset);
+    m->materials = (const mesh_material *)(image + h->material_offset);
+    m->textures = (const mesh_texture *)(image + h->texture_offset);
+    mesh_meshlet_arrays(m, image, h);
+    return 1;
+}
+
+int
+mesh_open(mesh_data *m, const char *path)
+{
+    memset(m, 0, sizeof(*m));
+    if (!asset_map(&m->file, path)) {
+        return 0;
+    }
+    if (!mesh_from_image(m, m->file.data, m->file.size)) {
+        printf("Stale or damaged mesh cache: %s\n", path);
+        mesh_close(m);
+        return 0;
+    }
+    return 1;
+}
+
+void
+mesh_close(mesh_data *m)
+{
+    if (m->file.data) {
+        asset_unmap(&m->file);
+    }
+    free(m->owned);
+    memset(m, 0, sizeof(*m));
+}
+
+// the library mtllib names, next to obj_path. 0 when there's no mtllib or no such file
+static int
+mesh_map_mtl(asset_file *file, const char *obj_path, const char *mtllib)
+{
+    if (!mtllib[0]) {
+        return 0;
+    }
+    const char *slash = strrchr(obj_path, '/');
+    int directory = slash ? (int)(slash - obj_path + 1) : 0;
+    char path[1024];
+    if (snprintf(path, sizeof(path), "%.*s%.*s", directory, obj_path, MESH_NAME_LEN, mtllib) >= (int)sizeof(path)) {
+        return 0;
+    }
+    // asset_map complains about missing files, a missing library just means default materials
+    FILE *probe = fopen(path, "rb");
+    if (!probe) {
+        return 0;
+    }
+    fclose(probe);
+    return asset_map(file, path);
+}
+
+static uint64_t
+mesh_mtl_hash(const char *obj_path, const char *mtllib)
+{
+    asset_file file;
+    if (!mesh_map_mtl(&file, obj_path, mtllib)) {
+        return 0;
+    }
+    uint64_t hash = mesh_hash(file.data, file.size);
+    asset_unmap(&file);
+    return hash;
+}
+
+int
+mesh_load_obj(mesh_data *m, const char *obj_path, int threads)
+{
+    return mesh_load_obj_flags(m, obj_path, threads, 0);
+}
+
+// where obj_path's cache baked with flags goes, 0 if it doesn't fit in size
+static int
+mesh_cache_path(char *cache_path, size_t size, const char *obj_path, uint32_t flags)
+{
+    // quantized gets its own, so it doesn't fight the float cache
+    const char *extension = flags & MESH_QUANTIZE ? "q.mesh" : "mesh";
+    return snprintf(cache_path, size, "%s.%s", obj_path, extension) < (int)size;
+}
+
+// the library mtllib names into lib, default materials (an empty lib) when there's none.
+// returns mesh_hash of its bytes, 0 without one
+static uint64_t
+mesh_load_mtl(obj_material_lib *lib, const char *obj_path, const char *mtllib)
+{
+    asset_file mtl;
+    uint64_t material_hash = 0;
+    memset(lib, 0, sizeof(*lib));
+    if (mesh_map_mtl(&mtl, obj_path, mtllib)) {
+        material_hash = mesh_hash(mtl.data, mtl.size);
+        obj_parse_mtl(lib, (const char *)mtl.data, mtl.size);
+        asset_unmap(&mtl);
+    } else if (mtllib[0]) {
+        printf("Material library %s not found, using default materials\n", mtllib);
+    }
+    return material_hash;
+}
+
+int
+mesh_load_obj_flags(mesh_data *m, const char *obj_path, int threads, uint32_t flags)
+{
+    memset(m, 0, sizeof(*m));
+    char cache_path[1024];
+    if (!mesh_cache_path(cache_path, sizeof(cache_path), obj_path, flags)) {
+        return 0;
+    }
+
+    // the hash needs the source bytes anyway, and they're what gets parsed on a miss
+    asset_file source;
+    if (!asset_map(&source, obj_path)) {
+        return 0;
+    }
+    uint64_t hash = mesh_hash(source.data, source.size);
+    uint64_t source_size = source.size;
+
+    // asset_map complains about missing files, and no cache yet is the normal first run
+    FILE *probe = fopen(cache_path, "rb");
+    if (probe) {
+        fclose(probe);
+        if (mesh_open(m, cache_path)) {
+            if (m->header->source_hash == hash && m->header->source_size == source_size && m->header->flags == flags &&
+                m->header->material_hash == mesh_mtl_hash(obj_path, m->header->mtllib)) {
+                asset_unmap(&source);
+                return 1;
+            }
+            mesh_close(m);
+        }
+    }
+
+    obj_mesh obj;
+    int ok = obj_parse_threaded(&obj, (const char *)source.data, source.size, threads);
+    asset_unmap(&source);
+    if (!ok) {
+        printf("Failed to load OBJ: %s\n", obj_path);
+        return 0;
+    }
+
+    obj_material_lib lib;
+    uint64_t material_hash = mesh_load_mtl(&lib, obj_path, obj.mtllib);
+
+    unsigned char *image = NULL;
+    size_t size;
+    if (mesh_optimize(&obj)) {
+        image = mesh_serialize(&obj, &lib, hash, source_size, material_hash, flags, &size);
+    }
+    obj_free(&obj);
+    obj_free_mtl(&lib);
+    if (!image) {
+        return 0;
+    }
+
+    // map what was written, so a hit and a miss hand back the same kind of memory
+    if (mesh_write(cache_path, image, size) && mesh_open(m, cache_path)) {
+        free(image);
+        return 1;
+    }
+    m->owned = image;
+    return mesh_from_image(m, image, size);
+}
+
+// what a chunk triangle costs mesh_convert_obj: obj_stream's share, then optimizing, simplifying
+// and cutting it into meshlets
+#define MESH_CONVERT_TRIANGLE_BYTES 400
+#define MESH_CONVERT_MAX_WINDOW (4 << 20)
+
+// obj_stream's scan, the OBJ is hashed during its first pass
+static void
+mesh_hash_scan(void *user, const void *data, size_t size)
+{
+    mesh_hash_update(user, data, size);
+}
+
+// one blob mesh_convert_obj collects in a file next to the cache while the chunks go by
+typedef struct
+{
+    FILE *file;
+    char path[1040];
+    uint64_t size;
+} mesh_spill;
+
+typedef struct
+{
+    mesh_header header; // bounds and layout up front, counts at the end
+    FILE *out;
+    uint64_t written;
+    int write_failed;
+    mesh_spill levels[MESH_MAX_LODS]; // each level of detail's indices
+    mesh_spill submeshes;             // a mesh_submesh per chunk
+    mesh_spill lods;                  // MESH_MAX_LODS - 1 mesh_lod per chunk, into levels[1...]
+    mesh_spill meshlets;              // index offset, index count and 8 bounds floats per meshlet
+    uint64_t vertex_count, meshlet_count, submesh_count;
+    char (*materials)[MESH_NAME_LEN]; // names in order of first use
+    uint32_t material_count;
+    float errors[3];                  // mesh_quantize_vertex's
+} mesh_converter;
+
+static int
+mesh_spill_open(mesh_spill *spill, const char *cache_path, const char *name)
+{
+    memset(spill, 0, sizeof(*spill));
+    if (snprintf(spill->path, sizeof(spill->path), "%s.%s.tmp", cache_path, name) >= (int)sizeof(spill->path)) {
+        spill->path[0] = '\0';
+        return 0;
+    }
+    spill->file = fopen(spill->path, "w+b");
+    if (!spill->file) {
+        printf("Failed to write mesh cache: %s\n", spill->path);
+        spill->path[0] = '\0';
+        return 0;
+    }
+    return 1;
+}
+
+static int
+mesh_spill_write(mesh_spill *spill, const void *data, size_t size)
+{
+    spill->size += size;
+    return fwrite(data, 1, size, spill->file) == size;
+}
+
+static void
+mesh_spill_close(mesh_spill *spill)
+{
+    if (spill->file) {
+        fclose(spill->file);
+    }
+    if (spill->path[0]) {
+        remove(spill->path);
+    }
+    memset(spill, 0, sizeof(*spill));
+}
+
+static int
+mesh_convert_write(mesh_converter *c, const void *data, size_t size)
+{
+    if (fwrite(data, 1, size, c->out) != size) {
+        c->write_failed = 1;
+        return 0;
+    }
+    c->written += size;
+    return 1;
+}
+
+// zeros up to offset, the padding before a blob
+static int
+mesh_convert_pad(mesh_converter *c, uint64_t offset)
+{
+    static const unsigned char zeros[MESH_ALIGN];
+    while (c->written < offset) {
+        size_t size = offset - c->written < MESH_ALIGN ? (size_t)(offset - c->written) : MESH_ALIGN;
+        if (!mesh_convert_write(c, zeros, size)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int
+mesh_convert_copy(mesh_converter *c, mesh_spill *spill)
+{
+    unsigned char buffer[1 << 16];
+    rewind(spill->file);
+    for (uint64_t left = spill->size; left;) {
+        size_t size = left < sizeof(buffer) ? (size_t)left : sizeof(buffer);
+        if (fread(buffer, 1, size, spill->file) != size) {
+            c->write_failed = 1;
+            return 0;
+        }
+        if (!mesh_convert_write(c, buffer, size)) {
+            return 0;
+        }
+        left -= size;
+    }
+    return 1;
+}
+
+// bakes one chunk the way mesh_serialize bakes a group: optimized, simplified, cut into meshlets, and
+// writes it out. Its vertices go into the cache, everything else into the spills
+static int
+mesh_convert_chunk(mesh_converter *c, obj_mesh *chunk)
+{
+    const obj_group *group = &chunk->groups[0];
+    uint32_t material = 0;
+    while (material < c->material_count && strncmp(c->materials[material], group->material, MESH_NAME_LEN)) {
+        material++;
+    }
+    if (material == c->material_count) {
+        if (material == 0xffff) {
+            printf("More than %d materials\n", 0xffff);
+            return 0;
+        }
+        char (*grown)[MESH_NAME_LEN] = realloc(c->materials, (material + 1) * sizeof(*grown));
+        if (!grown) {
+            return 0;
+        }
+        c->materials = grown;
+        memcpy(c->materials[material], group->material, MESH_NAME_LEN);
+        c->material_count++;
+    }
+
+    if (!mesh_optimize(chunk)) {
+        return 0;
+    }
+    uint64_t base = c->vertex_count, index_offset = c->levels[0].size / sizeof(uint32_t);
+    if (base + chunk->vertex_count > UINT32_MAX || index_offset + chunk->index_count > UINT32_MAX) {
+        printf("More than %u vertices or indices\n", UINT32_MAX);
+        return 0;
+    }
+
+    uint32_t stride = c->header.vertex_stride;
+    unsigned int *levels[MESH_MAX_LODS] = {NULL};
+    size_t level_counts[MESH_MAX_LODS] = {0};
+    mesh_lod lods[MESH_MAX_LODS];
+    float lod_error[MESH_MAX_LODS] = {0.0f};
+    size_t meshlet_bound = mesh_opt_meshlet_bound(chunk->index_count, MESH_OPT_MESHLET_VERTICES,
+                                                  MESH_OPT_MESHLET_TRIANGLES);
+    mesh_opt_meshlet *meshlets = malloc((meshlet_bound ? meshlet_bound : 1) * sizeof(mesh_opt_meshlet));
+    unsigned char *vertices = calloc(chunk->vertex_count, stride);
+    int ok = meshlets && vertices && mesh_simplify_levels(chunk, levels, level_counts, lods, lod_error);
+    size_t meshlet_count = 0;
+    if (ok) {
+        meshlet_count = mesh_opt_meshlets(meshlets, chunk->indices, chunk->index_count, chunk->vertices[0].position,
+                                          sizeof(obj_vertex), MESH_OPT_MESHLET_VERTICES, MESH_OPT_MESHLET_TRIANGLES);
+    }
+
+    // the vertices are the first blob, they go straight into the cache
+    uint16_t material_index = (uint16_t)material;
+    for (size_t v = 0; ok && v < chunk->vertex_count; v++) {
+        if (c->header.flags & MESH_QUANTIZE) {
+            mesh_quantized_vertex quantized_vertex;
+            memset(&quantized_vertex, 0, sizeof(quantized_vertex));
+            mesh_quantize_vertex(&chunk->vertices[v], &c->header, &quantized_vertex, c->errors);
+            memcpy(vertices + v * stride, &quantized_vertex, sizeof(quantized_vertex));
+        } else {
+            memcpy(vertices + v * stride, &chunk->vertices[v], sizeof(obj_vertex));
+        }
+        memcpy(vertices + v * stride + c->header.attributes[3].offset, &material_index, 2);
+    }
+    ok = ok && mesh_convert_write(c, vertices, (size_t)chunk->vertex_count * stride);
+
+    mesh_submesh submesh;
+    memset(&submesh, 0, sizeof(submesh));
+    memcpy(submesh.object, group->object, MESH_NAME_LEN);
+    memcpy(submesh.material, group->material, MESH_NAME_LEN);
+    submesh.index_offset = (uint32_t)index_offset;
+    submesh.index_count = chunk->index_count;
+    submesh.meshlet_offset = (uint32_t)c->meshlet_count;
+    submesh.meshlet_count = (uint32_t)meshlet_count;
+    submesh.material_index = material;
+    ok = ok && mesh_spill_write(&c->submeshes, &submesh, sizeof(submesh));
+    for (size_t i = 0; ok && i < meshlet_count; i++) {
+        const mesh_opt_meshlet *meshlet = &meshlets[i];
+        uint32_t ranges[2] = {(uint32_t)index_offset + meshlet->index_offset, meshlet->triangle_count * 3};
+        float bounds[8] = {meshlet->center[0], meshlet->center[1], meshlet->center[2], meshlet->radius,
+                           meshlet->cone_axis[0], meshlet->cone_axis[1], meshlet->cone_axis[2], meshlet->cone_cutoff};
+        ok = mesh_spill_write(&c->meshlets, ranges, sizeof(ranges)) && mesh_spill_write(&c->meshlets, bounds, sizeof(bounds));
+    }
+
+    // indices to the file's vertex numbers, each level after what the chunks before wrote of it
+    mesh_lod chunk_lods[MESH_MAX_LODS - 1];
+    levels[0] = chunk->indices;
+    level_counts[0] = chunk->index_count;
+    for (int level = 0; ok && level < MESH_MAX_LODS; level++) {
+        for (size_t i = 0; i < level_counts[level]; i++) {
+            levels[level][i] += (unsigned int)base;
+        }
+        if (level) {
+            chunk_lods[level - 1].index_offset = (uint32_t)(c->levels[level].size / sizeof(uint32_t));
+            chunk_lods[level - 1].index_count = (uint32_t)level_counts[level];
+            float *error = &c->header.lod_error[level];
+            *error = lod_error[level] > *error ? lod_error[level] : *error;
+        }
+        ok = mesh_spill_write(&c->levels[level], levels[level], level_counts[level] * sizeof(uint32_t));
+    }
+    ok = ok && mesh_spill_write(&c->lods, chunk_lods, sizeof(chunk_lods));
+
+    for (int level = 1; level < MESH_MAX_LODS; level++) {
+        free(levels[level]);
+    }
+    free(meshlets);
+    free(vertices);
+    c->vertex_count += chunk->vertex_count;
+    c->meshlet_count += meshlet_count;
+    c->submesh_count++;
+    return ok;
+}
+
+// the blobs after the vertices, copied out of the spills into place, then the header over the zeros
+// the file started with
+static int
+mesh_convert_finish(mesh_converter *c, const obj_material_lib *lib)
+{
+    mesh_header *h = &c->header;
+    // the rule mesh_build_lods has, over the whole file
+    uint32_t lod_count = 1;
+    uint64_t index_count = c->levels[0].size, previous = c->levels[0].size;
+    while (lod_count < MESH_MAX_LODS && c->levels[lod_count].size <= previous * 4 / 5) {
+        previous = c->levels[lod_count].size;
+        index_count += c->levels[lod_count++].size;
+    }
+    index_count /= sizeof(uint32_t);
+    if (index_count > UINT32_MAX || c->meshlet_count > UINT32_MAX) {
+        printf("More than %u indices\n", UINT32_MAX);
+        return 0;
+    }
+
+    mesh_material *materials = malloc(c->material_count * sizeof(mesh_material));
+    mesh_texture *textures = malloc(c->material_count * OBJ_MAP_COUNT * sizeof(mesh_texture));
+    uint32_t texture_count = 0;
+    if (!materials || !textures) {
+        free(materials);
+        free(textures);
+        return 0;
+    }
+    for (uint32_t m = 0; m < c->material_count; m++) {
+        mesh_make_material(c->materials[m], lib, &materials[m], textures, &texture_count);
+    }
+
+    h->vertex_count = (uint32_t)c->vertex_count;
+    h->index_count = (uint32_t)index_count;
+    h->submesh_count = (uint32_t)c->submesh_count;
+    h->meshlet_count = (uint32_t)c->meshlet_count;
+    h->lod_count = lod_count;
+    h->material_count = c->material_count;
+    h->texture_count = texture_count;
+    h->position_error = c->errors[0];
+    h->normal_error = c->errors[1];
+    h->uv_error = c->errors[2];
+    mesh_layout(h);
+
+    int ok = mesh_convert_pad(c, h->index_offset);
+    for (uint32_t level = 0; ok && level < lod_count; level++) {
+        ok = mesh_convert_copy(c, &c->levels[level]);
+    }
+    ok = ok && mesh_convert_pad(c, h->submesh_offset) && mesh_convert_copy(c, &c->submeshes);
+
+    // SoA, one pass over the spilled meshlets per array
+    uint32_t block[256][10];
+    uint32_t column[256];
+    uint64_t array_size = mesh_align(c->meshlet_count * 4);
+    for (int a = 0; ok && a < 10; a++) {
+        ok = mesh_convert_pad(c, h->meshlet_offset + a * array_size);
+        rewind(c->meshlets.file);
+        for (uint64_t left = c->meshlet_count; ok && left;) {
+            size_t count = left < 256 ? (size_t)left : 256;
+            ok = fread(block, sizeof(block[0]), count, c->meshlets.file) == count;
+            for (size_t i = 0; ok && i < count; i++) {
+                column[i] = block[i][a];
+            }
+            ok = ok && mesh_convert_write(c, column, count * sizeof(uint32_t));
+            left -= count;
+        }
+    }
+
+    // level 0 repeats the submesh ranges, the other levels sit after the ones before them
+    ok = ok && mesh_convert_pad(c, h->lod_offset);
+    rewind(c->submeshes.file);
+    for (uint64_t s = 0; ok && s < c->submesh_count; s++) {
+        mesh_submesh submesh;
+        ok = fread(&submesh, sizeof(submesh), 1, c->submeshes.file) == 1;
+        mesh_lod lod = {submesh.index_offset, submesh.index_count};
+        ok = ok && mesh_convert_write(c, &lod, sizeof(lod));
+    }
+    uint64_t level_offset = c->levels[0].size / sizeof(uint32_t);
+    for (uint32_t level = 1; ok && level < lod_count; level++) {
+        rewind(c->lods.file);
+        for (uint64_t s = 0; ok && s < c->submesh_count; s++) {
+            mesh_lod chunk_lods[MESH_MAX_LODS - 1];
+            ok = fread(chunk_lods, sizeof(chunk_lods), 1, c->lods.file) == 1;
+            mesh_lod lod = chunk_lods[level - 1];
+            lod.index_offset += (uint32_t)level_offset;
+            ok = ok && mesh_convert_write(c, &lod, sizeof(lod));
+        }
+        level_offset += c->levels[level].size / sizeof(uint32_t);
+    }
+
+    ok = ok && mesh_convert_pad(c, h->material_offset) &&
+         mesh_convert_write(c, materials, c->material_count * sizeof(mesh_material)) &&
+         mesh_convert_pad(c, h->texture_offset) && mesh_convert_write(c, textures, texture_count * sizeof(mesh_texture));
+    free(materials);
+    free(textures);
+    if (ok && c->written != h->file_size) {
+        ok = 0;
+    }
+    if (ok && (fseek(c->out, 0, SEEK_SET) != 0 || fwrite(h, sizeof(*h), 1, c->out) != 1)) {
+        ok = 0;
+    }
+    c->write_failed |= !ok;
+    return ok;
+}
+
+int
+mesh_convert_obj(const char *obj_path, uint32_t flags, size_t memory_limit)
+{
+    static const char *level_names[MESH_MAX_LODS] = {"i0", "i1", "i2", "i3", "i4"};
+    char cache_path[1024], tmp_path[1040];
+    if (!mesh_cache_path(cache_path, sizeof(cache_path), obj_path, flags)) {
+        return 0;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    if (memory_limit < MESH_CONVERT_MIN_MEMORY) {
+        printf("mesh_convert_obj needs at least %d MB\n", MESH_CONVERT_MIN_MEMORY >> 20);
+        return 0;
+    }
+
+    // the hash starts from the size, which has to be known before the first byte
+    FILE *probe = fopen(obj_path, "rb");
+    if (!probe) {
+        printf("Failed to open OBJ: %s\n", obj_path);
+        return 0;
+    }
+    long source_size = fseek(probe, 0, SEEK_END) == 0 ? ftell(probe) : -1;
+    fclose(probe);
+    if (source_size < 0) {
+        printf("Failed to load OBJ: %s\n", obj_path);
+        return 0;
+    }
+
+    // a fixed share for the window and the attribute cache, the rest for chunks
+    size_t window = memory_limit / 16 < MESH_CONVERT_MAX_WINDOW ? memory_limit / 16 : MESH_CONVERT_MAX_WINDOW;
+    size_t cache = memory_limit / 4;
+    size_t max_triangles = (memory_limit - window - cache) / MESH_CONVERT_TRIANGLE_BYTES;
+    mesh_hasher hasher;
+    mesh_hash_begin(&hasher, (uint64_t)source_size);
+    obj_stream stream;
+    if (!obj_stream_open(&stream, obj_path, window, cache, max_triangles, mesh_hash_scan, &hasher)) {
+        printf("Failed to load OBJ: %s\n", obj_path);
+        return 0;
+    }
+
+    obj_material_lib lib;
+    mesh_converter c;
+    memset(&c, 0, sizeof(c));
+    mesh_header *h = &c.header;
+    h->magic = MESH_MAGIC;
+    h->version = MESH_VERSION;
+    h->source_hash = mesh_hash_end(&hasher);
+    h->source_size = (uint64_t)source_size;
+    h->material_hash = mesh_load_mtl(&lib, obj_path, stream.mtllib);
+    memcpy(h->mtllib, stream.mtllib, MESH_NAME_LEN);
+    memcpy(h->min, stream.min, sizeof(h->min));
+    memcpy(h->max, stream.max, sizeof(h->max));
+    memcpy(h->uv_min, stream.uv_min, sizeof(h->uv_min));
+    memcpy(h->uv_max, stream.uv_max, sizeof(h->uv_max));
+    mesh_vertex_layout(h, flags);
+    h->vertex_offset = mesh_align(sizeof(mesh_header));
+
+    int ok = 1;
+    for (int level = 0; level < MESH_MAX_LODS; level++) {
+        ok &= mesh_spill_open(&c.levels[level], cache_path, level_names[level]);
+    }
+    ok &= mesh_spill_open(&c.submeshes, cache_path, "submeshes");
+    ok &= mesh_spill_open(&c.lods, cache_path, "lods");
+    ok &= mesh_spill_open(&c.meshlets, cache_path, "meshlets");
+    c.out = fopen(tmp_path, "wb");
+    c.write_failed = !c.out;
+    // zeros where the header goes, it's written last
+    ok = ok && c.out && mesh_convert_pad(&c, h->vertex_offset);
+
+    obj_mesh chunk;
+    int r = 0;
+    while (ok && (r = obj_stream_next(&stream, &chunk)) > 0) {
+        ok = mesh_convert_chunk(&c, &chunk);
+    }
+    ok = ok && r == 0;
+    if (ok && !c.submesh_count) {
+        printf("OBJ has no faces\n");
+        ok = 0;
+    }
+    obj_stream_close(&stream);
+    ok = ok && mesh_convert_finish(&c, &lib);
+
+    for (int level = 0; level < MESH_MAX_LODS; level++) {
+        mesh_spill_close(&c.levels[level]);
+    }
+    mesh_spill_close(&c.submeshes);
+    mesh_spill_close(&c.lods);
+    mesh_spill_close(&c.meshlets);
+    if (c.out && fclose(c.out) != 0) {
+        c.write_failed = 1;
+        ok = 0;
+    }
+    if (ok && rename(tmp_path, cache_path) != 0) {
+        c.write_failed = 1;
+        ok = 0;
+    }
+    if (!ok) {
+        if (c.write_failed) {
+            printf("Failed to write mesh cache: %s\n", cache_path);
+        }
+        remove(tmp_path);
+    }
+    obj_free_mtl(&lib);
+    free(c.materials);
+    return ok;
+}
+
+float
+mesh_lod_scale(float fov_degrees, float viewport_height, float distance, float radius)
+{
+    // HMM_Perspective maps tan(fov / 2) at distance 1 to the top edge, half the viewport
+    float near = distance - radius;
+    if (near <= 0.0f) {
+        return INFINITY; // inside the sphere, full detail
+    }
+    return viewport_height * 0.5f / (tanf(fov_degrees * (3.14159265f / 360.0f)) * near);
+}
+
+uint32_t
+mesh_lod_select(const mesh_data *m, float scale, float max_pixel_error)
+{
+    uint32_t level = m->header->lod_count - 1;
+    while (level > 0 && m->header->lod_error[level] * scale > max_pixel_error) {
+        level--;
+    }
+    return level;
+}
+
+void
+mesh_vertex_decode(const mesh_data *m, mesh_decode *decode)
+{
+    const mesh_header *h = m->header;
+    int quantized = (h->flags & MESH_QUANTIZE) != 0;
+    for (int k = 0; k < 3; k++) {
+        decode->position_offset[k] = quantized ? h->min[k] : 0.0f;
+        decode->position_scale[k] = quantized ? h->max[k] - h->min[k] : 1.0f;
+    }
+    for (int k = 0; k < 2; k++) {
+        decode->uv_offset[k] = quantized ? h->uv_min[k] : 0.0f;
+        decode->uv_scale[k] = quantized ? h->uv_max[k] - h->uv_min[k] : 1.0f;
+    }
+    decode->octahedral = quantized;
+}
+
+void
+mesh_material_table(const mesh_data *m, mesh_gpu_material *table)
+{
+    for (uint32_t i = 0; i < m->header->material_count; i++) {
+        const mesh_material *material = &m->materials[i];
+        mesh_gpu_material entry = {
+            {material->diffuse[0], material->diffuse[1], material->diffuse[2], material->opacity},
+            {material->specular[0], material->specular[1], material->specular[2], material->shininess},
+            {material->emissive[0], material->emissive[1], material->emissive[2], 0.0f},
+            {material->maps[0], material->maps[1], material->maps[2], material->maps[3]},
+        };
+        table[i] = entry;
+    }
+}
+
+uint32_t
+mesh_meshlet_commands(const mesh_data *m, uint32_t first_meshlet, const int *visible, int visible_count,
+                      uint32_t instance_count, mesh_draw_command *commands)
+{
+    const mesh_meshlets *ml = &m->meshlets;
+    uint32_t command_count = 0;
+    for (int i = 0; i < visible_count; i++) {
+        uint32_t meshlet = first_meshlet + (uint32_t)visible[i];
+        mesh_draw_command *last = command_count ? &commands[command_count - 1] : NULL;
+        if (last && last->first_index + last->count == ml->index_offset[meshlet]) {
+            last->count += ml->index_count[meshlet];
+            continue;
+        }
+        mesh_draw_command command = {ml->index_count[meshlet], instance_count, ml->index_offset[meshlet], 0, 0};
+        commands[command_count++] = command;
+    }
+    return command_count;
+}
+
+uint32_t
+mesh_meshlet_indices(const mesh_data *m, uint32_t first_meshlet, const int *visible, int visible_count,
+                     uint32_t *indices)
+{
+    const mesh_meshlets *ml = &m->meshlets;
+    uint32_t count = 0;
+    for (int i = 0; i < visible_count; i++) {
+        uint32_t meshlet = first_meshlet + (uint32_t)visible[i];
+        uint32_t offset = ml->index_offset[meshlet], n = ml->index_count[meshlet];
+        if (m->header->index_size == 4) {
+            memcpy(indices + count, (const uint32_t *)m->indices + offset, n * sizeof(uint32_t));
+        } else {
+            for (uint32_t k = 0; k < n; k++) {
+                indices[count + k] = ((const uint16_t *)m->indices)[offset + k];
+            }
+        }
+        count += n;
+    }
+    return count;
+}
+
+#ifndef MESH_NO_GL
+GLuint
+mesh_upload(const mesh_data *m, GLuint *vbo, GLuint *ibo)
+{
+    const mesh_header *h = m->header;
+    GLsizeiptr vertex_bytes = (GLsizeiptr)h->vertex_count * h->vertex_stride;
+    GLsizeiptr index_bytes = (GLsizeiptr)h->index_count * h->index_size;
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, vbo);
+    glGenBuffers(1, ibo);
+    glBindBuffer(GL_ARRAY_BUFFER, *vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *ibo);
+    // straight from the mapping, the driver's copy is the only one
+    if (GLAD_GL_VERSION_4_4) {
+        glBufferStorage(GL_ARRAY_BUFFER, vertex_bytes, m->vertices, 0);
+        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, index_bytes, m->indices, 0);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, vertex_bytes, m->vertices, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, m->indices, GL_STATIC_DRAW);
+    }
+
+    for (uint32_t a = 0; a < h->attribute_count; a++) {
+        const mesh_attribute *attribute = &h->attributes[a];
+        glEnableVertexAttribArray(attribute->location);
+        if (attribute->type != MESH_FLOAT && !attribute->normalized) {
+            glVertexAttribIPointer(attribute->location, attribute->components, attribute->type, h->vertex_stride,
+                                   (void *)(uintptr_t)attribute->offset);
+        } else {
+            glVertexAttribPointer(attribute->location, attribute->components, attribute->type,
+                                  attribute->normalized ? GL_TRUE : GL_FALSE, h->vertex_stride,
+                                  (void *)(uintptr_t)attribute->offset);
+        }
+    }
+    glBindVertexArray(0);
+    return vao;
+}
+
+void
+mesh_decode_uniforms(const mesh_data *m, GLuint program)
+{
+    mesh_decode decode;
+    mesh_vertex_decode(m, &decode);
+    glProgramUniform3fv(program, glGetUniformLocation(program, "mesh_position_offset"), 1, decode.position_offset);
+    glProgramUniform3fv(program, glGetUniformLocation(program, "mesh_position_scale"), 1, decode.position_scale);
+    glProgramUniform2fv(program, glGetUniformLocation(program, "mesh_uv_offset"), 1, decode.uv_offset);
+    glProgramUniform2fv(program, glGetUniformLocation(program, "mesh_uv_scale"), 1, decode.uv_scale);
+    glProgramUniform1i(program, glGetUniformLocation(program, "mesh_octahedral"), decode.octahedral);
+}
+
+GLuint
+mesh_upload_materials(const mesh_data *m)
+{
+    uint32_t count = m->header->material_count;
+    mesh_gpu_material *table = malloc((count ? count : 1) * sizeof(mesh_gpu_material));
+    if (!table) {
+        return 0;
+    }
+    mesh_material_table(m, table);
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    if (GLAD_GL_VERSION_4_4) {
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, count * sizeof(mesh_gpu_material), table, 0);
+    } else {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(mesh_gpu_material), table, GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    free(table);
+    return buffer;
+}
+#endif
+
+#endif // MESH_IMPLEMENTATION
@@ -0,0 +1,90 @@
+// Offline OBJ to mesh cache converter.
+//
+// Bakes each OBJ with mesh_convert_obj into the cache mesh_load_obj looks
+// for (<path>.mesh, or <path>.q.mesh with -q), streaming, so files far
+// bigger than RAM convert under a fixed memory ceiling. Prints what went
+// into the cache, the time, and the process's peak resident memory to
+// hold against the ceiling.
+//
+// usage: ./mesh_convert [-q] [-m megabytes] path.obj ...     default 256 MB
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+#define MESH_NO_GL
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t flags = 0;
+    size_t megabytes = 256;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (!strcmp(argv[first], "-q")) {
+            flags |= MESH_QUANTIZE;
+        } else if (!strcmp(argv[first], "-m") && first + 1 < argc) {
+            megabytes = (size_t)atol(argv[++first]);
+        } else {
+            printf("usage: %s [-q] [-m megabytes] path.obj ...\n", argv[0]);
+            return -1;
+        }
+    }
+    if (first == argc) {
+        printf("usage: %s [-q] [-m megabytes] path.obj ...\n", argv[0]);
+        return -1;
+    }
+
+    for (int i = first; i < argc; i++) {
+        double start = now_ms();
+        if (!mesh_convert_obj(argv[i], flags, megabytes << 20)) {
+            printf("Failed to convert %s\n", argv[i]);
+            return -1;
+        }
+        double ms = now_ms() - start;
+        // before the cache is mapped, its pages aren't the conversion's
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        char cache_path[1024];
+        snprintf(cache_path, sizeof(cache_path), "%s.%s", argv[i], flags & MESH_QUANTIZE ? "q.mesh" : "mesh");
+        mesh_data mesh;
+        if (!mesh_open(&mesh, cache_path)) {
+            return -1;
+        }
+        const mesh_header *h = mesh.header;
+        uint64_t triangle_count = 0;
+        for (uint32_t s = 0; s < h->submesh_count; s++) {
+            triangle_count += mesh.submeshes[s].index_count / 3;
+        }
+        printf("%s: %.1f MB -> %.1f MB in %.2f s (%.1f MB/s), %u submeshes, %u vertices, %llu triangles, "
+               "%u levels, %u meshlets, %u materials, peak resident %.1f MB of %zu MB\n",
+               cache_path, h->source_size / 1048576.0, h->file_size / 1048576.0, ms / 1e3,
+               h->source_size / 1048576.0 / (ms / 1e3), h->submesh_count, h->vertex_count,
+               (unsigned long long)triangle_count, h->lod_count, h->meshlet_count, h->material_count,
+               usage.ru_maxrss / 1024.0, megabytes);
+        mesh_close(&mesh);
+    }
+    return 0;
+}
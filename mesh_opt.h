@@ -0,0 +1,1047 @@
+/*
+  mesh_opt.h
+
+  Bake time triangle and vertex reordering for indexed triangle lists, so
+  meshes don't get drawn in whatever order the exporter wrote them:
+
+     mesh_opt_vertex_cache   Tipsify (Sander, Nehab, Barczak 2007): fans
+                             around vertices that are still in the post
+                             transform cache, so each vertex is shaded
+                             close to once
+     mesh_opt_overdraw       splits the cache ordered list into clusters and
+                             draws the ones facing out of the mesh first, so
+                             the depth test rejects more of what's behind
+     mesh_opt_vertex_fetch   renumbers vertices in first use order so the
+                             vertex fetch walks memory forwards
+     mesh_opt_simplify       quadric error edge collapse (Garland, Heckbert
+                             1997) down to a target triangle count, onto
+                             existing vertices so every level of detail
+                             shares one vertex buffer
+     mesh_opt_meshlets       cuts the final order into meshlets, small runs
+                             of triangles with a bounding sphere and a
+                             normal cone, so whole runs can be culled
+                             against the frustum and for facing away
+                             (cull_cones in cull.h)
+
+  and the matching measurements: ACMR (vertex shader runs per triangle,
+  0.5 is the limit for big regular meshes, 3 is no reuse at all), ATVR
+  (runs per distinct vertex, 1 is perfect), overdraw (fragments shaded per
+  covered pixel, from a small rasterizer looking along the six axes) and
+  overfetch (bytes pulled through a 64 byte line cache per vertex byte).
+
+  Do this:
+
+     #define MESH_OPT_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header.
+
+  Usage, in this order, each range that has to stay contiguous (a
+  material's triangles) on its own:
+
+     mesh_opt_vertex_cache(indices, index_count, vertex_count, MESH_OPT_CACHE_SIZE);
+     mesh_opt_overdraw(indices, index_count, positions, stride, vertex_count, MESH_OPT_CACHE_SIZE, 1.05f);
+     vertex_count = mesh_opt_vertex_fetch(vertices, stride, all_indices, all_index_count, vertex_count);
+     meshlet_count = mesh_opt_meshlets(meshlets, indices, index_count, positions, stride,
+                                       MESH_OPT_MESHLET_VERTICES, MESH_OPT_MESHLET_TRIANGLES);
+
+  positions point at the first vertex's xyz and step by stride bytes,
+  vertices are rewritten in place, vertices no index uses are dropped.
+
+  Meshlets here are contiguous ranges of the index list, cut in order, so
+  they keep the cache and overdraw order and draw with plain
+  glDrawElements / glMultiDrawElementsIndirect from the same index buffer.
+  The vertex and triangle limits are the usual mesh shader ones, they keep
+  the bounds tight, and a meshlet also ends early where the surface turns
+  (MESH_OPT_MESHLET_CONE) so its cone stays narrow enough to cull.
+*/
+
+#ifndef MESH_OPT_H
+#define MESH_OPT_H
+
+#include <stddef.h>
+
+// FIFO cache the orders are tuned for and the stats are measured with, roughly what
+// desktop GPUs have per batch
+#define MESH_OPT_CACHE_SIZE 16
+
+// meshlet limits, distinct vertices and triangles
+#define MESH_OPT_MESHLET_VERTICES 64
+#define MESH_OPT_MESHLET_TRIANGLES 124
+// cosine of how far (~37 degrees) a triangle may turn from a meshlet's mean normal before it
+// starts a new one, once the meshlet is reasonably full. Narrow cones get culled more often
+#define MESH_OPT_MESHLET_CONE 0.8f
+
+typedef struct
+{
+    float acmr;      // average cache miss ratio, misses per triangle
+    float atvr;      // average transform to vertex ratio, misses per distinct vertex
+    float overdraw;  // fragments shaded per pixel covered
+    float overfetch; // bytes fetched per vertex byte
+} mesh_opt_stats;
+
+typedef struct
+{
+    unsigned int index_offset; // into the indices the meshlets were cut from
+    unsigned int triangle_count;
+    unsigned int vertex_count;
+    float center[3], radius;
+    // every triangle's normal is within the cone around axis. cutoff is the sine of its half
+    // angle, 1 when the cone is too wide to ever face away
+    float cone_axis[3], cone_cutoff;
+} mesh_opt_meshlet;
+
+void mesh_opt_vertex_cache(unsigned int *indices, size_t index_count, size_t vertex_count, int cache_size);
+// threshold: how much worse than the cache order a cluster's ACMR may get, 1.05 = 5%
+void mesh_opt_overdraw(unsigned int *indices, size_t index_count, const float *positions, size_t stride,
+                       size_t vertex_count, int cache_size, float threshold);
+// returns the new vertex count
+size_t mesh_opt_vertex_fetch(void *vertices, size_t stride, unsigned int *indices, size_t index_count,
+                             size_t vertex_count);
+// writes a simplified copy of indices to destination (room for index_count), stops once it has
+// target_index_count or fewer or nothing more can collapse. *error is the largest collapse error,
+// the area weighted RMS distance of the merged surface from its original planes, in position
+// units. returns the new index count
+size_t mesh_opt_simplify(unsigned int *destination, const unsigned int *indices, size_t index_count,
+                         const float *positions, size_t stride, size_t vertex_count, size_t target_index_count,
+                         float *error);
+// the most meshlets mesh_opt_meshlets can write for index_count indices
+size_t mesh_opt_meshlet_bound(size_t index_count, int max_vertices, int max_triangles);
+// returns how many meshlets were written
+size_t mesh_opt_meshlets(mesh_opt_meshlet *meshlets, const unsigned int *indices, size_t index_count,
+                         const float *positions, size_t stride, int max_vertices, int max_triangles);
+
+mesh_opt_stats mesh_opt_analyze(const unsigned int *indices, size_t index_count, const float *positions,
+                                size_t stride, size_t vertex_count, int cache_size);
+
+#endif // MESH_OPT_H
+
+#ifdef MESH_OPT_IMPLEMENTATION
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const float *
+mesh_opt_position(const float *positions, size_t stride, unsigned int v)
+{
+    return (const float *)((const char *)positions + v * stride);
+}
+
+// misses of each triangle through a FIFO cache, timestamps instead of a queue:
+// a vertex is cached while fewer than cache_size others entered after it
+static int
+mesh_opt_misses(const unsigned int *t, unsigned int *stamps, unsigned int *clock, int cache_size)
+{
+    int misses = 0;
+    for (int k = 0; k < 3; k++) {
+        if (*clock - stamps[t[k]] >= (unsigned int)cache_size) {
+            stamps[t[k]] = ++*clock;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+// triangles touching each vertex, CSR: adjacency[offsets[v] .. offsets[v + 1])
+static int
+mesh_opt_adjacency(const unsigned int *indices, size_t index_count, size_t vertex_count,
+                   unsigned int **offsets, unsigned int **adjacency)
+{
+    *offsets = calloc(vertex_count + 1, sizeof(unsigned int));
+    *adjacency = malloc((index_count ? index_count : 1) * sizeof(unsigned int));
+    if (!*offsets || !*adjacency) {
+        free(*offsets);
+        free(*adjacency);
+        return 0;
+    }
+    for (size_t i = 0; i < index_count; i++) {
+        (*offsets)[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertex_count; v++) {
+        (*offsets)[v + 1] += (*offsets)[v];
+    }
+    unsigned int *fill = malloc((vertex_count ? vertex_count : 1) * sizeof(unsigned int));
+    if (!fill) {
+        free(*offsets);
+        free(*adjacency);
+        return 0;
+    }
+    memcpy(fill, *offsets, vertex_count * sizeof(unsigned int));
+    for (size_t i = 0; i < index_count; i++) {
+        (*adjacency)[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+    free(fill);
+    return 1;
+}
+
+void
+mesh_opt_vertex_cache(unsigned int *indices, size_t index_count, size_t vertex_count, int cache_size)
+{
+    size_t triangle_count = index_count / 3;
+    unsigned int *offsets, *adjacency;
+    if (!triangle_count || !mesh_opt_adjacency(indices, index_count, vertex_count, &offsets, &adjacency)) {
+        return;
+    }
+    unsigned int *live = malloc(vertex_count * sizeof(unsigned int));    // triangles not emitted yet
+    unsigned int *stamps = calloc(vertex_count, sizeof(unsigned int));   // when it entered the cache
+    unsigned int *dead_end = malloc(index_count * sizeof(unsigned int)); // recently used, to restart from
+    unsigned int *candidates = malloc(index_count * sizeof(unsigned int));
+    unsigned char *emitted = calloc(triangle_count, 1);
+    unsigned int *out = malloc(index_count * sizeof(unsigned int));
+    if (!live || !stamps || !dead_end || !candidates || !emitted || !out) {
+        free(live);
+        free(stamps);
+        free(dead_end);
+        free(candidates);
+        free(emitted);
+        free(out);
+        free(offsets);
+        free(adjacency);
+        return;
+    }
+    for (size_t v = 0; v < vertex_count; v++) {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+
+    unsigned int clock = (unsigned int)cache_size + 1;
+    size_t dead_end_count = 0, out_count = 0, cursor = 0;
+    long fan = -1;
+    for (size_t v = 0; v < vertex_count && fan < 0; v++) {
+        fan = live[v] ? (long)v : -1;
+    }
+
+    while (fan >= 0) {
+        // emit everything around the fanning vertex
+        size_t candidate_count = 0;
+        for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; a++) {
+            unsigned int t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                out[out_count++] = v;
+                dead_end[dead_end_count++] = v;
+                candidates[candidate_count++] = v;
+                live[v]--;
+                // the same FIFO as mesh_opt_misses, so the ACMR it reports is of the cache targeted here
+                if (clock - stamps[v] >= (unsigned int)cache_size) {
+                    stamps[v] = ++clock;
+                }
+            }
+        }
+
+        // next: the candidate that stays in the cache longest while its remaining fan is emitted,
+        // a cached one with live triangles otherwise
+        long best = -1;
+        long best_priority = -1;
+        for (size_t c = 0; c < candidate_count; c++) {
+            unsigned int v = candidates[c];
+            if (!live[v]) {
+                continue;
+            }
+            long priority = 0;
+            long age = (long)(clock - stamps[v]) + 1; // its place in the cache, 1 for the newest
+            if (age + 2 * (long)live[v] <= cache_size) {
+                priority = age;
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                best = v;
+            }
+        }
+        if (best < 0) {
+            // dead end: the most recently used vertex with work left, then the input order
+            while (dead_end_count && best < 0) {
+                unsigned int v = dead_end[--dead_end_count];
+                best = live[v] ? (long)v : -1;
+            }
+            for (; best < 0 && cursor < vertex_count; cursor++) {
+                best = live[cursor] ? (long)cursor : -1;
+            }
+        }
+        fan = best;
+    }
+
+    memcpy(indices, out, out_count * sizeof(unsigned int));
+    free(live);
+    free(stamps);
+    free(dead_end);
+    free(candidates);
+    free(emitted);
+    free(out);
+    free(offsets);
+    free(adjacency);
+}
+
+typedef struct
+{
+    size_t begin, end; // triangles
+    float key;
+} mesh_opt_cluster;
+
+static int
+mesh_opt_compare_cluster(const void *a, const void *b)
+{
+    const mesh_opt_cluster *x = a, *y = b;
+    // outward first, input order on ties so the result doesn't depend on qsort
+    if (x->key != y->key) {
+        return x->key > y->key ? -1 : 1;
+    }
+    return x->begin < y->begin ? -1 : x->begin > y->begin;
+}
+
+static void
+mesh_opt_triangle(const unsigned int *t, const float *positions, size_t stride, float *centroid, float *normal)
+{
+    const float *a = mesh_opt_position(positions, stride, t[0]);
+    const float *b = mesh_opt_position(positions, stride, t[1]);
+    const float *c = mesh_opt_position(positions, stride, t[2]);
+    float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    for (int k = 0; k < 3; k++) {
+        centroid[k] = (a[k] + b[k] + c[k]) / 3.0f;
+    }
+}
+
+void
+mesh_opt_overdraw(unsigned int *indices, size_t index_count, const float *positions, size_t stride,
+                  size_t vertex_count, int cache_size, float threshold)
+{
+    size_t triangle_count = index_count / 3;
+    unsigned int *stamps = calloc(vertex_count ? vertex_count : 1, sizeof(unsigned int));
+    unsigned char *misses = malloc(triangle_count ? triangle_count : 1);
+    mesh_opt_cluster *clusters = malloc((triangle_count ? triangle_count : 1) * sizeof(mesh_opt_cluster));
+    unsigned int *out = malloc((index_count ? index_count : 1) * sizeof(unsigned int));
+    if (!triangle_count || !stamps || !misses || !clusters || !out) {
+        free(stamps);
+        free(misses);
+        free(clusters);
+        free(out);
+        return;
+    }
+
+    // hard boundaries where the cache order jumped: all three vertices missed
+    unsigned int clock = (unsigned int)cache_size + 1;
+    size_t hard_count = 0;
+    for (size_t t = 0; t < triangle_count; t++) {
+        misses[t] = (unsigned char)mesh_opt_misses(&indices[t * 3], stamps, &clock, cache_size);
+        if (t == 0 || misses[t] == 3) {
+            clusters[hard_count].begin = t;
+            if (hard_count) {
+                clusters[hard_count - 1].end = t;
+            }
+            hard_count++;
+        }
+    }
+    clusters[hard_count - 1].end = triangle_count;
+
+    // soft boundaries: cut a hard cluster as soon as the part so far, replayed through a cold
+    // cache, is within threshold of the whole cluster's ACMR
+    size_t cluster_count = 0;
+    mesh_opt_cluster *soft = malloc(triangle_count * sizeof(mesh_opt_cluster));
+    if (!soft) {
+        free(stamps);
+        free(misses);
+        free(clusters);
+        free(out);
+        return;
+    }
+    for (size_t h = 0; h < hard_count; h++) {
+        size_t begin = clusters[h].begin, end = clusters[h].end;
+        size_t cluster_misses = 0;
+        for (size_t t = begin; t < end; t++) {
+            cluster_misses += misses[t];
+        }
+        float limit = threshold * (float)cluster_misses / (float)(end - begin);
+
+        size_t start = begin, running = 0;
+        clock += (unsigned int)cache_size + 1; // cold cache
+        for (size_t t = begin; t < end; t++) {
+            running += mesh_opt_misses(&indices[t * 3], stamps, &clock, cache_size);
+            if ((float)running / (float)(t - start + 1) <= limit && t + 1 < end) {
+                soft[cluster_count].begin = start;
+                soft[cluster_count++].end = t + 1;
+                start = t + 1;
+                running = 0;
+                clock += (unsigned int)cache_size + 1;
+            }
+        }
+        soft[cluster_count].begin = start;
+        soft[cluster_count++].end = end;
+    }
+
+    // sort key: how far the cluster's area weighted centroid sits along its own average normal,
+    // measured from the centroid of the whole range
+    float mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+    float mesh_area = 0.0f;
+    for (size_t t = 0; t < triangle_count; t++) {
+        float centroid[3], normal[3];
+        mesh_opt_triangle(&indices[t * 3], positions, stride, centroid, normal);
+        float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int k = 0; k < 3; k++) {
+            mesh_centroid[k] += centroid[k] * area;
+        }
+        mesh_area += area;
+    }
+    for (int k = 0; k < 3; k++) {
+        mesh_centroid[k] = mesh_area > 0.0f ? mesh_centroid[k] / mesh_area : 0.0f;
+    }
+    for (size_t c = 0; c < cluster_count; c++) {
+        float cluster_centroid[3] = {0.0f, 0.0f, 0.0f}, cluster_normal[3] = {0.0f, 0.0f, 0.0f};
+        float cluster_area = 0.0f;
+        for (size_t t = soft[c].begin; t < soft[c].end; t++) {
+            float centroid[3], normal[3];
+            mesh_opt_triangle(&indices[t * 3], positions, stride, centroid, normal);
+            float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (int k = 0; k < 3; k++) {
+                cluster_centroid[k] += centroid[k] * area;
+                cluster_normal[k] += normal[k];
+            }
+            cluster_area += area;
+        }
+        float length = sqrtf(cluster_normal[0] * cluster_normal[0] + cluster_normal[1] * cluster_normal[1] +
+                             cluster_normal[2] * cluster_normal[2]);
+        float key = 0.0f;
+        if (cluster_area > 0.0f && length > 0.0f) {
+            for (int k = 0; k < 3; k++) {
+                key += (cluster_centroid[k] / cluster_area - mesh_centroid[k]) * cluster_normal[k] / length;
+            }
+        }
+        soft[c].key = key;
+    }
+    qsort(soft, cluster_count, sizeof(mesh_opt_cluster), mesh_opt_compare_cluster);
+
+    size_t out_count = 0;
+    for (size_t c = 0; c < cluster_count; c++) {
+        size_t bytes = (soft[c].end - soft[c].begin) * 3 * sizeof(unsigned int);
+        memcpy(&out[out_count], &indices[soft[c].begin * 3], bytes);
+        out_count += (soft[c].end - soft[c].begin) * 3;
+    }
+    memcpy(indices, out, out_count * sizeof(unsigned int));
+    free(stamps);
+    free(misses);
+    free(clusters);
+    free(soft);
+    free(out);
+}
+
+size_t
+mesh_opt_vertex_fetch(void *vertices, size_t stride, unsigned int *indices, size_t index_count, size_t vertex_count)
+{
+    unsigned int *remap = malloc((vertex_count ? vertex_count : 1) * sizeof(unsigned int));
+    unsigned char *reordered = malloc((vertex_count ? vertex_count : 1) * stride);
+    if (!remap || !reordered) {
+        free(remap);
+        free(reordered);
+        return vertex_count;
+    }
+    memset(remap, 0xff, vertex_count * sizeof(unsigned int));
+    size_t next = 0;
+    for (size_t i = 0; i < index_count; i++) {
+        unsigned int v = indices[i];
+        if (remap[v] == 0xffffffffu) {
+            remap[v] = (unsigned int)next;
+            memcpy(reordered + next * stride, (const char *)vertices + v * stride, stride);
+            next++;
+        }
+        indices[i] = remap[v];
+    }
+    memcpy(vertices, reordered, next * stride);
+    free(remap);
+    free(reordered);
+    return next;
+}
+
+// symmetric 4x4 quadric, xx xy xz xw yy yz yw zz zw ww, and the summed weight of its planes
+typedef struct
+{
+    double q[10];
+    double weight;
+} mesh_opt_quadric;
+
+static void
+mesh_opt_add_plane(mesh_opt_quadric *quadric, double a, double b, double c, double d, double weight)
+{
+    double plane[4] = {a, b, c, d};
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++) {
+            quadric->q[k++] += plane[i] * plane[j] * weight;
+        }
+    }
+    quadric->weight += weight;
+}
+
+static double
+mesh_opt_quadric_error(const mesh_opt_quadric *a, const mesh_opt_quadric *b, const float *p)
+{
+    double v[4] = {p[0], p[1], p[2], 1.0};
+    double sum = 0.0;
+    int k = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++, k++) {
+            sum += (a->q[k] + b->q[k]) * v[i] * v[j] * (i == j ? 1.0 : 2.0);
+        }
+    }
+    return sum > 0.0 ? sum : 0.0;
+}
+
+typedef struct
+{
+    unsigned int from, to;
+    double cost;  // squared distances to the planes times their weights
+    double error; // weighted mean distance to the planes
+} mesh_opt_collapse;
+
+static int
+mesh_opt_compare_collapse(const void *a, const void *b)
+{
+    const mesh_opt_collapse *x = a, *y = b;
+    if (x->cost != y->cost) {
+        return x->cost < y->cost ? -1 : 1;
+    }
+    return x->from < y->from ? -1 : x->from > y->from;
+}
+
+static int
+mesh_opt_compare_edge(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+// the first vertex with the same position as each vertex, so split normals and uv seams
+// collapse together
+static void
+mesh_opt_position_remap(unsigned int *remap, const float *positions, size_t stride, size_t vertex_count)
+{
+    size_t size = 1;
+    while (size < vertex_count * 2) {
+        size *= 2;
+    }
+    unsigned int *table = malloc(size * sizeof(unsigned int));
+    if (!table) {
+        for (size_t v = 0; v < vertex_count; v++) {
+            remap[v] = (unsigned int)v;
+        }
+        return;
+    }
+    memset(table, 0xff, size * sizeof(unsigned int));
+    for (size_t v = 0; v < vertex_count; v++) {
+        const float *p = mesh_opt_position(positions, stride, (unsigned int)v);
+        unsigned int bits[3];
+        memcpy(bits, p, sizeof(bits));
+        size_t slot = ((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u)) & (size - 1);
+        while (table[slot] != 0xffffffffu &&
+               memcmp(mesh_opt_position(positions, stride, table[slot]), p, 3 * sizeof(float))) {
+            slot = (slot + 1) & (size - 1);
+        }
+        if (table[slot] == 0xffffffffu) {
+            table[slot] = (unsigned int)v;
+        }
+        remap[v] = table[slot];
+    }
+    free(table);
+}
+
+// 1 if moving from onto to leaves every other triangle around from facing the same way
+static int
+mesh_opt_keeps_facing(const unsigned int *positions_of, const unsigned int *indices, const unsigned int *offsets,
+                      const unsigned int *adjacency, const float *positions, size_t stride, unsigned int from,
+                      unsigned int to)
+{
+    for (unsigned int a = offsets[from]; a < offsets[from + 1]; a++) {
+        const unsigned int *t = indices + adjacency[a] * 3;
+        unsigned int corners[3] = {positions_of[t[0]], positions_of[t[1]], positions_of[t[2]]};
+        if (corners[0] == to || corners[1] == to || corners[2] == to) {
+            continue; // collapses away
+        }
+        float centroid[3], before[3], after[3];
+        mesh_opt_triangle(corners, positions, stride, centroid, before);
+        for (int k = 0; k < 3; k++) {
+            corners[k] = corners[k] == from ? to : corners[k];
+        }
+        mesh_opt_triangle(corners, positions, stride, centroid, after);
+        if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0f) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+size_t
+mesh_opt_simplify(unsigned int *destination, const unsigned int *indices, size_t index_count,
+                  const float *positions, size_t stride, size_t vertex_count, size_t target_index_count,
+                  float *error)
+{
+    // planes are weighted by triangle area. Border edges (one triangle, no twin going the other
+    // way) get a plane standing on them, weighted by this times the edge's length squared, so
+    // holes and open ends keep their outline
+    const double border_weight = 10.0;
+
+    memcpy(destination, indices, index_count * sizeof(unsigned int));
+    size_t count = index_count - index_count % 3;
+    double worst = 0.0;
+    unsigned int *positions_of = malloc((vertex_count ? vertex_count : 1) * sizeof(unsigned int));
+    unsigned int *collapse_to = malloc((vertex_count ? vertex_count : 1) * sizeof(unsigned int));
+    unsigned int *remap = malloc((vertex_count ? vertex_count : 1) * sizeof(unsigned int));
+    unsigned char *locked = malloc(vertex_count ? vertex_count : 1);
+    mesh_opt_quadric *quadrics = calloc(vertex_count ? vertex_count : 1, sizeof(mesh_opt_quadric));
+    unsigned int *corners = malloc((count ? count : 1) * sizeof(unsigned int));
+    unsigned long long *edges = malloc((count ? count : 1) * sizeof(unsigned long long));
+    mesh_opt_collapse *collapses = malloc((count ? count : 1) * sizeof(mesh_opt_collapse));
+    if (!positions_of || !collapse_to || !remap || !locked || !quadrics || !corners || !edges || !collapses) {
+        free(positions_of);
+        free(collapse_to);
+        free(remap);
+        free(locked);
+        free(quadrics);
+        free(corners);
+        free(edges);
+        free(collapses);
+        *error = 0.0f;
+        return count;
+    }
+    mesh_opt_position_remap(positions_of, positions, stride, vertex_count);
+
+    // face planes, and the edges to find borders by
+    for (size_t i = 0; i < count; i++) {
+        corners[i] = positions_of[destination[i]];
+    }
+    for (size_t i = 0; i < count; i++) {
+        unsigned int a = corners[i], b = corners[i - i % 3 + (i + 1) % 3];
+        edges[i] = (unsigned long long)a << 32 | b;
+    }
+    qsort(edges, count, sizeof(unsigned long long), mesh_opt_compare_edge);
+    for (size_t i = 0; i < count; i += 3) {
+        float centroid[3], normal[3];
+        mesh_opt_triangle(corners + i, positions, stride, centroid, normal);
+        double length = sqrt((double)normal[0] * normal[0] + (double)normal[1] * normal[1] + (double)normal[2] * normal[2]);
+        if (length == 0.0) {
+            continue;
+        }
+        double n[3] = {normal[0] / length, normal[1] / length, normal[2] / length};
+        const float *p = mesh_opt_position(positions, stride, corners[i]);
+        double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+        for (int k = 0; k < 3; k++) {
+            mesh_opt_add_plane(&quadrics[corners[i + k]], n[0], n[1], n[2], d, length * 0.5);
+        }
+        for (int k = 0; k < 3; k++) {
+            unsigned int a = corners[i + k], b = corners[i + (k + 1) % 3];
+            unsigned long long twin = (unsigned long long)b << 32 | a;
+            if (bsearch(&twin, edges, count, sizeof(unsigned long long), mesh_opt_compare_edge)) {
+                continue;
+            }
+            const float *pa = mesh_opt_position(positions, stride, a), *pb = mesh_opt_position(positions, stride, b);
+            double e[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+            double side[3] = {e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0]};
+            double side_length = sqrt(side[0] * side[0] + side[1] * side[1] + side[2] * side[2]);
+            if (side_length == 0.0) {
+                continue;
+            }
+            for (int j = 0; j < 3; j++) {
+                side[j] /= side_length;
+            }
+            double side_d = -(side[0] * pa[0] + side[1] * pa[1] + side[2] * pa[2]);
+            double weight = border_weight * (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+            mesh_opt_add_plane(&quadrics[a], side[0], side[1], side[2], side_d, weight);
+            mesh_opt_add_plane(&quadrics[b], side[0], side[1], side[2], side_d, weight);
+        }
+    }
+
+    // passes of the cheapest collapses that don't touch each other, until the target is met
+    while (count > target_index_count) {
+        for (size_t i = 0; i < count; i++) {
+            corners[i] = positions_of[destination[i]];
+        }
+        size_t edge_count = 0;
+        for (size_t i = 0; i < count; i++) {
+            unsigned int a = corners[i], b = corners[i - i % 3 + (i + 1) % 3];
+            if (a != b) {
+                edges[edge_count++] = a < b ? (unsigned long long)a << 32 | b : (unsigned long long)b << 32 | a;
+            }
+        }
+        qsort(edges, edge_count, sizeof(unsigned long long), mesh_opt_compare_edge);
+        size_t collapse_count = 0;
+        for (size_t e = 0; e < edge_count; e++) {
+            if (e && edges[e] == edges[e - 1]) {
+                continue;
+            }
+            unsigned int a = (unsigned int)(edges[e] >> 32), b = (unsigned int)edges[e];
+            double onto_b = mesh_opt_quadric_error(&quadrics[a], &quadrics[b], mesh_opt_position(positions, stride, b));
+            double onto_a = mesh_opt_quadric_error(&quadrics[a], &quadrics[b], mesh_opt_position(positions, stride, a));
+            mesh_opt_collapse collapse = {a, b, onto_b, 0.0};
+            if (onto_a < onto_b) {
+                collapse.from = b;
+                collapse.to = a;
+                collapse.cost = onto_a;
+            }
+            double weight = quadrics[a].weight + quadrics[b].weight;
+            collapse.error = weight > 0.0 ? sqrt(collapse.cost / weight) : 0.0;
+            collapses[collapse_count++] = collapse;
+        }
+        qsort(collapses, collapse_count, sizeof(mesh_opt_collapse), mesh_opt_compare_collapse);
+
+        unsigned int *offsets, *adjacency;
+        if (!mesh_opt_adjacency(corners, count, vertex_count, &offsets, &adjacency)) {
+            break;
+        }
+        memset(locked, 0, vertex_count);
+        for (size_t v = 0; v < vertex_count; v++) {
+            collapse_to[v] = (unsigned int)v;
+        }
+        // an interior collapse takes two triangles with it
+        size_t wanted = (count - target_index_count + 5) / 6, done = 0;
+        for (size_t c = 0; c < collapse_count && done < wanted; c++) {
+            unsigned int from = collapses[c].from, to = collapses[c].to;
+            if (locked[from] || locked[to] ||
+                !mesh_opt_keeps_facing(positions_of, destination, offsets, adjacency, positions, stride, from, to)) {
+                continue;
+            }
+            collapse_to[from] = to;
+            for (int k = 0; k < 10; k++) {
+                quadrics[to].q[k] += quadrics[from].q[k];
+            }
+            quadrics[to].weight += quadrics[from].weight;
+            worst = collapses[c].error > worst ? collapses[c].error : worst;
+            done++;
+            // the triangles around both ends changed, nothing else in this pass may use them
+            unsigned int ends[2] = {from, to};
+            for (int end = 0; end < 2; end++) {
+                for (unsigned int a = offsets[ends[end]]; a < offsets[ends[end] + 1]; a++) {
+                    for (int k = 0; k < 3; k++) {
+                        locked[corners[adjacency[a] * 3 + k]] = 1;
+                    }
+                }
+            }
+        }
+        free(offsets);
+        free(adjacency);
+        if (!done) {
+            break;
+        }
+
+        // a vertex at a collapsed position moves to the vertex across the collapsed edge in its
+        // own triangle where there is one, so it keeps its normal and uv side of a seam
+        for (size_t i = 0; i < count; i++) {
+            remap[destination[i]] = destination[i];
+        }
+        for (size_t i = 0; i < count; i++) {
+            unsigned int a = destination[i];
+            for (int k = 1; k < 3; k++) {
+                unsigned int b = destination[i - i % 3 + (i + k) % 3];
+                if (collapse_to[positions_of[a]] == positions_of[b] && positions_of[a] != positions_of[b]) {
+                    remap[a] = b;
+                }
+            }
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i += 3) {
+            unsigned int t[3];
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = destination[i + k];
+                unsigned int p = collapse_to[positions_of[v]];
+                t[k] = remap[v] != v || p == positions_of[v] ? remap[v] : p;
+            }
+            unsigned int p0 = positions_of[t[0]], p1 = positions_of[t[1]], p2 = positions_of[t[2]];
+            if (p0 != p1 && p1 != p2 && p0 != p2) {
+                memcpy(destination + kept, t, sizeof(t));
+                kept += 3;
+            }
+        }
+        count = kept;
+    }
+
+    free(positions_of);
+    free(collapse_to);
+    free(remap);
+    free(locked);
+    free(quadrics);
+    free(corners);
+    free(edges);
+    free(collapses);
+    *error = (float)worst;
+    return count;
+}
+
+size_t
+mesh_opt_meshlet_bound(size_t index_count, int max_vertices, int max_triangles)
+{
+    // a meshlet is only closed early when the next triangle could bring more vertices than
+    // fit or turns away, both only once it holds max_vertices / 3 triangles
+    size_t least = (size_t)(max_vertices / 3 < max_triangles ? max_vertices / 3 : max_triangles);
+    return index_count / 3 / (least ? least : 1) + 1;
+}
+
+static void
+mesh_opt_meshlet_bounds(mesh_opt_meshlet *meshlet, const unsigned int *indices, const float *positions,
+                        size_t stride, const unsigned int *vertices)
+{
+    // sphere around the box center, not the smallest one, but a meshlet is small and compact
+    float lo[3] = {INFINITY, INFINITY, INFINITY}, hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (unsigned int v = 0; v < meshlet->vertex_count; v++) {
+        const float *p = mesh_opt_position(positions, stride, vertices[v]);
+        for (int k = 0; k < 3; k++) {
+            lo[k] = p[k] < lo[k] ? p[k] : lo[k];
+            hi[k] = p[k] > hi[k] ? p[k] : hi[k];
+        }
+    }
+    float radius_squared = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        meshlet->center[k] = (lo[k] + hi[k]) * 0.5f;
+    }
+    for (unsigned int v = 0; v < meshlet->vertex_count; v++) {
+        const float *p = mesh_opt_position(positions, stride, vertices[v]);
+        float dx = p[0] - meshlet->center[0], dy = p[1] - meshlet->center[1], dz = p[2] - meshlet->center[2];
+        float d = dx * dx + dy * dy + dz * dz;
+        radius_squared = d > radius_squared ? d : radius_squared;
+    }
+    // a hair bigger so rounding in the cull test can't drop a vertex on the surface
+    meshlet->radius = sqrtf(radius_squared) * 1.0001f;
+
+    // axis is the mean of the unit normals, the half angle comes from the one furthest from it.
+    // degenerate triangles are never rasterized so they don't constrain the cone
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (unsigned int t = 0; t < meshlet->triangle_count; t++) {
+        float centroid[3], normal[3];
+        mesh_opt_triangle(indices + t * 3, positions, stride, centroid, normal);
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int k = 0; length > 0.0f && k < 3; k++) {
+            axis[k] += normal[k] / length;
+        }
+    }
+    float axis_length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float min_dot = -1.0f;
+    if (axis_length > 0.0f) {
+        min_dot = 1.0f;
+        for (int k = 0; k < 3; k++) {
+            axis[k] /= axis_length;
+        }
+        for (unsigned int t = 0; t < meshlet->triangle_count; t++) {
+            float centroid[3], normal[3];
+            mesh_opt_triangle(indices + t * 3, positions, stride, centroid, normal);
+            float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            float d = normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2];
+            if (length > 0.0f && d < min_dot * length) {
+                min_dot = d / length;
+            }
+        }
+    }
+    memcpy(meshlet->cone_axis, axis, sizeof(axis));
+    // past ~85 degrees the camera would have to be almost in the triangles' planes, keep it
+    meshlet->cone_cutoff = min_dot > 0.1f ? sqrtf(1.0f - min_dot * min_dot) : 1.0f;
+}
+
+// the vertices of t that aren't in vertices[0 .. count) yet, each once
+static int
+mesh_opt_fresh(const unsigned int *t, const unsigned int *vertices, unsigned int count, unsigned int *fresh)
+{
+    int fresh_count = 0;
+    for (int k = 0; k < 3; k++) {
+        // the meshlet's vertices are few enough that a linear search beats any table
+        int seen = 0;
+        for (unsigned int v = 0; v < count && !seen; v++) {
+            seen = vertices[v] == t[k];
+        }
+        for (int f = 0; f < fresh_count && !seen; f++) {
+            seen = fresh[f] == t[k];
+        }
+        if (!seen) {
+            fresh[fresh_count++] = t[k];
+        }
+    }
+    return fresh_count;
+}
+
+size_t
+mesh_opt_meshlets(mesh_opt_meshlet *meshlets, const unsigned int *indices, size_t index_count,
+                  const float *positions, size_t stride, int max_vertices, int max_triangles)
+{
+    unsigned int vertices[256] = {0};
+    if (max_vertices > 256) {
+        max_vertices = 256;
+    }
+    size_t meshlet_count = 0;
+    mesh_opt_meshlet *current = NULL;
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i + 3 <= index_count; i += 3) {
+        unsigned int fresh[3];
+        int fresh_count = mesh_opt_fresh(indices + i, vertices, current ? current->vertex_count : 0, fresh);
+        // a triangle turning away from the meshlet's normals would widen its cone
+        float centroid[3], normal[3];
+        mesh_opt_triangle(indices + i, positions, stride, centroid, normal);
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float axis_length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        float along = normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2];
+        int turns = current && current->triangle_count >= (unsigned int)(max_vertices / 3) &&
+                    along < MESH_OPT_MESHLET_CONE * length * axis_length;
+        if (!current || current->vertex_count + fresh_count > (unsigned int)max_vertices ||
+            current->triangle_count == (unsigned int)max_triangles || turns) {
+            if (current) {
+                mesh_opt_meshlet_bounds(current, indices + current->index_offset, positions, stride, vertices);
+            }
+            current = &meshlets[meshlet_count++];
+            memset(current, 0, sizeof(*current));
+            current->index_offset = (unsigned int)i;
+            fresh_count = mesh_opt_fresh(indices + i, vertices, 0, fresh);
+            axis[0] = axis[1] = axis[2] = 0.0f;
+        }
+        for (int k = 0; length > 0.0f && k < 3; k++) {
+            axis[k] += normal[k] / length;
+        }
+        for (int f = 0; f < fresh_count; f++) {
+            vertices[current->vertex_count++] = fresh[f];
+        }
+        current->triangle_count++;
+    }
+    if (current) {
+        mesh_opt_meshlet_bounds(current, indices + current->index_offset, positions, stride, vertices);
+    }
+    return meshlet_count;
+}
+
+#define MESH_OPT_VIEW_SIZE 256
+
+// rasterizes front facing triangles with a depth test and counts shaded fragments and
+// covered pixels. u, v, w are the view's axes (w towards the viewer, u x v = w).
+static void
+mesh_opt_raster_view(const unsigned int *indices, size_t index_count, const float *positions, size_t stride,
+                     const float *bounds_min, float scale, int u, int v, int w, float w_sign, float u_sign,
+                     float *depth, double *shaded, double *covered)
+{
+    for (int p = 0; p < MESH_OPT_VIEW_SIZE * MESH_OPT_VIEW_SIZE; p++) {
+        depth[p] = -INFINITY;
+    }
+    for (size_t i = 0; i + 2 < index_count; i += 3) {
+        float x[3], y[3], z[3];
+        for (int k = 0; k < 3; k++) {
+            const float *p = mesh_opt_position(positions, stride, indices[i + k]);
+            // the mirrored axis keeps the screen right handed for the views along -axis
+            x[k] = u_sign > 0.0f ? (p[u] - bounds_min[u]) * scale : (MESH_OPT_VIEW_SIZE - (p[u] - bounds_min[u]) * scale);
+            y[k] = (p[v] - bounds_min[v]) * scale;
+            z[k] = p[w] * w_sign;
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area <= 0.0f) {
+            continue; // back facing or degenerate
+        }
+        int x0 = (int)floorf(fminf(x[0], fminf(x[1], x[2])));
+        int x1 = (int)ceilf(fmaxf(x[0], fmaxf(x[1], x[2])));
+        int y0 = (int)floorf(fminf(y[0], fminf(y[1], y[2])));
+        int y1 = (int)ceilf(fmaxf(y[0], fmaxf(y[1], y[2])));
+        x0 = x0 < 0 ? 0 : x0;
+        y0 = y0 < 0 ? 0 : y0;
+        x1 = x1 > MESH_OPT_VIEW_SIZE ? MESH_OPT_VIEW_SIZE : x1;
+        y1 = y1 > MESH_OPT_VIEW_SIZE ? MESH_OPT_VIEW_SIZE : y1;
+        for (int py = y0; py < y1; py++) {
+            for (int px = x0; px < x1; px++) {
+                float cx = px + 0.5f, cy = py + 0.5f;
+                float b0 = (x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1]);
+                float b1 = (x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2]);
+                float b2 = (x[1] - x[0]) * (cy - y[0]) - (y[1] - y[0]) * (cx - x[0]);
+                if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) {
+                    continue;
+                }
+                float d = (b0 * z[0] + b1 * z[1] + b2 * z[2]) / area;
+                float *stored = &depth[py * MESH_OPT_VIEW_SIZE + px];
+                if (d > *stored) {
+                    *covered += *stored == -INFINITY;
+                    *shaded += 1.0;
+                    *stored = d;
+                }
+            }
+        }
+    }
+}
+
+mesh_opt_stats
+mesh_opt_analyze(const unsigned int *indices, size_t index_count, const float *positions, size_t stride,
+                 size_t vertex_count, int cache_size)
+{
+    mesh_opt_stats stats = {0.0f, 0.0f, 0.0f, 0.0f};
+    size_t triangle_count = index_count / 3;
+    unsigned int *stamps = calloc(vertex_count ? vertex_count : 1, sizeof(unsigned int));
+    unsigned char *used = calloc(vertex_count ? vertex_count : 1, 1);
+    float *depth = malloc(MESH_OPT_VIEW_SIZE * MESH_OPT_VIEW_SIZE * sizeof(float));
+    if (!triangle_count || !stamps || !used || !depth) {
+        free(stamps);
+        free(used);
+        free(depth);
+        return stats;
+    }
+
+    unsigned int clock = (unsigned int)cache_size + 1;
+    size_t misses = 0, distinct = 0;
+    for (size_t t = 0; t < triangle_count; t++) {
+        misses += mesh_opt_misses(&indices[t * 3], stamps, &clock, cache_size);
+    }
+    for (size_t i = 0; i < index_count; i++) {
+        distinct += !used[indices[i]];
+        used[indices[i]] = 1;
+    }
+    stats.acmr = (float)misses / (float)triangle_count;
+    stats.atvr = (float)misses / (float)distinct;
+
+    // overfetch: every vertex that misses the transform cache reads its bytes through a
+    // direct mapped cache of 64 byte lines
+    enum { LINE = 64, LINES = 256 };
+    size_t tags[LINES];
+    for (int l = 0; l < LINES; l++) {
+        tags[l] = (size_t)-1;
+    }
+    size_t fetched = 0;
+    clock += (unsigned int)cache_size + 1;
+    for (size_t i = 0; i < index_count; i++) {
+        unsigned int v = indices[i];
+        if (clock - stamps[v] < (unsigned int)cache_size) {
+            continue;
+        }
+        stamps[v] = ++clock;
+        for (size_t line = v * stride / LINE; line <= (v * stride + stride - 1) / LINE; line++) {
+            if (tags[line % LINES] != line) {
+                tags[line % LINES] = line;
+                fetched += LINE;
+            }
+        }
+    }
+    stats.overfetch = (float)fetched / (float)(distinct * stride);
+
+    float bounds_min[3], bounds_max[3];
+    for (int k = 0; k < 3; k++) {
+        bounds_min[k] = INFINITY;
+        bounds_max[k] = -INFINITY;
+    }
+    for (size_t i = 0; i < index_count; i++) {
+        const float *p = mesh_opt_position(positions, stride, indices[i]);
+        for (int k = 0; k < 3; k++) {
+            bounds_min[k] = fminf(bounds_min[k], p[k]);
+            bounds_max[k] = fmaxf(bounds_max[k], p[k]);
+        }
+    }
+    float extent = fmaxf(bounds_max[0] - bounds_min[0], fmaxf(bounds_max[1] - bounds_min[1], bounds_max[2] - bounds_min[2]));
+    float scale = extent > 0.0f ? (MESH_OPT_VIEW_SIZE - 1) / extent : 1.0f;
+
+    // +x, -x, +y, -y, +z, -z as (u, v, w): u x v = w, the minus views mirror u
+    static const int views[3][3] = {{1, 2, 0}, {2, 0, 1}, {0, 1, 2}};
+    double shaded = 0.0, covered = 0.0;
+    for (int a = 0; a < 3; a++) {
+        for (int s = 0; s < 2; s++) {
+            float sign = s ? -1.0f : 1.0f;
+            mesh_opt_raster_view(indices, index_count, positions, stride, bounds_min, scale, views[a][0],
+                                 views[a][1], views[a][2], sign, sign, depth, &shaded, &covered);
+        }
+    }
+    stats.overdraw = covered > 0.0 ? (float)(shaded / covered) : 0.0f;
+
+    free(stamps);
+    free(used);
+    free(depth);
+    return stats;
+}
+
+#endif // MESH_OPT_IMPLEMENTATION
@@ -0,0 +1,369 @@
+// mesh_opt.h report.
+//
+// Runs the bake passes one after another over each mesh and prints ACMR,
+// ATVR, overdraw and overfetch (see mesh_opt.h) after every step, with the
+// time each pass took, as JSON. Then cuts the result into meshlets and
+// culls them with cull_cones from a ring of cameras around the mesh, far
+// (whole mesh on screen) and near (sides off screen), and reports the share
+// of triangles culled next to the share that a per triangle test would
+// cull, plus any triangle that was culled but faces the camera inside the
+// frustum (must be 0). Meshes:
+//   every OBJ on the command line (default ./third_party/assets/Tree.obj),
+//   optimized per group the way mesh_load_obj bakes them
+//   "spheres", a generated clump of overlapping smooth UV spheres with the
+//   triangles and vertices shuffled, standing in for a dense mesh from a tool that
+//   doesn't care about order
+//
+// usage: ./mesh_opt_bench [path ...]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define CULL_IMPLEMENTATION
+#include "cull.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void print_stats(const char *stage, const obj_mesh *mesh, double ms, int last)
+{
+    mesh_opt_stats s = mesh_opt_analyze(mesh->indices, mesh->index_count, mesh->vertices[0].position,
+                                        sizeof(obj_vertex), mesh->vertex_count, MESH_OPT_CACHE_SIZE);
+    printf("        {\"stage\": \"%s\", \"ms\": %.3f, \"acmr\": %.3f, \"atvr\": %.3f, \"overdraw\": %.3f, \"overfetch\": %.3f}%s\n",
+           stage, ms, s.acmr, s.atvr, s.overdraw, s.overfetch, last ? "" : ",");
+}
+
+// scratch for renumbering one group to its own vertices, like mesh_optimize does
+unsigned int *local, *global;
+float *positions;
+
+size_t localize(obj_mesh *mesh, unsigned int *indices, size_t count)
+{
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        unsigned int v = indices[i];
+        if (local[v] == 0xffffffffu) {
+            local[v] = (unsigned int)used;
+            global[used] = v;
+            memcpy(&positions[used * 3], mesh->vertices[v].position, 3 * sizeof(float));
+            used++;
+        }
+        indices[i] = local[v];
+    }
+    return used;
+}
+
+void restore(unsigned int *indices, size_t count, size_t used)
+{
+    for (size_t i = 0; i < count; i++) {
+        indices[i] = global[indices[i]];
+    }
+    for (size_t u = 0; u < used; u++) {
+        local[global[u]] = 0xffffffffu;
+    }
+}
+
+// 1 if triangle t faces the camera and isn't outside any one frustum plane
+int triangle_visible(const obj_mesh *mesh, const unsigned int *t, const cull_frustum *f, hmm_vec3 camera)
+{
+    const float *a = mesh->vertices[t[0]].position, *b = mesh->vertices[t[1]].position, *c = mesh->vertices[t[2]].position;
+    float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]}, e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+    if (n[0] * (camera.X - a[0]) + n[1] * (camera.Y - a[1]) + n[2] * (camera.Z - a[2]) <= 0.0f) {
+        return 0;
+    }
+    for (int p = 0; p < 6; p++) {
+        int outside = 1;
+        for (int k = 0; k < 3; k++) {
+            const float *v = mesh->vertices[t[k]].position;
+            outside &= v[0] * f->x[p] + v[1] * f->y[p] + v[2] * f->z[p] + f->d[p] < 0.0f;
+        }
+        if (outside) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void report_meshlets(const obj_mesh *mesh)
+{
+    size_t bound = 0;
+    for (int g = 0; g < mesh->group_count; g++) {
+        bound += mesh_opt_meshlet_bound(mesh->groups[g].index_count, MESH_OPT_MESHLET_VERTICES,
+                                        MESH_OPT_MESHLET_TRIANGLES);
+    }
+    mesh_opt_meshlet *meshlets = malloc(bound * sizeof(mesh_opt_meshlet));
+    double start = now_ms();
+    size_t count = 0;
+    for (int g = 0; g < mesh->group_count; g++) {
+        mesh_opt_meshlet *first = meshlets + count;
+        size_t n = mesh_opt_meshlets(first, mesh->indices + mesh->groups[g].index_offset,
+                                     mesh->groups[g].index_count, mesh->vertices[0].position, sizeof(obj_vertex),
+                                     MESH_OPT_MESHLET_VERTICES, MESH_OPT_MESHLET_TRIANGLES);
+        for (size_t i = 0; i < n; i++) {
+            first[i].index_offset += mesh->groups[g].index_offset;
+        }
+        count += n;
+    }
+    double build_ms = now_ms() - start;
+
+    // SoA like the mesh cache stores them
+    float *soa = malloc(count * 8 * sizeof(float));
+    float *x = soa, *y = soa + count, *z = soa + 2 * count, *radius = soa + 3 * count;
+    float *axis_x = soa + 4 * count, *axis_y = soa + 5 * count, *axis_z = soa + 6 * count, *cutoff = soa + 7 * count;
+    size_t vertices = 0, cullable = 0;
+    for (size_t i = 0; i < count; i++) {
+        x[i] = meshlets[i].center[0];
+        y[i] = meshlets[i].center[1];
+        z[i] = meshlets[i].center[2];
+        radius[i] = meshlets[i].radius;
+        axis_x[i] = meshlets[i].cone_axis[0];
+        axis_y[i] = meshlets[i].cone_axis[1];
+        axis_z[i] = meshlets[i].cone_axis[2];
+        cutoff[i] = meshlets[i].cone_cutoff;
+        vertices += meshlets[i].vertex_count;
+        cullable += meshlets[i].cone_cutoff < 1.0f;
+    }
+    unsigned int triangles = mesh->index_count / 3;
+    printf("      \"meshlets\": {\"count\": %zu, \"build_ms\": %.3f, \"vertices_avg\": %.1f, \"triangles_avg\": %.1f, \"cone_cullable\": %.3f, \"views\": [\n",
+           count, build_ms, (double)vertices / count, (double)triangles / count, (double)cullable / count);
+
+    float center[3], extent = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        center[k] = (mesh->min[k] + mesh->max[k]) * 0.5f;
+        float half = (mesh->max[k] - mesh->min[k]) * 0.5f;
+        extent += half * half;
+    }
+    extent = sqrtf(extent);
+    hmm_mat4 projection = HMM_Perspective(45.0f, 16.0f / 9.0f, 0.01f * extent, 100.0f * extent);
+    int *visible = malloc(count * sizeof(int));
+    unsigned char *kept = malloc(count);
+    const float distances[2] = {3.0f, 1.5f};
+    const char *names[2] = {"far", "near"};
+    const int view_count = 32;
+    for (int d = 0; d < 2; d++) {
+        double frustum_culled = 0.0, cone_culled = 0.0, ideal_culled = 0.0, cull_us = 0.0;
+        size_t wrong = 0;
+        for (int v = 0; v < view_count; v++) {
+            float angle = 2.0f * 3.14159265f * v / view_count;
+            hmm_vec3 target = HMM_Vec3(center[0], center[1], center[2]);
+            hmm_vec3 camera = HMM_Vec3(center[0] + distances[d] * extent * cosf(angle),
+                                       center[1] + 0.4f * distances[d] * extent,
+                                       center[2] + distances[d] * extent * sinf(angle));
+            hmm_mat4 view = HMM_LookAt(camera, target, HMM_Vec3(0.0f, 1.0f, 0.0f));
+            cull_frustum frustum = cull_frustum_from_matrix(HMM_MultiplyMat4(projection, view));
+
+            int in_frustum = cull_spheres(&frustum, x, y, z, radius, (int)count, visible);
+            size_t frustum_triangles = 0;
+            for (int i = 0; i < in_frustum; i++) {
+                frustum_triangles += meshlets[visible[i]].triangle_count;
+            }
+            start = now_ms();
+            int visible_count = cull_cones(&frustum, camera, x, y, z, radius, axis_x, axis_y, axis_z, cutoff,
+                                           (int)count, visible);
+            cull_us += (now_ms() - start) * 1e3;
+
+            memset(kept, 0, count);
+            size_t kept_triangles = 0;
+            for (int i = 0; i < visible_count; i++) {
+                kept[visible[i]] = 1;
+                kept_triangles += meshlets[visible[i]].triangle_count;
+            }
+            size_t ideal = 0;
+            for (size_t i = 0; i < count; i++) {
+                for (unsigned int t = 0; t < meshlets[i].triangle_count; t++) {
+                    int seen = triangle_visible(mesh, mesh->indices + meshlets[i].index_offset + t * 3, &frustum, camera);
+                    ideal += seen;
+                    wrong += seen && !kept[i];
+                }
+            }
+            frustum_culled += (double)(triangles - frustum_triangles) / triangles;
+            cone_culled += (double)(frustum_triangles - kept_triangles) / triangles;
+            ideal_culled += (double)(triangles - ideal) / triangles;
+        }
+        printf("        {\"name\": \"%s\", \"distance\": %.1f, \"views\": %d, \"culled\": %.3f, \"frustum_culled\": %.3f, \"cone_culled\": %.3f, \"per_triangle_culled\": %.3f, \"cull_us\": %.2f, \"wrongly_culled\": %zu}%s\n",
+               names[d], distances[d], view_count, (frustum_culled + cone_culled) / view_count,
+               frustum_culled / view_count, cone_culled / view_count, ideal_culled / view_count,
+               cull_us / view_count, wrong, d == 1 ? "" : ",");
+    }
+    printf("      ]}\n");
+    free(visible);
+    free(kept);
+    free(soa);
+    free(meshlets);
+}
+
+// the same steps as mesh_optimize, timed one by one
+void report(const char *name, obj_mesh *mesh, int last)
+{
+    printf("    {\"name\": \"%s\", \"vertices\": %u, \"triangles\": %u, \"groups\": %d, \"cache_size\": %d, \"stages\": [\n",
+           name, mesh->vertex_count, mesh->index_count / 3, mesh->group_count, MESH_OPT_CACHE_SIZE);
+    print_stats("input", mesh, 0.0, 0);
+
+    local = malloc(mesh->vertex_count * sizeof(unsigned int));
+    global = malloc(mesh->vertex_count * sizeof(unsigned int));
+    positions = malloc(mesh->vertex_count * 3 * sizeof(float));
+    memset(local, 0xff, mesh->vertex_count * sizeof(unsigned int));
+
+    double start = now_ms();
+    for (int g = 0; g < mesh->group_count; g++) {
+        unsigned int *indices = mesh->indices + mesh->groups[g].index_offset;
+        size_t count = mesh->groups[g].index_count;
+        size_t used = localize(mesh, indices, count);
+        mesh_opt_vertex_cache(indices, count, used, MESH_OPT_CACHE_SIZE);
+        restore(indices, count, used);
+    }
+    print_stats("vertex_cache", mesh, now_ms() - start, 0);
+
+    start = now_ms();
+    for (int g = 0; g < mesh->group_count; g++) {
+        unsigned int *indices = mesh->indices + mesh->groups[g].index_offset;
+        size_t count = mesh->groups[g].index_count;
+        size_t used = localize(mesh, indices, count);
+        mesh_opt_overdraw(indices, count, positions, 3 * sizeof(float), used, MESH_OPT_CACHE_SIZE, 1.05f);
+        restore(indices, count, used);
+    }
+    print_stats("overdraw", mesh, now_ms() - start, 0);
+
+    free(local);
+    free(global);
+    free(positions);
+
+    start = now_ms();
+    mesh->vertex_count = (unsigned int)mesh_opt_vertex_fetch(mesh->vertices, sizeof(obj_vertex), mesh->indices,
+                                                             mesh->index_count, mesh->vertex_count);
+    print_stats("vertex_fetch", mesh, now_ms() - start, 1);
+    printf("    ],\n");
+    report_meshlets(mesh);
+    printf("    }%s\n", last ? "" : ",");
+}
+
+unsigned int rng_state = 12345;
+
+unsigned int rng(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+// 7 spheres of rings x segments quads, one group, triangles and vertices shuffled
+obj_mesh make_spheres(int rings, int segments)
+{
+    const float centers[7][3] = {{0, 0, 0}, {0.8f, 0, 0}, {-0.8f, 0, 0}, {0, 0.8f, 0},
+                                 {0, -0.8f, 0}, {0, 0, 0.8f}, {0, 0, -0.8f}};
+    int per_sphere = (rings + 1) * (segments + 1);
+    obj_mesh mesh = {0};
+    mesh.vertex_count = 7 * per_sphere;
+    mesh.index_count = 7 * rings * segments * 6;
+    mesh.vertices = calloc(mesh.vertex_count, sizeof(obj_vertex));
+    mesh.indices = malloc(mesh.index_count * sizeof(unsigned int));
+    mesh.groups = calloc(1, sizeof(obj_group));
+    mesh.group_count = 1;
+    mesh.groups[0].index_count = mesh.index_count;
+
+    unsigned int *index = mesh.indices;
+    for (int s = 0; s < 7; s++) {
+        for (int r = 0; r <= rings; r++) {
+            for (int g = 0; g <= segments; g++) {
+                float theta = 3.14159265f * r / rings, phi = 2.0f * 3.14159265f * g / segments;
+                obj_vertex *v = &mesh.vertices[s * per_sphere + r * (segments + 1) + g];
+                v->normal[0] = sinf(theta) * cosf(phi);
+                v->normal[1] = cosf(theta);
+                v->normal[2] = sinf(theta) * sinf(phi);
+                for (int k = 0; k < 3; k++) {
+                    v->position[k] = centers[s][k] + 0.6f * v->normal[k];
+                }
+                v->uv[0] = (float)g / segments;
+                v->uv[1] = (float)r / rings;
+            }
+        }
+        for (int r = 0; r < rings; r++) {
+            for (int g = 0; g < segments; g++) {
+                unsigned int a = s * per_sphere + r * (segments + 1) + g, b = a + segments + 1;
+                // counter clockwise seen from outside
+                unsigned int quad[6] = {a, a + 1, b, a + 1, b + 1, b};
+                memcpy(index, quad, sizeof(quad));
+                index += 6;
+            }
+        }
+    }
+    unsigned int triangles = mesh.index_count / 3;
+    for (unsigned int t = triangles - 1; t > 0; t--) {
+        unsigned int other = rng() % (t + 1);
+        for (int k = 0; k < 3; k++) {
+            unsigned int swap = mesh.indices[t * 3 + k];
+            mesh.indices[t * 3 + k] = mesh.indices[other * 3 + k];
+            mesh.indices[other * 3 + k] = swap;
+        }
+    }
+    // and the vertices, so the fetch order starts out as bad as the triangle order
+    unsigned int *order = malloc(mesh.vertex_count * sizeof(unsigned int));
+    obj_vertex *shuffled = malloc(mesh.vertex_count * sizeof(obj_vertex));
+    for (unsigned int v = 0; v < mesh.vertex_count; v++) {
+        order[v] = v;
+    }
+    for (unsigned int v = mesh.vertex_count - 1; v > 0; v--) {
+        unsigned int other = rng() % (v + 1), swap = order[v];
+        order[v] = order[other];
+        order[other] = swap;
+    }
+    for (unsigned int v = 0; v < mesh.vertex_count; v++) {
+        shuffled[order[v]] = mesh.vertices[v];
+    }
+    for (unsigned int i = 0; i < mesh.index_count; i++) {
+        mesh.indices[i] = order[mesh.indices[i]];
+    }
+    free(mesh.vertices);
+    free(order);
+    mesh.vertices = shuffled;
+    for (int k = 0; k < 3; k++) {
+        mesh.min[k] = -1.4f;
+        mesh.max[k] = 1.4f;
+    }
+    return mesh;
+}
+
+int main(int argc, char **argv)
+{
+    const char *default_path = "./third_party/assets/Tree.obj";
+    const char **paths = argc > 1 ? (const char **)argv + 1 : &default_path;
+    int path_count = argc > 1 ? argc - 1 : 1;
+
+    printf("{\n");
+    printf("  \"meshes\": [\n");
+    for (int p = 0; p < path_count; p++) {
+        obj_mesh mesh;
+        if (!obj_load(&mesh, paths[p])) {
+            return -1;
+        }
+        report(paths[p], &mesh, 0);
+        obj_free(&mesh);
+    }
+    obj_mesh spheres = make_spheres(48, 96);
+    report("spheres", &spheres, 1);
+    obj_free(&spheres);
+    printf("  ]\n");
+    printf("}\n");
+    return 0;
+}
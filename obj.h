@@ -0,0 +1,1855 @@
+/*
+  obj.h
+
+  Wavefront OBJ loader. The file is mapped with asset_io.h and parsed in
+  place: numbers go through a small float/int parser instead of strtod or
+  sscanf, polygons are fanned into triangles, and every distinct
+  position/texcoord/normal triple becomes one interleaved vertex, so the
+  result goes straight into a vertex buffer and an index buffer.
+
+  Do this:
+
+     #define OBJ_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header, with asset_io.h
+  included (and implemented) somewhere in the program.
+
+  Usage:
+
+     obj_mesh mesh;
+     if (obj_load(&mesh, "./third_party/assets/Tree.obj")) {
+         glBufferData(GL_ARRAY_BUFFER, mesh.vertex_count * sizeof(obj_vertex), mesh.vertices, GL_STATIC_DRAW);
+         glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.index_count * sizeof(unsigned int), mesh.indices, GL_STATIC_DRAW);
+         for (int g = 0; g < mesh.group_count; g++) draw(mesh.groups[g].material, ...);
+         obj_free(&mesh);
+     }
+
+  obj_load_threaded / obj_parse_threaded split big files at line
+  boundaries and parse the pieces on pthreads (link with -pthread), each
+  piece into its own arrays, then rebase them with prefix sums. Dedup is
+  split by position index so it runs in parallel too. The result is the
+  same, byte for byte, as the single threaded parse. Define OBJ_NO_THREADS
+  to leave the threads out, the _threaded functions then parse on the
+  calling thread.
+
+  Supported: v, vt, vn, f (any polygon size, negative indices, v, v/vt,
+  v//vn, v/vt/vn), o, g, usemtl and mtllib. Everything else (s, l, p,
+  comments, vertex colours after v) is skipped. Missing texcoords and
+  normals come out as zero.
+
+  Groups follow the file, so a mesh that goes back and forth between
+  materials has a group per switch. obj_group_by_material moves the
+  triangles around so every material is one range, one draw:
+
+     obj_group_by_material(&mesh);
+
+  Files too big to load whole go through obj_stream, which never holds
+  more than a window of the file and one chunk of faces. obj_stream_open
+  reads the file once, copying v, vt and vn into binary spill files next
+  to it (<path>.v.tmp, .vt.tmp, .vn.tmp, removed by obj_stream_close) and
+  finding their bounds. obj_stream_next then reads it again and hands out
+  the faces a chunk at a time, one material per chunk, in file order. The
+  corners' attributes come back out of the spill files through a small
+  page cache, so how much memory that takes is up to the caller,
+  not the file:
+
+     obj_stream stream;
+     if (obj_stream_open(&stream, path, 1 << 20, 16 << 20, 1 << 18, NULL, NULL)) {
+         obj_mesh chunk;
+         while (obj_stream_next(&stream, &chunk) > 0) {
+             ... // chunk.groups[0] names its object and material
+         }
+         obj_stream_close(&stream);
+     }
+
+  Material libraries (.mtl) are parsed by obj_load_mtl: newmtl, Ka, Kd,
+  Ks, Ke, Ns, d, Tr, Ni, illum, and the map_Kd, map_Ks, map_Bump (bump,
+  norm) and map_d texture paths, as written in the file. Map options
+  (-s, -o, -bm, ...) are skipped, the file name is the last word on the
+  line, so names with spaces aren't supported.
+
+     obj_material_lib lib;
+     if (obj_load_mtl(&lib, "./third_party/assets/Tree.mtl")) {
+         int m = obj_find_material(&lib, mesh.groups[g].material); // -1 when it isn't there
+         obj_free_mtl(&lib);
+     }
+*/
+
+#ifndef OBJ_H
+#define OBJ_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define OBJ_NAME_LEN 64
+#define OBJ_PATH_LEN 256
+
+#ifndef OBJ_THREAD_MIN_BYTES
+#define OBJ_THREAD_MIN_BYTES (256 * 1024)
+#endif
+
+typedef struct
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+} obj_vertex;
+
+// a run of indices drawn with one material, one per usemtl (or o/g) in file order
+typedef struct
+{
+    char object[OBJ_NAME_LEN];
+    char material[OBJ_NAME_LEN];
+    unsigned int index_offset;
+    unsigned int index_count;
+} obj_group;
+
+typedef struct
+{
+    obj_vertex *vertices;
+    unsigned int vertex_count;
+    unsigned int *indices;
+    unsigned int index_count;
+    obj_group *groups;
+    int group_count;
+    char mtllib[OBJ_NAME_LEN];
+    float min[3], max[3];
+} obj_mesh;
+
+// one attribute spilled to disk by obj_stream's first pass, read back a page at a time
+typedef struct
+{
+    FILE *file;
+    char path[1024];
+    int width;                    // floats per element
+    unsigned long long count;     // elements in the file
+    float *pages;                 // page_count slots of OBJ_STREAM_PAGE elements
+    unsigned long long *tags;     // the page each slot holds, ~0 for none
+    size_t page_count;
+} obj_spill;
+
+typedef struct
+{
+    // what obj_stream_open's pass found
+    unsigned long long position_count, texcoord_count, normal_count;
+    float min[3], max[3];       // over every v line
+    float uv_min[2], uv_max[2]; // over every vt line, and 0 when a face corner has no vt
+    char mtllib[OBJ_NAME_LEN];  // the last mtllib, as obj_parse keeps it
+
+    // the rest is the stream's own
+    FILE *file;
+    char *window;
+    size_t window_size, begin, end, next; // unread bytes are window[begin, end), the current line ends at next
+    int eof;
+    unsigned long long line_number;
+    void (*scan)(void *user, const void *data, size_t size);
+    void *user;
+    obj_spill spills[3];          // positions, texcoords, normals
+    unsigned long long seen[3];   // of each, how many the second pass has gone past
+    char object[OBJ_NAME_LEN];    // the last o or g
+    size_t max_triangles, max_vertices;
+    unsigned int *keys;           // v, vt, vn of every chunk vertex
+    unsigned int *table;          // chunk vertex + 1 by key hash, 0 for empty
+    size_t table_mask;
+    obj_vertex *vertices;
+    unsigned int *indices;
+    obj_group group;              // the chunk's
+} obj_stream;
+
+// texture maps of a material, the order of obj_material.maps
+enum
+{
+    OBJ_MAP_DIFFUSE,  // map_Kd
+    OBJ_MAP_SPECULAR, // map_Ks
+    OBJ_MAP_NORMAL,   // map_Bump, bump or norm
+    OBJ_MAP_ALPHA,    // map_d
+    OBJ_MAP_COUNT
+};
+
+typedef struct
+{
+    char name[OBJ_NAME_LEN];
+    float ambient[3];  // Ka
+    float diffuse[3];  // Kd
+    float specular[3]; // Ks
+    float emissive[3]; // Ke
+    float shininess;   // Ns
+    float opacity;     // d, or 1 - Tr
+    float ior;         // Ni
+    int illum;
+    char maps[OBJ_MAP_COUNT][OBJ_PATH_LEN]; // empty when the material has none
+} obj_material;
+
+typedef struct
+{
+    obj_material *materials;
+    int material_count;
+} obj_material_lib;
+
+// returns 0 on failure, mesh is zeroed in that case
+int obj_load(obj_mesh *mesh, const char *path);
+// same on a buffer that's already in memory, it doesn't need a terminating NUL
+int obj_parse(obj_mesh *mesh, const char *data, size_t size);
+// split at line boundaries and parsed on threads (<= 0: one per online CPU), the result is
+// bit for bit what obj_parse returns. Small files and OBJ_NO_THREADS builds just call obj_parse.
+int obj_load_threaded(obj_mesh *mesh, const char *path, int threads);
+int obj_parse_threaded(obj_mesh *mesh, const char *data, size_t size, int threads);
+void obj_free(obj_mesh *mesh);
+
+// reads window_size bytes of the file at a time (a line has to fit), keeps up to cache_size bytes of
+// spilled attributes, and makes chunks of up to max_triangles triangles and as many vertices, about
+// 72 bytes a triangle. scan, when not NULL, is handed every byte of the file in order during the
+// first pass (mesh.h hashes it there). returns 0 on failure, s is zeroed in that case
+int obj_stream_open(obj_stream *s, const char *path, size_t window_size, size_t cache_size, size_t max_triangles,
+                    void (*scan)(void *user, const void *data, size_t size), void *user);
+// the next chunk: faces in file order up to a material change or a full chunk, as a mesh with one
+// group and vertices of its own (a vertex two chunks use is in both). Its arrays are the stream's,
+// they can be changed in place and last until the next call, don't obj_free it.
+// returns 1 for a chunk, 0 past the last one, -1 on failure
+int obj_stream_next(obj_stream *s, obj_mesh *chunk);
+void obj_stream_close(obj_stream *s);
+
+// merges the groups that share a material into one, in order of first use, moving their
+// triangles next to each other. The merged group keeps the first group's object name.
+// returns 0 on allocation failure, the mesh is unchanged then
+int obj_group_by_material(obj_mesh *mesh);
+
+// returns 0 on failure, lib is zeroed in that case
+int obj_load_mtl(obj_material_lib *lib, const char *path);
+int obj_parse_mtl(obj_material_lib *lib, const char *data, size_t size);
+// a material that isn't in the library, what an unknown or missing usemtl draws with
+void obj_default_material(obj_material *material, const char *name);
+// index of the material called name, -1 if there's none
+int obj_find_material(const obj_material_lib *lib, const char *name);
+void obj_free_mtl(obj_material_lib *lib);
+
+#endif // OBJ_H
+
+#ifdef OBJ_IMPLEMENTATION
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef OBJ_NO_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// exact in double, so mantissa / 10^n is correctly rounded for up to 22 decimals
+static const double obj_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int
+obj_is_digit(char c)
+{
+    return (unsigned)(c - '0') < 10;
+}
+
+static const char *
+obj_skip_space(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static const char *
+obj_next_line(const char *p, const char *end)
+{
+    if (p >= end) {
+        return end;
+    }
+    const char *newline = memchr(p, '\n', (size_t)(end - p));
+    return newline ? newline + 1 : end;
+}
+
+// [+-]digits[.digits][(e|E)[+-]digits], leaves *out alone and returns p if there's no number
+static const char *
+obj_parse_float(const char *p, const char *end, float *out)
+{
+    const char *start = p;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    // digits past the 18th can't change a float, they only move the decimal point
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int any = 0;
+    for (; p < end && obj_is_digit(*p); p++, any = 1) {
+        if (mantissa < 100000000000000000ull) {
+            mantissa = mantissa * 10 + (*p - '0');
+        } else if (exponent < 100000) {
+            exponent++; // past this it's infinite anyway, and the count can't overflow on a huge line
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && obj_is_digit(*p); p++, any = 1) {
+            if (mantissa < 100000000000000000ull) {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (!any) {
+        return start;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *e = p + 1;
+        int negative_exponent = 0;
+        if (e < end && (*e == '-' || *e == '+')) {
+            negative_exponent = *e == '-';
+            e++;
+        }
+        if (e < end && obj_is_digit(*e)) {
+            int value = 0;
+            for (; e < end && obj_is_digit(*e); e++) {
+                if (value < 10000) {
+                    value = value * 10 + (*e - '0');
+                }
+            }
+            exponent += negative_exponent ? -value : value;
+            p = e;
+        }
+    }
+
+    double value = (double)mantissa;
+    while (exponent < -22) {
+        value /= 1e22;
+        exponent += 22;
+    }
+    while (exponent > 22) {
+        value *= 1e22;
+        exponent -= 22;
+    }
+    value = exponent < 0 ? value / obj_pow10[-exponent] : value * obj_pow10[exponent];
+    *out = (float)(negative ? -value : value);
+    return p;
+}
+
+static const char *
+obj_parse_int(const char *p, const char *end, int *out)
+{
+    int negative = 0;
+    if (p < end && *p == '-') {
+        negative = 1;
+        p++;
+    }
+    // saturates at INT_MAX, which no face index can reach, so huge ones take obj_resolve's out of range path
+    int value = 0;
+    for (; p < end && obj_is_digit(*p); p++) {
+        value = value < 214748364 ? value * 10 + (*p - '0') : 2147483647;
+    }
+    *out = negative ? -value : value;
+    return p;
+}
+
+// the rest of the line minus trailing whitespace, truncated to fit in OBJ_NAME_LEN
+static const char *
+obj_parse_name(const char *p, const char *end, char *out)
+{
+    p = obj_skip_space(p, end);
+    const char *line_end = p;
+    while (line_end < end && *line_end != '\n' && *line_end != '\r') {
+        line_end++;
+    }
+    const char *name_end = line_end;
+    while (name_end > p && (name_end[-1] == ' ' || name_end[-1] == '\t')) {
+        name_end--;
+    }
+    size_t length = name_end - p;
+    if (length > OBJ_NAME_LEN - 1) {
+        length = OBJ_NAME_LEN - 1;
+    }
+    // zero filled so groups compare equal byte for byte, whichever name they held before
+    memcpy(out, p, length);
+    memset(out + length, 0, OBJ_NAME_LEN - length);
+    return line_end;
+}
+
+static void *
+obj_grow(void *data, size_t *capacity, size_t needed, size_t element_size)
+{
+    if (needed <= *capacity) {
+        return data;
+    }
+    size_t new_capacity = *capacity ? *capacity * 2 : 256;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *grown = realloc(data, new_capacity * element_size);
+    if (!grown) {
+        free(data);
+        return NULL;
+    }
+    *capacity = new_capacity;
+    return grown;
+}
+
+enum
+{
+    OBJ_LINE_OTHER,
+    OBJ_LINE_POSITION,
+    OBJ_LINE_TEXCOORD,
+    OBJ_LINE_NORMAL,
+    OBJ_LINE_FACE,
+    OBJ_LINE_OBJECT,
+    OBJ_LINE_USEMTL,
+    OBJ_LINE_MTLLIB
+};
+
+// what the line starting at line (leading space already skipped) declares, *rest is past the keyword
+static int
+obj_line_kind(const char *line, const char *end, const char **rest)
+{
+    char c0 = line < end ? line[0] : '\n';
+    char c1 = line + 1 < end ? line[1] : '\n';
+    *rest = line + 2;
+    if (c0 == 'v' && (c1 == ' ' || c1 == '\t')) {
+        return OBJ_LINE_POSITION;
+    } else if (c0 == 'v' && c1 == 'n') {
+        return OBJ_LINE_NORMAL;
+    } else if (c0 == 'v' && c1 == 't') {
+        return OBJ_LINE_TEXCOORD;
+    }
+    *rest = line + 1;
+    if (c0 == 'f' && (c1 == ' ' || c1 == '\t')) {
+        return OBJ_LINE_FACE;
+    } else if (c0 == 'o' || c0 == 'g') {
+        return OBJ_LINE_OBJECT;
+    }
+    *rest = line + 6;
+    if ((size_t)(end - line) > 6 && !memcmp(line, "usemtl", 6)) {
+        return OBJ_LINE_USEMTL;
+    } else if ((size_t)(end - line) > 6 && !memcmp(line, "mtllib", 6)) {
+        return OBJ_LINE_MTLLIB;
+    }
+    return OBJ_LINE_OTHER;
+}
+
+// appends one element of n floats read from q, missing ones are 0, returns 0 on allocation failure
+static int
+obj_push_floats(float **array, size_t *count, size_t *capacity, int n, const char *q, const char *end)
+{
+    *array = obj_grow(*array, capacity, (*count + 1) * n, sizeof(float));
+    if (!*array) {
+        return 0;
+    }
+    float *out = &(*array)[*count * n];
+    *count += 1;
+    for (int k = 0; k < n; k++) {
+        out[k] = 0.0f;
+        q = obj_parse_float(obj_skip_space(q, end), end, &out[k]);
+    }
+    return 1;
+}
+
+// one v[/vt][/vn] face corner as written, 0 where vt or vn is missing, NULL past the last corner
+static const char *
+obj_parse_corner(const char *q, const char *end, int *corner)
+{
+    q = obj_skip_space(q, end);
+    if (q >= end || !(obj_is_digit(*q) || *q == '-')) {
+        return NULL;
+    }
+    corner[0] = corner[1] = corner[2] = 0;
+    q = obj_parse_int(q, end, &corner[0]);
+    if (q < end && *q == '/') {
+        q++;
+        if (q < end && *q != '/') {
+            q = obj_parse_int(q, end, &corner[1]);
+        }
+        if (q < end && *q == '/') {
+            q = obj_parse_int(q + 1, end, &corner[2]);
+        }
+    }
+    return q;
+}
+
+// position/texcoord/normal indices of one face corner, 0 = absent for vt and vn
+typedef struct
+{
+    unsigned int v, vt, vn;
+} obj_key;
+
+typedef struct
+{
+    float *positions, *texcoords, *normals;
+    size_t position_count, texcoord_count, normal_count;
+    size_t position_cap, texcoord_cap, normal_cap;
+
+    // dedup: the vertices made from one position form a chain, first[v] -> next[vertex] -> ...,
+    // vertex index + 1, 0 ends it. Faces mostly use positions defined just before them, so
+    // unlike a hash of the whole triple the lookups stay in cache.
+    unsigned int *first;
+    size_t first_cap;
+    unsigned int *next;
+    obj_key *keys; // one per output vertex
+    obj_vertex *vertices;
+    size_t vertex_cap;
+    unsigned int *indices;
+    size_t index_count, index_cap;
+    obj_group *groups;
+    size_t group_count, group_cap;
+} obj_builder;
+
+static void
+obj_make_vertex(obj_vertex *vertex, obj_key key, const float *positions, const float *texcoords, const float *normals)
+{
+    memcpy(vertex->position, &positions[(key.v - 1) * 3], 3 * sizeof(float));
+    if (key.vn) {
+        memcpy(vertex->normal, &normals[(key.vn - 1) * 3], 3 * sizeof(float));
+    } else {
+        vertex->normal[0] = vertex->normal[1] = vertex->normal[2] = 0.0f;
+    }
+    if (key.vt) {
+        memcpy(vertex->uv, &texcoords[(key.vt - 1) * 2], 2 * sizeof(float));
+    } else {
+        vertex->uv[0] = vertex->uv[1] = 0.0f;
+    }
+}
+
+// index of the vertex for this corner, adding it if it's new, -1 on allocation failure
+static long
+obj_vertex_index(obj_builder *b, obj_mesh *mesh, obj_key key)
+{
+    for (unsigned int found = b->first[key.v - 1]; found; found = b->next[found - 1]) {
+        obj_key *k = &b->keys[found - 1];
+        if (k->vt == key.vt && k->vn == key.vn) {
+            return found - 1;
+        }
+    }
+
+    size_t index = mesh->vertex_count;
+    if (index + 1 > b->vertex_cap) {
+        size_t cap = b->vertex_cap;
+        b->vertices = obj_grow(b->vertices, &cap, index + 1, sizeof(obj_vertex));
+        cap = b->vertex_cap;
+        b->next = obj_grow(b->next, &cap, index + 1, sizeof(unsigned int));
+        b->keys = obj_grow(b->keys, &b->vertex_cap, index + 1, sizeof(obj_key));
+        if (!b->vertices || !b->next || !b->keys) {
+            return -1;
+        }
+    }
+    b->keys[index] = key;
+    b->next[index] = b->first[key.v - 1];
+    b->first[key.v - 1] = (unsigned int)index + 1;
+
+    obj_make_vertex(&b->vertices[index], key, b->positions, b->texcoords, b->normals);
+    mesh->vertex_count++;
+    return (long)index;
+}
+
+// 1 based, negative counts back from the last element so far, 0 if out of range
+static unsigned int
+obj_resolve(int index, size_t count)
+{
+    long resolved = index < 0 ? (long)count + index + 1 : index;
+    return resolved >= 1 && (size_t)resolved <= count ? (unsigned int)resolved : 0;
+}
+
+// starts a group at the current index count, reusing the last one if nothing was drawn with it
+static obj_group *
+obj_begin_group(obj_builder *b)
+{
+    if (b->group_count && b->groups[b->group_count - 1].index_offset == b->index_count) {
+        return &b->groups[b->group_count - 1];
+    }
+    b->groups = obj_grow(b->groups, &b->group_cap, b->group_count + 1, sizeof(obj_group));
+    if (!b->groups) {
+        return NULL;
+    }
+    // names carry over, the caller replaces whichever one changed
+    obj_group *group = &b->groups[b->group_count++];
+    if (b->group_count > 1) {
+        *group = group[-1];
+    } else {
+        memset(group, 0, sizeof(*group));
+    }
+    group->index_offset = (unsigned int)b->index_count;
+    group->index_count = 0;
+    return group;
+}
+
+// closes the last group and drops one left empty at the end of the file
+static void
+obj_finish_groups(obj_builder *b)
+{
+    obj_group *last = &b->groups[b->group_count - 1];
+    last->index_count = (unsigned int)b->index_count - last->index_offset;
+    for (size_t g = 0; g + 1 < b->group_count; g++) {
+        b->groups[g].index_count = b->groups[g + 1].index_offset - b->groups[g].index_offset;
+    }
+    if (!last->index_count && b->group_count > 1) {
+        b->group_count--;
+    }
+}
+
+// min/max over vertices, ties keep the first one seen (matters for -0.0 against 0.0)
+static void
+obj_bounds(const obj_vertex *vertices, size_t count, float *min, float *max)
+{
+    for (int k = 0; k < 3; k++) {
+        min[k] = max[k] = vertices[0].position[k];
+    }
+    for (size_t i = 1; i < count; i++) {
+        for (int k = 0; k < 3; k++) {
+            float x = vertices[i].position[k];
+            min[k] = x < min[k] ? x : min[k];
+            max[k] = x > max[k] ? x : max[k];
+        }
+    }
+}
+
+int
+obj_parse(obj_mesh *mesh, const char *data, size_t size)
+{
+    memset(mesh, 0, sizeof(*mesh));
+    obj_builder b;
+    memset(&b, 0, sizeof(b));
+    int ok = obj_begin_group(&b) != NULL;
+    int line_number = 0;
+
+    const char *p = data, *end = data + size;
+    while (ok && p < end) {
+        line_number++;
+        const char *line = obj_skip_space(p, end);
+        const char *next = obj_next_line(line, end);
+        const char *q;
+
+        switch (obj_line_kind(line, end, &q)) {
+        case OBJ_LINE_POSITION:
+            b.first = obj_grow(b.first, &b.first_cap, b.position_count + 1, sizeof(unsigned int));
+            ok = b.first && obj_push_floats(&b.positions, &b.position_count, &b.position_cap, 3, q, end);
+            if (ok) {
+                b.first[b.position_count - 1] = 0;
+            }
+            break;
+        case OBJ_LINE_TEXCOORD:
+            ok = obj_push_floats(&b.texcoords, &b.texcoord_count, &b.texcoord_cap, 2, q, end);
+            break;
+        case OBJ_LINE_NORMAL:
+            ok = obj_push_floats(&b.normals, &b.normal_count, &b.normal_cap, 3, q, end);
+            break;
+        case OBJ_LINE_FACE: {
+            long first = -1, previous = -1;
+            int corners = 0;
+            int corner[3];
+            while (ok && (q = obj_parse_corner(q, end, corner))) {
+                obj_key key;
+                key.v = obj_resolve(corner[0], b.position_count);
+                key.vt = corner[1] ? obj_resolve(corner[1], b.texcoord_count) : 0;
+                key.vn = corner[2] ? obj_resolve(corner[2], b.normal_count) : 0;
+                if (!key.v || (corner[1] && !key.vt) || (corner[2] && !key.vn)) {
+                    printf("OBJ face index out of range on line %d\n", line_number);
+                    ok = 0;
+                    break;
+                }
+                long index = obj_vertex_index(&b, mesh, key);
+                if (index < 0) {
+                    ok = 0;
+                    break;
+                }
+
+                // fan: every corner past the second closes a triangle with the first and the previous
+                if (++corners >= 3) {
+                    b.indices = obj_grow(b.indices, &b.index_cap, b.index_count + 3, sizeof(unsigned int));
+                    if (!b.indices) {
+                        ok = 0;
+                        break;
+                    }
+                    b.indices[b.index_count++] = (unsigned int)first;
+                    b.indices[b.index_count++] = (unsigned int)previous;
+                    b.indices[b.index_count++] = (unsigned int)index;
+                }
+                if (first < 0) {
+                    first = index;
+                }
+                previous = index;
+            }
+            break;
+        }
+        case OBJ_LINE_OBJECT:
+        case OBJ_LINE_USEMTL: {
+            obj_group *group = obj_begin_group(&b);
+            if (!group) {
+                ok = 0;
+                break;
+            }
+            obj_parse_name(q, end, line[0] == 'u' ? group->material : group->object);
+            break;
+        }
+        case OBJ_LINE_MTLLIB:
+            obj_parse_name(q, end, mesh->mtllib);
+            break;
+        }
+
+        p = next;
+    }
+
+    if (ok) {
+        obj_finish_groups(&b);
+    }
+
+    free(b.positions);
+    free(b.texcoords);
+    free(b.normals);
+    free(b.first);
+    free(b.next);
+    free(b.keys);
+
+    if (!ok || !b.index_count) {
+        if (ok) {
+            printf("OBJ has no faces\n");
+        }
+        free(b.vertices);
+        free(b.indices);
+        free(b.groups);
+        memset(mesh, 0, sizeof(*mesh));
+        return 0;
+    }
+
+    mesh->vertices = b.vertices;
+    mesh->indices = b.indices;
+    mesh->index_count = (unsigned int)b.index_count;
+    mesh->groups = b.groups;
+    mesh->group_count = (int)b.group_count;
+    obj_bounds(mesh->vertices, mesh->vertex_count, mesh->min, mesh->max);
+    return 1;
+}
+
+static const int obj_widths[3] = {3, 2, 3}; // floats per position, texcoord, normal
+
+#ifndef OBJ_NO_THREADS
+
+#define OBJ_MAX_THREADS 64
+
+// a group name change at a point in a chunk's triangles, replayed in file order once the chunks are rebased
+typedef struct
+{
+    int material; // usemtl, else o/g
+    char name[OBJ_NAME_LEN];
+    size_t triangle;
+} obj_event;
+
+typedef struct
+{
+    const char *begin, *end;
+
+    // what the chunk declares. Corners are as written: absolute indices stay global, relative
+    // (negative) ones are resolved against the chunk's own counts and flagged, they get the
+    // chunk's base added once the counts before it are known.
+    float *attributes[3]; // positions, texcoords, normals
+    size_t attribute_count[3], attribute_cap[3];
+    int *corners; // v, vt, vn
+    unsigned char *relative; // bit k set when corners[k] is chunk relative
+    size_t corner_count, corner_cap, relative_cap;
+    unsigned int *triangles; // chunk corner numbers
+    size_t triangle_count, triangle_cap;
+    obj_event *events;
+    size_t event_count, event_cap;
+    char mtllib[OBJ_NAME_LEN];
+    int has_mtllib;
+    int failed;
+
+    // range checks that need the counts before the chunk: an absolute index must be at most
+    // base + the count at that corner, a relative one at least 1 - base
+    long max_absolute_excess[3];
+    long min_relative[3];
+
+    size_t attribute_base[3], corner_base, triangle_base, vertex_base;
+    size_t *bucket_offsets; // per owner, where this chunk's corners go in the bucket array
+    float min[3], max[3];
+} obj_chunk;
+
+typedef struct
+{
+    obj_chunk *chunks;
+    int count;
+    int failed;
+
+    size_t attribute_total[3], corner_total, triangle_total;
+    float *attributes[3];
+    obj_key *keys; // every corner, rebased
+    // dedup is split by position index: owner o looks after positions
+    // [o * positions_per_owner, (o + 1) * positions_per_owner) and sees their corners in file order
+    size_t positions_per_owner;
+    size_t *owner_begin; // count + 1 offsets into buckets
+    unsigned int *buckets; // corner numbers grouped by owner
+    unsigned int *first_of; // per corner, the first corner with the same key
+    unsigned int *next; // per first corner, the next first corner with the same position
+    unsigned int *vertex_of; // per first corner, its vertex
+    obj_vertex *vertices;
+    unsigned int *indices;
+} obj_parallel;
+
+typedef struct
+{
+    obj_parallel *p;
+    void (*phase)(obj_parallel *, int);
+    int index;
+} obj_task;
+
+static void *
+obj_task_main(void *arg)
+{
+    obj_task *task = arg;
+    task->phase(task->p, task->index);
+    return NULL;
+}
+
+// runs phase(p, 0..count-1) concurrently, the calling thread takes index 0
+static void
+obj_run(obj_parallel *p, void (*phase)(obj_parallel *, int))
+{
+    pthread_t threads[OBJ_MAX_THREADS];
+    obj_task tasks[OBJ_MAX_THREADS];
+    int started[OBJ_MAX_THREADS];
+    for (int i = 1; i < p->count; i++) {
+        tasks[i].p = p;
+        tasks[i].phase = phase;
+        tasks[i].index = i;
+        started[i] = pthread_create(&threads[i], NULL, obj_task_main, &tasks[i]) == 0;
+        if (!started[i]) {
+            phase(p, i);
+        }
+    }
+    phase(p, 0);
+    for (int i = 1; i < p->count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+static int
+obj_push_event(obj_chunk *c, int material, const char *q, const char *end)
+{
+    c->events = obj_grow(c->events, &c->event_cap, c->event_count + 1, sizeof(obj_event));
+    if (!c->events) {
+        return 0;
+    }
+    obj_event *event = &c->events[c->event_count++];
+    event->material = material;
+    event->triangle = c->triangle_count;
+    obj_parse_name(q, end, event->name);
+    return 1;
+}
+
+// same line handling as obj_parse, minus everything that needs the chunks before this one
+static void
+obj_phase_parse(obj_parallel *p, int i)
+{
+    obj_chunk *c = &p->chunks[i];
+    for (int k = 0; k < 3; k++) {
+        c->max_absolute_excess[k] = -1;
+        c->min_relative[k] = 1;
+    }
+
+    int ok = 1;
+    const char *at = c->begin, *end = c->end;
+    while (ok && at < end) {
+        const char *line = obj_skip_space(at, end);
+        const char *next = obj_next_line(line, end);
+        const char *q;
+        int kind = obj_line_kind(line, end, &q);
+
+        if (kind == OBJ_LINE_POSITION || kind == OBJ_LINE_TEXCOORD || kind == OBJ_LINE_NORMAL) {
+            int k = kind == OBJ_LINE_POSITION ? 0 : kind == OBJ_LINE_TEXCOORD ? 1 : 2;
+            ok = obj_push_floats(&c->attributes[k], &c->attribute_count[k], &c->attribute_cap[k], obj_widths[k], q, end);
+        } else if (kind == OBJ_LINE_FACE) {
+            size_t first = 0, previous = 0;
+            int corners = 0;
+            int corner[3];
+            while ((q = obj_parse_corner(q, end, corner))) {
+                c->corners = obj_grow(c->corners, &c->corner_cap, (c->corner_count + 1) * 3, sizeof(int));
+                c->relative = obj_grow(c->relative, &c->relative_cap, c->corner_count + 1, 1);
+                if (!c->corners || !c->relative || !corner[0]) {
+                    ok = 0;
+                    break;
+                }
+                unsigned char relative = 0;
+                for (int k = 0; k < 3; k++) {
+                    long index = corner[k];
+                    long count = (long)c->attribute_count[k];
+                    if (index < 0) {
+                        index += count + 1;
+                        relative |= 1 << k;
+                        c->min_relative[k] = index < c->min_relative[k] ? index : c->min_relative[k];
+                    } else if (index > 0 && index - count > c->max_absolute_excess[k]) {
+                        c->max_absolute_excess[k] = index - count;
+                    }
+                    c->corners[c->corner_count * 3 + k] = (int)index;
+                }
+                c->relative[c->corner_count] = relative;
+                size_t index = c->corner_count++;
+
+                if (++corners >= 3) {
+                    c->triangles = obj_grow(c->triangles, &c->triangle_cap, (c->triangle_count + 1) * 3,
+                                            sizeof(unsigned int));
+                    if (!c->triangles) {
+                        ok = 0;
+                        break;
+                    }
+                    unsigned int *t = &c->triangles[c->triangle_count++ * 3];
+                    t[0] = (unsigned int)first;
+                    t[1] = (unsigned int)previous;
+                    t[2] = (unsigned int)index;
+                }
+                if (corners == 1) {
+                    first = index;
+                }
+                previous = index;
+            }
+        } else if (kind == OBJ_LINE_OBJECT || kind == OBJ_LINE_USEMTL) {
+            ok = obj_push_event(c, kind == OBJ_LINE_USEMTL, q, end);
+        } else if (kind == OBJ_LINE_MTLLIB) {
+            obj_parse_name(q, end, c->mtllib);
+            c->has_mtllib = 1;
+        }
+        at = next;
+    }
+    c->failed = !ok;
+}
+
+// copies the chunk's attributes into place, rebases its corners and counts them per owner
+static void
+obj_phase_rebase(obj_parallel *p, int i)
+{
+    obj_chunk *c = &p->chunks[i];
+    for (int k = 0; k < 3; k++) {
+        if (c->attribute_count[k]) {
+            memcpy(p->attributes[k] + c->attribute_base[k] * obj_widths[k], c->attributes[k],
+                   c->attribute_count[k] * obj_widths[k] * sizeof(float));
+        }
+        free(c->attributes[k]);
+        c->attributes[k] = NULL;
+    }
+    size_t *owner_counts = c->bucket_offsets;
+    for (size_t j = 0; j < c->corner_count; j++) {
+        unsigned int global[3];
+        for (int k = 0; k < 3; k++) {
+            long index = c->corners[j * 3 + k];
+            global[k] = (unsigned int)((c->relative[j] >> k) & 1 ? index + (long)c->attribute_base[k] : index);
+        }
+        obj_key *key = &p->keys[c->corner_base + j];
+        key->v = global[0];
+        key->vt = global[1];
+        key->vn = global[2];
+        owner_counts[(key->v - 1) / p->positions_per_owner]++;
+    }
+}
+
+static void
+obj_phase_scatter(obj_parallel *p, int i)
+{
+    obj_chunk *c = &p->chunks[i];
+    for (size_t j = 0; j < c->corner_count; j++) {
+        size_t corner = c->corner_base + j;
+        size_t owner = (p->keys[corner].v - 1) / p->positions_per_owner;
+        p->buckets[c->bucket_offsets[owner]++] = (unsigned int)corner;
+    }
+}
+
+// the same chains as obj_vertex_index, over the owner's positions, keyed by corner number
+static void
+obj_phase_dedup(obj_parallel *p, int o)
+{
+    size_t position_begin = (size_t)o * p->positions_per_owner;
+    size_t position_count = p->positions_per_owner;
+    if (position_begin >= p->attribute_total[0]) {
+        return;
+    }
+    if (position_begin + position_count > p->attribute_total[0]) {
+        position_count = p->attribute_total[0] - position_begin;
+    }
+    unsigned int *first = calloc(position_count, sizeof(unsigned int));
+    if (!first) {
+        p->failed = 1;
+        return;
+    }
+    for (size_t b = p->owner_begin[o]; b < p->owner_begin[o + 1]; b++) {
+        unsigned int corner = p->buckets[b];
+        obj_key key = p->keys[corner];
+        unsigned int *head = &first[key.v - 1 - position_begin];
+        unsigned int found = *head;
+        for (; found; found = p->next[found - 1]) {
+            obj_key *k = &p->keys[found - 1];
+            if (k->vt == key.vt && k->vn == key.vn) {
+                break;
+            }
+        }
+        if (found) {
+            p->first_of[corner] = found - 1;
+        } else {
+            p->first_of[corner] = corner;
+            p->next[corner] = *head;
+            *head = corner + 1;
+        }
+    }
+    free(first);
+}
+
+// new vertices in corner order, which is the order obj_parse creates them in
+static void
+obj_phase_vertices(obj_parallel *p, int i)
+{
+    obj_chunk *c = &p->chunks[i];
+    size_t vertex = c->vertex_base;
+    for (size_t j = 0; j < c->corner_count; j++) {
+        size_t corner = c->corner_base + j;
+        if (p->first_of[corner] == corner) {
+            p->vertex_of[corner] = (unsigned int)vertex;
+            obj_make_vertex(&p->vertices[vertex++], p->keys[corner], p->attributes[0], p->attributes[1],
+                            p->attributes[2]);
+        }
+    }
+    if (vertex > c->vertex_base) {
+        obj_bounds(&p->vertices[c->vertex_base], vertex - c->vertex_base, c->min, c->max);
+    }
+}
+
+static void
+obj_phase_indices(obj_parallel *p, int i)
+{
+    obj_chunk *c = &p->chunks[i];
+    unsigned int *out = &p->indices[c->triangle_base * 3];
+    for (size_t t = 0; t < c->triangle_count * 3; t++) {
+        size_t corner = c->corner_base + c->triangles[t];
+        out[t] = p->vertex_of[p->first_of[corner]];
+    }
+}
+
+static void
+obj_parallel_free(obj_parallel *p)
+{
+    for (int i = 0; i < p->count; i++) {
+        obj_chunk *c = &p->chunks[i];
+        for (int k = 0; k < 3; k++) {
+            free(c->attributes[k]);
+        }
+        free(c->corners);
+        free(c->relative);
+        free(c->triangles);
+        free(c->events);
+        free(c->bucket_offsets);
+    }
+    free(p->chunks);
+    for (int k = 0; k < 3; k++) {
+        free(p->attributes[k]);
+    }
+    free(p->keys);
+    free(p->owner_begin);
+    free(p->buckets);
+    free(p->first_of);
+    free(p->next);
+    free(p->vertex_of);
+}
+
+// 0 when anything is off (bad index, no faces, out of memory), the caller then reruns obj_parse
+// for its error message, or its result when the problem was memory
+static int
+obj_parse_chunks(obj_mesh *mesh, obj_parallel *p, const char *data, size_t size)
+{
+    p->chunks = calloc(p->count, sizeof(obj_chunk));
+    if (!p->chunks) {
+        return 0;
+    }
+    // split at line starts, a chunk can end up empty when one line spans several splits
+    const char *end = data + size;
+    for (int i = 0; i < p->count; i++) {
+        const char *begin = data + size * i / p->count;
+        if (begin > data && begin[-1] != '\n') {
+            begin = obj_next_line(begin, end);
+        }
+        p->chunks[i].begin = i ? (begin > p->chunks[i - 1].begin ? begin : p->chunks[i - 1].begin) : data;
+    }
+    for (int i = 0; i < p->count; i++) {
+        p->chunks[i].end = i + 1 < p->count ? p->chunks[i + 1].begin : end;
+    }
+
+    obj_run(p, obj_phase_parse);
+
+    // prefix sums, then the range checks obj_parse does as it goes
+    for (int i = 0; i < p->count; i++) {
+        obj_chunk *c = &p->chunks[i];
+        if (c->failed) {
+            return 0;
+        }
+        for (int k = 0; k < 3; k++) {
+            c->attribute_base[k] = p->attribute_total[k];
+            p->attribute_total[k] += c->attribute_count[k];
+            if (c->max_absolute_excess[k] > (long)c->attribute_base[k] ||
+                c->min_relative[k] + (long)c->attribute_base[k] < 1) {
+                return 0;
+            }
+        }
+        c->corner_base = p->corner_total;
+        p->corner_total += c->corner_count;
+        c->triangle_base = p->triangle_total;
+        p->triangle_total += c->triangle_count;
+    }
+    if (!p->triangle_total || p->corner_total >= 0xffffffffu || p->triangle_total * 3 >= 0xffffffffu) {
+        return 0;
+    }
+
+    for (int k = 0; k < 3; k++) {
+        p->attributes[k] = malloc((p->attribute_total[k] ? p->attribute_total[k] : 1) * obj_widths[k] * sizeof(float));
+        if (!p->attributes[k]) {
+            return 0;
+        }
+    }
+    p->positions_per_owner = (p->attribute_total[0] + p->count - 1) / p->count;
+    p->keys = malloc(p->corner_total * sizeof(obj_key));
+    p->owner_begin = calloc(p->count + 1, sizeof(size_t));
+    if (!p->keys || !p->owner_begin) {
+        return 0;
+    }
+    for (int i = 0; i < p->count; i++) {
+        p->chunks[i].bucket_offsets = calloc(p->count, sizeof(size_t));
+        if (!p->chunks[i].bucket_offsets) {
+            return 0;
+        }
+    }
+
+    obj_run(p, obj_phase_rebase);
+
+    // buckets ordered by owner, then chunk, so every owner walks its corners in file order
+    size_t offset = 0;
+    for (int o = 0; o < p->count; o++) {
+        p->owner_begin[o] = offset;
+        for (int i = 0; i < p->count; i++) {
+            size_t count = p->chunks[i].bucket_offsets[o];
+            p->chunks[i].bucket_offsets[o] = offset;
+            offset += count;
+        }
+    }
+    p->owner_begin[p->count] = offset;
+    p->buckets = malloc(p->corner_total * sizeof(unsigned int));
+    p->first_of = malloc(p->corner_total * sizeof(unsigned int));
+    p->next = malloc(p->corner_total * sizeof(unsigned int));
+    p->vertex_of = malloc(p->corner_total * sizeof(unsigned int));
+    if (!p->buckets || !p->first_of || !p->next || !p->vertex_of) {
+        return 0;
+    }
+
+    obj_run(p, obj_phase_scatter);
+    obj_run(p, obj_phase_dedup);
+    if (p->failed) {
+        return 0;
+    }
+
+    size_t vertex_total = 0;
+    for (int i = 0; i < p->count; i++) {
+        obj_chunk *c = &p->chunks[i];
+        c->vertex_base = vertex_total;
+        for (size_t j = c->corner_base; j < c->corner_base + c->corner_count; j++) {
+            vertex_total += p->first_of[j] == j;
+        }
+    }
+    p->vertices = malloc(vertex_total * sizeof(obj_vertex));
+    p->indices = malloc(p->triangle_total * 3 * sizeof(unsigned int));
+    if (!p->vertices || !p->indices) {
+        return 0;
+    }
+
+    obj_run(p, obj_phase_vertices);
+    obj_run(p, obj_phase_indices);
+
+    // groups and mtllib in file order, through the same code obj_parse uses
+    obj_builder b;
+    memset(&b, 0, sizeof(b));
+    if (!obj_begin_group(&b)) {
+        return 0;
+    }
+    int bounds_set = 0;
+    for (int i = 0; i < p->count; i++) {
+        obj_chunk *c = &p->chunks[i];
+        for (size_t e = 0; e < c->event_count; e++) {
+            b.index_count = (c->triangle_base + c->events[e].triangle) * 3;
+            obj_group *group = obj_begin_group(&b);
+            if (!group) {
+                return 0;
+            }
+            memcpy(c->events[e].material ? group->material : group->object, c->events[e].name, OBJ_NAME_LEN);
+        }
+        if (c->has_mtllib) {
+            memcpy(mesh->mtllib, c->mtllib, OBJ_NAME_LEN);
+        }
+        // chunk bounds merged in order keep the same tie breaking as one pass
+        if (c->vertex_base < (i + 1 < p->count ? p->chunks[i + 1].vertex_base : vertex_total)) {
+            for (int k = 0; k < 3; k++) {
+                if (!bounds_set || c->min[k] < mesh->min[k]) {
+                    mesh->min[k] = c->min[k];
+                }
+                if (!bounds_set || c->max[k] > mesh->max[k]) {
+                    mesh->max[k] = c->max[k];
+                }
+            }
+            bounds_set = 1;
+        }
+    }
+    b.index_count = p->triangle_total * 3;
+    obj_finish_groups(&b);
+
+    mesh->vertices = p->vertices;
+    mesh->vertex_count = (unsigned int)vertex_total;
+    mesh->indices = p->indices;
+    mesh->index_count = (unsigned int)b.index_count;
+    mesh->groups = b.groups;
+    mesh->group_count = (int)b.group_count;
+    p->vertices = NULL;
+    p->indices = NULL;
+    return 1;
+}
+
+#endif // OBJ_NO_THREADS
+
+int
+obj_parse_threaded(obj_mesh *mesh, const char *data, size_t size, int threads)
+{
+#ifndef OBJ_NO_THREADS
+    if (threads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int)online : 1;
+    }
+    threads = threads < OBJ_MAX_THREADS ? threads : OBJ_MAX_THREADS;
+    // below a few hundred KB per thread, starting them costs more than it saves
+    if ((size_t)threads * OBJ_THREAD_MIN_BYTES > size) {
+        threads = (int)(size / OBJ_THREAD_MIN_BYTES);
+    }
+    if (threads > 1) {
+        obj_parallel p;
+        memset(&p, 0, sizeof(p));
+        p.count = threads;
+        memset(mesh, 0, sizeof(*mesh));
+        int ok = obj_parse_chunks(mesh, &p, data, size);
+        free(p.vertices);
+        free(p.indices);
+        obj_parallel_free(&p);
+        if (ok) {
+            return 1;
+        }
+    }
+#endif
+    return obj_parse(mesh, data, size);
+}
+
+int
+obj_load(obj_mesh *mesh, const char *path)
+{
+    return obj_load_threaded(mesh, path, 1);
+}
+
+int
+obj_load_threaded(obj_mesh *mesh, const char *path, int threads)
+{
+    asset_file file;
+    if (!asset_map(&file, path)) {
+        memset(mesh, 0, sizeof(*mesh));
+        return 0;
+    }
+    int ok = obj_parse_threaded(mesh, (const char *)file.data, file.size, threads);
+    asset_unmap(&file);
+    if (!ok) {
+        printf("Failed to load OBJ: %s\n", path);
+    }
+    return ok;
+}
+
+void
+obj_free(obj_mesh *mesh)
+{
+    free(mesh->vertices);
+    free(mesh->indices);
+    free(mesh->groups);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+#define OBJ_STREAM_PAGE 4096 // elements per page of the spilled attribute cache
+
+// the current line, [*line, *end) without its newline, refilling the window when it has no whole line
+// left. Stays current until obj_stream_consume. 1 for a line, 0 at the end of the file, -1 on failure
+static int
+obj_stream_line(obj_stream *s, const char **line, const char **end)
+{
+    for (;;) {
+        const char *begin = s->window + s->begin;
+        const char *newline = memchr(begin, '\n', s->end - s->begin);
+        if (newline || (s->eof && s->begin < s->end)) {
+            *line = begin;
+            *end = newline ? newline : s->window + s->end;
+            s->next = newline ? (size_t)(newline + 1 - s->window) : s->end;
+            return 1;
+        }
+        if (s->eof) {
+            return 0;
+        }
+        if (s->begin == 0 && s->end == s->window_size) {
+            printf("OBJ line %llu is longer than the %zu byte window\n", s->line_number + 1, s->window_size);
+            return -1;
+        }
+        memmove(s->window, begin, s->end - s->begin);
+        s->end -= s->begin;
+        s->begin = 0;
+        size_t read = fread(s->window + s->end, 1, s->window_size - s->end, s->file);
+        if (read < s->window_size - s->end) {
+            if (ferror(s->file)) {
+                printf("Failed to read OBJ\n");
+                return -1;
+            }
+            s->eof = 1;
+        }
+        if (s->scan && read) {
+            s->scan(s->user, s->window + s->end, read);
+        }
+        s->end += read;
+    }
+}
+
+static void
+obj_stream_consume(obj_stream *s)
+{
+    s->begin = s->next;
+    s->line_number++;
+}
+
+// element index (0 based) of a spilled attribute, NULL on a read failure
+static const float *
+obj_spill_get(obj_spill *spill, unsigned long long index)
+{
+    unsigned long long page = index / OBJ_STREAM_PAGE;
+    size_t slot = (size_t)(page % spill->page_count);
+    float *data = spill->pages + slot * OBJ_STREAM_PAGE * spill->width;
+    if (spill->tags[slot] != page) {
+        unsigned long long first = page * OBJ_STREAM_PAGE;
+        size_t count = spill->count - first < OBJ_STREAM_PAGE ? (size_t)(spill->count - first) : OBJ_STREAM_PAGE;
+        if (fseek(spill->file, (long)(first * spill->width * sizeof(float)), SEEK_SET) != 0 ||
+            fread(data, spill->width * sizeof(float), count, spill->file) != count) {
+            printf("Failed to read OBJ spill file: %s\n", spill->path);
+            spill->tags[slot] = ~0ull;
+            return NULL;
+        }
+        spill->tags[slot] = page;
+    }
+    return data + (index % OBJ_STREAM_PAGE) * spill->width;
+}
+
+// the chunk vertex for this corner, read from the spill files if the chunk doesn't have it yet.
+// -1 on a read failure
+static long
+obj_stream_vertex(obj_stream *s, obj_key key, size_t *vertex_count)
+{
+    size_t slot = (key.v * 0x9e3779b1u ^ key.vt * 0x85ebca6bu ^ key.vn * 0xc2b2ae35u) & s->table_mask;
+    for (; s->table[slot]; slot = (slot + 1) & s->table_mask) {
+        const unsigned int *k = &s->keys[(s->table[slot] - 1) * 3];
+        if (k[0] == key.v && k[1] == key.vt && k[2] == key.vn) {
+            return (long)s->table[slot] - 1;
+        }
+    }
+
+    const float *position = obj_spill_get(&s->spills[0], key.v - 1);
+    const float *texcoord = key.vt ? obj_spill_get(&s->spills[1], key.vt - 1) : NULL;
+    const float *normal = key.vn ? obj_spill_get(&s->spills[2], key.vn - 1) : NULL;
+    if (!position || (key.vt && !texcoord) || (key.vn && !normal)) {
+        return -1;
+    }
+    size_t index = (*vertex_count)++;
+    s->table[slot] = (unsigned int)index + 1;
+    s->keys[index * 3] = key.v;
+    s->keys[index * 3 + 1] = key.vt;
+    s->keys[index * 3 + 2] = key.vn;
+    obj_vertex *vertex = &s->vertices[index];
+    memset(vertex, 0, sizeof(*vertex));
+    memcpy(vertex->position, position, 3 * sizeof(float));
+    if (texcoord) {
+        memcpy(vertex->uv, texcoord, 2 * sizeof(float));
+    }
+    if (normal) {
+        memcpy(vertex->normal, normal, 3 * sizeof(float));
+    }
+    return (long)index;
+}
+
+int
+obj_stream_open(obj_stream *s, const char *path, size_t window_size, size_t cache_size, size_t max_triangles,
+                void (*scan)(void *user, const void *data, size_t size), void *user)
+{
+    static const char *extensions[3] = {"v", "vt", "vn"};
+    memset(s, 0, sizeof(*s));
+    s->window_size = window_size > 4096 ? window_size : 4096;
+    s->max_triangles = max_triangles > 64 ? max_triangles : 64;
+    s->max_vertices = s->max_triangles;
+    s->scan = scan;
+    s->user = user;
+    s->file = fopen(path, "rb");
+    if (!s->file) {
+        printf("Failed to open OBJ: %s\n", path);
+        return 0;
+    }
+    s->window = malloc(s->window_size);
+    int ok = s->window != NULL;
+    for (int a = 0; ok && a < 3; a++) {
+        obj_spill *spill = &s->spills[a];
+        spill->width = obj_widths[a];
+        ok = snprintf(spill->path, sizeof(spill->path), "%s.%s.tmp", path, extensions[a]) < (int)sizeof(spill->path);
+        spill->file = ok ? fopen(spill->path, "wb") : NULL;
+        if (!spill->file) {
+            if (ok) {
+                printf("Failed to write OBJ spill file: %s\n", spill->path);
+            }
+            spill->path[0] = '\0'; // nothing for obj_stream_close to remove
+            ok = 0;
+        }
+    }
+
+    // first pass: attributes out to the spill files, and their bounds
+    int texcoords_missing = 0;
+    const char *line, *end;
+    int r = 0;
+    while (ok && (r = obj_stream_line(s, &line, &end)) > 0) {
+        const char *q;
+        line = obj_skip_space(line, end);
+        int kind = obj_line_kind(line, end, &q);
+        if (kind == OBJ_LINE_POSITION || kind == OBJ_LINE_TEXCOORD || kind == OBJ_LINE_NORMAL) {
+            obj_spill *spill = &s->spills[kind - OBJ_LINE_POSITION];
+            float values[3] = {0.0f, 0.0f, 0.0f};
+            for (int k = 0; k < spill->width; k++) {
+                q = obj_parse_float(obj_skip_space(q, end), end, &values[k]);
+            }
+            for (int k = 0; kind != OBJ_LINE_NORMAL && k < spill->width; k++) {
+                float *min = kind == OBJ_LINE_POSITION ? s->min : s->uv_min;
+                float *max = kind == OBJ_LINE_POSITION ? s->max : s->uv_max;
+                min[k] = !spill->count || values[k] < min[k] ? values[k] : min[k];
+                max[k] = !spill->count || values[k] > max[k] ? values[k] : max[k];
+            }
+            if (fwrite(values, sizeof(float), spill->width, spill->file) != (size_t)spill->width) {
+                printf("Failed to write OBJ spill file: %s\n", spill->path);
+                ok = 0;
+            }
+            spill->count++;
+        } else if (kind == OBJ_LINE_FACE && !texcoords_missing) {
+            // the corners of a face are all written the same way, the first one tells
+            int corner[3];
+            texcoords_missing = obj_parse_corner(q, end, corner) && !corner[1];
+        } else if (kind == OBJ_LINE_MTLLIB) {
+            obj_parse_name(q, end, s->mtllib);
+        }
+        obj_stream_consume(s);
+    }
+    ok = ok && r == 0;
+    for (int k = 0; texcoords_missing && k < 2; k++) {
+        s->uv_min[k] = s->spills[1].count && s->uv_min[k] < 0.0f ? s->uv_min[k] : 0.0f;
+        s->uv_max[k] = s->spills[1].count && s->uv_max[k] > 0.0f ? s->uv_max[k] : 0.0f;
+    }
+    s->position_count = s->spills[0].count;
+    s->texcoord_count = s->spills[1].count;
+    s->normal_count = s->spills[2].count;
+    s->scan = NULL;
+
+    // the spill files back for reading, the window back to the start of the file
+    size_t page_count = cache_size / (OBJ_STREAM_PAGE * sizeof(float) * 8);
+    for (int a = 0; a < 3 && s->spills[a].file; a++) {
+        obj_spill *spill = &s->spills[a];
+        if (fclose(spill->file) != 0 && ok) {
+            printf("Failed to write OBJ spill file: %s\n", spill->path);
+            ok = 0;
+        }
+        spill->file = ok ? fopen(spill->path, "rb") : NULL;
+        if (ok && !spill->file) {
+            printf("Failed to read OBJ spill file: %s\n", spill->path);
+            ok = 0;
+        }
+        spill->page_count = page_count ? page_count : 1;
+        spill->pages = ok ? malloc(spill->page_count * OBJ_STREAM_PAGE * spill->width * sizeof(float)) : NULL;
+        spill->tags = ok ? malloc(spill->page_count * sizeof(unsigned long long)) : NULL;
+        ok = ok && spill->pages && spill->tags;
+        if (ok) {
+            memset(spill->tags, 0xff, spill->page_count * sizeof(unsigned long long));
+        }
+    }
+    rewind(s->file);
+    s->begin = s->end = s->next = 0;
+    s->eof = 0;
+    s->line_number = 0;
+
+    size_t table_size = 1;
+    while (table_size < s->max_vertices * 2) {
+        table_size *= 2;
+    }
+    s->table_mask = table_size - 1;
+    s->table = ok ? malloc(table_size * sizeof(unsigned int)) : NULL;
+    s->keys = ok ? malloc(s->max_vertices * 3 * sizeof(unsigned int)) : NULL;
+    s->vertices = ok ? malloc(s->max_vertices * sizeof(obj_vertex)) : NULL;
+    s->indices = ok ? malloc(s->max_triangles * 3 * sizeof(unsigned int)) : NULL;
+    if (!ok || !s->table || !s->keys || !s->vertices || !s->indices) {
+        obj_stream_close(s);
+        return 0;
+    }
+    return 1;
+}
+
+int
+obj_stream_next(obj_stream *s, obj_mesh *chunk)
+{
+    memset(chunk, 0, sizeof(*chunk));
+    memset(s->table, 0, (s->table_mask + 1) * sizeof(unsigned int));
+    // a chunk keeps the object it started in, as obj_group_by_material keeps the first group's
+    memcpy(s->group.object, s->object, OBJ_NAME_LEN);
+    size_t vertex_count = 0, index_count = 0;
+
+    const char *line, *end;
+    int r;
+    while ((r = obj_stream_line(s, &line, &end)) > 0) {
+        const char *q;
+        line = obj_skip_space(line, end);
+        int kind = obj_line_kind(line, end, &q);
+        if (kind == OBJ_LINE_POSITION || kind == OBJ_LINE_TEXCOORD || kind == OBJ_LINE_NORMAL) {
+            s->seen[kind - OBJ_LINE_POSITION]++;
+        } else if (kind == OBJ_LINE_OBJECT) {
+            obj_parse_name(q, end, s->object);
+            if (!index_count) {
+                memcpy(s->group.object, s->object, OBJ_NAME_LEN);
+            }
+        } else if (kind == OBJ_LINE_USEMTL) {
+            char material[OBJ_NAME_LEN];
+            obj_parse_name(q, end, material);
+            if (strncmp(material, s->group.material, OBJ_NAME_LEN)) {
+                if (index_count) {
+                    break; // the usemtl starts the next chunk
+                }
+                memcpy(s->group.material, material, OBJ_NAME_LEN);
+            }
+        } else if (kind == OBJ_LINE_FACE) {
+            // counted the way they're parsed below: "3-1-2" is three corners to obj_parse_corner, not one
+            size_t corners = 0;
+            int corner[3];
+            for (const char *c = q; (c = obj_parse_corner(c, end, corner));) {
+                corners++;
+            }
+            if (corners >= 3 &&
+                (index_count / 3 + corners - 2 > s->max_triangles || vertex_count + corners > s->max_vertices)) {
+                if (index_count) {
+                    break; // the face starts the next chunk
+                }
+                printf("OBJ face on line %llu has more corners than a chunk has room for\n", s->line_number + 1);
+                return -1;
+            }
+            long first = -1, previous = -1;
+            size_t c = 0;
+            for (; corners >= 3 && c < corners && (q = obj_parse_corner(q, end, corner)); c++) {
+                obj_key key;
+                key.v = obj_resolve(corner[0], s->seen[0]);
+                key.vt = corner[1] ? obj_resolve(corner[1], s->seen[1]) : 0;
+                key.vn = corner[2] ? obj_resolve(corner[2], s->seen[2]) : 0;
+                if (!key.v || (corner[1] && !key.vt) || (corner[2] && !key.vn)) {
+                    printf("OBJ face index out of range on line %llu\n", s->line_number + 1);
+                    return -1;
+                }
+                long index = obj_stream_vertex(s, key, &vertex_count);
+                if (index < 0) {
+                    return -1;
+                }
+                // fanned like obj_parse does
+                if (c >= 2) {
+                    s->indices[index_count++] = (unsigned int)first;
+                    s->indices[index_count++] = (unsigned int)previous;
+                    s->indices[index_count++] = (unsigned int)index;
+                }
+                if (first < 0) {
+                    first = index;
+                }
+                previous = index;
+            }
+            if (corners >= 3 && c != corners) {
+                printf("OBJ face on line %llu has a different number of corners on a second look\n", s->line_number + 1);
+                return -1;
+            }
+        }
+        obj_stream_consume(s);
+    }
+    if (r < 0) {
+        return -1;
+    }
+    if (!index_count) {
+        return 0;
+    }
+
+    s->group.index_offset = 0;
+    s->group.index_count = (unsigned int)index_count;
+    chunk->vertices = s->vertices;
+    chunk->vertex_count = (unsigned int)vertex_count;
+    chunk->indices = s->indices;
+    chunk->index_count = (unsigned int)index_count;
+    chunk->groups = &s->group;
+    chunk->group_count = 1;
+    memcpy(chunk->mtllib, s->mtllib, OBJ_NAME_LEN);
+    obj_bounds(chunk->vertices, chunk->vertex_count, chunk->min, chunk->max);
+    return 1;
+}
+
+void
+obj_stream_close(obj_stream *s)
+{
+    if (s->file) {
+        fclose(s->file);
+    }
+    for (int a = 0; a < 3; a++) {
+        if (s->spills[a].file) {
+            fclose(s->spills[a].file);
+        }
+        if (s->spills[a].path[0]) {
+            remove(s->spills[a].path);
+        }
+        free(s->spills[a].pages);
+        free(s->spills[a].tags);
+    }
+    free(s->window);
+    free(s->table);
+    free(s->keys);
+    free(s->vertices);
+    free(s->indices);
+    memset(s, 0, sizeof(*s));
+}
+
+// by material, then by position in the file
+static int
+obj_compare_material(const void *a, const void *b)
+{
+    const obj_group *x = *(const obj_group *const *)a, *y = *(const obj_group *const *)b;
+    int order = strncmp(x->material, y->material, OBJ_NAME_LEN);
+    return order ? order : (x > y) - (x < y);
+}
+
+// one material's groups, sorted[begin, end), first is the one that uses it first
+typedef struct
+{
+    size_t begin, end;
+    const obj_group *first;
+} obj_material_run;
+
+static int
+obj_compare_run(const void *a, const void *b)
+{
+    const obj_group *x = ((const obj_material_run *)a)->first, *y = ((const obj_material_run *)b)->first;
+    return (x > y) - (x < y);
+}
+
+int
+obj_group_by_material(obj_mesh *mesh)
+{
+    size_t count = mesh->group_count > 0 ? (size_t)mesh->group_count : 0;
+    if (count < 2) {
+        return 1;
+    }
+    const obj_group **sorted = malloc(count * sizeof(*sorted));
+    obj_material_run *runs = malloc(count * sizeof(*runs));
+    obj_group *groups = malloc(count * sizeof(obj_group));
+    unsigned int *indices = malloc((mesh->index_count ? mesh->index_count : 1) * sizeof(unsigned int));
+    if (!sorted || !runs || !groups || !indices) {
+        free(sorted);
+        free(runs);
+        free(groups);
+        free(indices);
+        return 0;
+    }
+
+    // a sort instead of a name lookup per group, replicated meshes have tens of thousands
+    for (size_t g = 0; g < count; g++) {
+        sorted[g] = &mesh->groups[g];
+    }
+    qsort(sorted, count, sizeof(*sorted), obj_compare_material);
+    size_t run_count = 0;
+    for (size_t g = 0; g < count; g++) {
+        if (!g || strncmp(sorted[g]->material, sorted[g - 1]->material, OBJ_NAME_LEN)) {
+            runs[run_count].begin = g;
+            runs[run_count].first = sorted[g];
+            run_count++;
+        }
+        runs[run_count - 1].end = g + 1;
+    }
+    qsort(runs, run_count, sizeof(*runs), obj_compare_run);
+
+    size_t written = 0;
+    for (size_t r = 0; r < run_count; r++) {
+        groups[r] = *runs[r].first;
+        groups[r].index_offset = (unsigned int)written;
+        for (size_t g = runs[r].begin; g < runs[r].end; g++) {
+            memcpy(indices + written, mesh->indices + sorted[g]->index_offset,
+                   sorted[g]->index_count * sizeof(unsigned int));
+            written += sorted[g]->index_count;
+        }
+        groups[r].index_count = (unsigned int)written - groups[r].index_offset;
+    }
+
+    free(mesh->indices);
+    free(mesh->groups);
+    mesh->indices = indices;
+    mesh->groups = groups;
+    mesh->group_count = (int)run_count;
+    free(sorted);
+    free(runs);
+    return 1;
+}
+
+// past keyword when the line starts with it followed by a space, NULL otherwise
+static const char *
+obj_keyword(const char *line, const char *end, const char *keyword)
+{
+    size_t length = strlen(keyword);
+    if ((size_t)(end - line) <= length || memcmp(line, keyword, length) ||
+        (line[length] != ' ' && line[length] != '\t')) {
+        return NULL;
+    }
+    return line + length;
+}
+
+// r [g b], a single value is grey. spectral and xyz colors leave color as it was
+static void
+obj_parse_color(const char *q, const char *end, float *color)
+{
+    float rgb[3];
+    q = obj_skip_space(q, end);
+    const char *p = obj_parse_float(q, end, &rgb[0]);
+    if (p == q) {
+        return;
+    }
+    rgb[1] = rgb[2] = rgb[0];
+    p = obj_parse_float(obj_skip_space(p, end), end, &rgb[1]);
+    obj_parse_float(obj_skip_space(p, end), end, &rgb[2]);
+    memcpy(color, rgb, sizeof(rgb));
+}
+
+// the last word on the line, what comes before it are options like -s 1 1 1
+static void
+obj_parse_map(const char *q, const char *end, char *out)
+{
+    const char *line_end = q;
+    while (line_end < end && *line_end != '\n' && *line_end != '\r') {
+        line_end++;
+    }
+    while (line_end > q && (line_end[-1] == ' ' || line_end[-1] == '\t')) {
+        line_end--;
+    }
+    const char *word = line_end;
+    while (word > q && word[-1] != ' ' && word[-1] != '\t') {
+        word--;
+    }
+    size_t length = line_end - word;
+    if (length > OBJ_PATH_LEN - 1) {
+        printf("MTL texture path too long: %.*s\n", (int)length, word);
+        length = 0;
+    }
+    memcpy(out, word, length);
+    memset(out + length, 0, OBJ_PATH_LEN - length);
+}
+
+void
+obj_default_material(obj_material *material, const char *name)
+{
+    memset(material, 0, sizeof(*material));
+    strncpy(material->name, name, OBJ_NAME_LEN - 1);
+    material->diffuse[0] = material->diffuse[1] = material->diffuse[2] = 0.8f;
+    material->opacity = 1.0f;
+    material->ior = 1.0f;
+}
+
+int
+obj_parse_mtl(obj_material_lib *lib, const char *data, size_t size)
+{
+    memset(lib, 0, sizeof(*lib));
+    size_t capacity = 0;
+    obj_material *material = NULL;
+    float value;
+
+    const char *p = data, *end = data + size;
+    for (; p < end; p = obj_next_line(p, end)) {
+        const char *line = obj_skip_space(p, end);
+        const char *q;
+        if ((q = obj_keyword(line, end, "newmtl"))) {
+            lib->materials = obj_grow(lib->materials, &capacity, (size_t)lib->material_count + 1, sizeof(obj_material));
+            if (!lib->materials) {
+                memset(lib, 0, sizeof(*lib));
+                return 0;
+            }
+            material = &lib->materials[lib->material_count++];
+            obj_default_material(material, "");
+            obj_parse_name(q, end, material->name);
+        } else if (!material) {
+            // comments, and anything before the first newmtl
+        } else if ((q = obj_keyword(line, end, "Ka"))) {
+            obj_parse_color(q, end, material->ambient);
+        } else if ((q = obj_keyword(line, end, "Kd"))) {
+            obj_parse_color(q, end, material->diffuse);
+        } else if ((q = obj_keyword(line, end, "Ks"))) {
+            obj_parse_color(q, end, material->specular);
+        } else if ((q = obj_keyword(line, end, "Ke"))) {
+            obj_parse_color(q, end, material->emissive);
+        } else if ((q = obj_keyword(line, end, "Ns"))) {
+            obj_parse_float(obj_skip_space(q, end), end, &material->shininess);
+        } else if ((q = obj_keyword(line, end, "Ni"))) {
+            obj_parse_float(obj_skip_space(q, end), end, &material->ior);
+        } else if ((q = obj_keyword(line, end, "d"))) {
+            obj_parse_float(obj_skip_space(q, end), end, &material->opacity);
+        } else if ((q = obj_keyword(line, end, "Tr"))) {
+            value = 0.0f;
+            obj_parse_float(obj_skip_space(q, end), end, &value);
+            material->opacity = 1.0f - value;
+        } else if ((q = obj_keyword(line, end, "illum"))) {
+            obj_parse_int(obj_skip_space(q, end), end, &material->illum);
+        } else if ((q = obj_keyword(line, end, "map_Kd"))) {
+            obj_parse_map(q, end, material->maps[OBJ_MAP_DIFFUSE]);
+        } else if ((q = obj_keyword(line, end, "map_Ks"))) {
+            obj_parse_map(q, end, material->maps[OBJ_MAP_SPECULAR]);
+        } else if ((q = obj_keyword(line, end, "map_Bump")) || (q = obj_keyword(line, end, "map_bump")) ||
+                   (q = obj_keyword(line, end, "bump")) || (q = obj_keyword(line, end, "norm"))) {
+            obj_parse_map(q, end, material->maps[OBJ_MAP_NORMAL]);
+        } else if ((q = obj_keyword(line, end, "map_d"))) {
+            obj_parse_map(q, end, material->maps[OBJ_MAP_ALPHA]);
+        }
+    }
+    return 1;
+}
+
+int
+obj_load_mtl(obj_material_lib *lib, const char *path)
+{
+    asset_file file;
+    if (!asset_map(&file, path)) {
+        memset(lib, 0, sizeof(*lib));
+        return 0;
+    }
+    int ok = obj_parse_mtl(lib, (const char *)file.data, file.size);
+    asset_unmap(&file);
+    if (!ok) {
+        printf("Failed to load MTL: %s\n", path);
+    }
+    return ok;
+}
+
+int
+obj_find_material(const obj_material_lib *lib, const char *name)
+{
+    for (int m = 0; m < lib->material_count; m++) {
+        if (!strncmp(lib->materials[m].name, name, OBJ_NAME_LEN)) {
+            return m;
+        }
+    }
+    return -1;
+}
+
+void
+obj_free_mtl(obj_material_lib *lib)
+{
+    free(lib->materials);
+    memset(lib, 0, sizeof(*lib));
+}
+
+#endif // OBJ_IMPLEMENTATION
@@ -0,0 +1,445 @@
+// OBJ load benchmark.
+//
+// Parses an OBJ with obj.h and prints throughput as JSON. Small files like
+// Tree.obj fit in cache and say little about the parser, so the source is
+// also replicated in memory (each copy's face indices rebased onto its own
+// vertices) until it reaches the requested size, and that buffer is parsed
+// too. Two references are timed over the same buffer:
+//   scan    memchr for every newline, roughly what reading the bytes costs
+//   strtof  strtof on every number in the file, what the loader would cost
+//           with the C library doing the float parsing
+// and every number obj.h parses is compared against strtof. The threaded
+// parse is timed at 1, 2, 4 ... threads up to the given maximum, each
+// result compared byte for byte against obj_parse's.
+//
+// The mesh.h cache is timed on the file itself: cold deletes <path>.mesh
+// and loads (parse + optimize + write), warm loads again (map + hash +
+// validate), and the cached buffers are compared against obj_parse +
+// mesh_optimize. obj_stream is checked against obj_parse on the file with
+// its smallest chunks, and made to turn down faces too big for a chunk.
+// Pass megabytes 0 to skip the replicated input, e.g. to time a large real
+// OBJ.
+//
+// usage: ./obj_bench [path] [megabytes] [runs] [max threads]
+//        defaults: ./third_party/assets/Tree.obj 100 5 <online CPUs>
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+#define MESH_NO_GL
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    char *data;
+    size_t size, capacity;
+} Buffer;
+
+void append(Buffer *b, const char *data, size_t size)
+{
+    if (b->size + size > b->capacity) {
+        b->capacity = (b->size + size) * 2;
+        b->data = realloc(b->data, b->capacity);
+    }
+    memcpy(b->data + b->size, data, size);
+    b->size += size;
+}
+
+// rewrites one face line with every index moved by the given offsets
+void append_face(Buffer *b, const char *line, const char *end, const long offset[3])
+{
+    char out[1024];
+    int length = 0;
+    const char *p = line;
+    while (p < end && length < (int)sizeof(out) - 32) {
+        if ((*p >= '0' && *p <= '9') || *p == '-') {
+            char *number_end;
+            long value = strtol(p, &number_end, 10);
+            // v, vt or vn from how many slashes precede it in this corner
+            int slot = 0;
+            for (const char *q = p - 1; q >= line && *q != ' ' && *q != '\t'; q--) {
+                slot += *q == '/';
+            }
+            if (value > 0) {
+                value += offset[slot];
+            }
+            length += snprintf(out + length, sizeof(out) - length, "%ld", value);
+            p = number_end;
+        } else {
+            out[length++] = *p++;
+        }
+    }
+    append(b, out, length);
+}
+
+// count copies of source concatenated, faces rebased so each copy has its own vertices
+Buffer replicate(const char *source, size_t size, size_t target)
+{
+    long counts[3] = {0, 0, 0}; // v, vt, vn per copy
+    for (const char *p = source; p < source + size;) {
+        const char *next = memchr(p, '\n', source + size - p);
+        next = next ? next + 1 : source + size;
+        if (p[0] == 'v') {
+            counts[p[1] == 't' ? 1 : p[1] == 'n' ? 2 : 0]++;
+        }
+        p = next;
+    }
+
+    Buffer b = {0};
+    for (long copy = 0; b.size < target; copy++) {
+        long offset[3] = {counts[0] * copy, counts[1] * copy, counts[2] * copy};
+        for (const char *p = source; p < source + size;) {
+            const char *next = memchr(p, '\n', source + size - p);
+            next = next ? next + 1 : source + size;
+            if (p[0] == 'f' && p[1] == ' ') {
+                append_face(&b, p, next, offset);
+            } else if (p[0] != '#' && strncmp(p, "mtllib", 6)) {
+                append(&b, p, next - p);
+            }
+            p = next;
+        }
+    }
+    return b;
+}
+
+// fastest of runs, in seconds, threads 0 is plain obj_parse
+double time_parse(const char *data, size_t size, int runs, int threads, obj_mesh *mesh)
+{
+    double best = 1e9;
+    for (int r = 0; r < runs; r++) {
+        obj_free(mesh);
+        double start = now_s();
+        if (!(threads ? obj_parse_threaded(mesh, data, size, threads) : obj_parse(mesh, data, size))) {
+            return -1.0;
+        }
+        double t = now_s() - start;
+        best = t < best ? t : best;
+    }
+    return best;
+}
+
+double time_scan(const char *data, size_t size, int runs, long *lines)
+{
+    double best = 1e9;
+    for (int r = 0; r < runs; r++) {
+        double start = now_s();
+        long count = 0;
+        for (const char *p = data; (p = memchr(p, '\n', data + size - p)); p++) {
+            count++;
+        }
+        double t = now_s() - start;
+        best = t < best ? t : best;
+        *lines = count;
+    }
+    return best;
+}
+
+// every v/vt/vn number through strtof, with obj.h's parser checked against it on the first run
+double time_strtof(const char *data, size_t size, int runs, long *numbers, long *mismatches)
+{
+    // strtof wants a NUL terminated string
+    char *copy = malloc(size + 1);
+    memcpy(copy, data, size);
+    copy[size] = '\0';
+
+    double best = 1e9;
+    volatile float sink = 0.0f;
+    for (int r = 0; r < runs; r++) {
+        long count = 0, wrong = 0;
+        double start = now_s();
+        for (char *p = copy; *p;) {
+            char *next = strchr(p, '\n');
+            next = next ? next + 1 : copy + size;
+            if (p[0] == 'v') {
+                char *q = p + 2;
+                for (int k = 0; k < 3; k++) {
+                    char *number_end;
+                    float value = strtof(q, &number_end);
+                    if (number_end == q) {
+                        break;
+                    }
+                    if (r == 0) {
+                        float mine = 0.0f;
+                        obj_parse_float(q + strspn(q, " \t"), copy + size, &mine);
+                        wrong += memcmp(&mine, &value, sizeof(float)) != 0;
+                    }
+                    sink += value;
+                    q = number_end;
+                    count++;
+                }
+            }
+            p = next;
+        }
+        double t = now_s() - start;
+        if (r > 0) {
+            best = t < best ? t : best;
+        }
+        *numbers = count;
+        if (r == 0) {
+            *mismatches = wrong;
+        }
+    }
+    (void)sink;
+    free(copy);
+    return runs > 1 ? best : -1.0;
+}
+
+int same_mesh(const obj_mesh *a, const obj_mesh *b)
+{
+    return a->vertex_count == b->vertex_count && a->index_count == b->index_count &&
+           a->group_count == b->group_count && !strcmp(a->mtllib, b->mtllib) &&
+           !memcmp(a->min, b->min, sizeof(a->min)) && !memcmp(a->max, b->max, sizeof(a->max)) &&
+           !memcmp(a->vertices, b->vertices, a->vertex_count * sizeof(obj_vertex)) &&
+           !memcmp(a->indices, b->indices, a->index_count * sizeof(unsigned int)) &&
+           !memcmp(a->groups, b->groups, a->group_count * sizeof(obj_group));
+}
+
+int mismatched = 0;
+
+void report(const char *name, const char *data, size_t size, int runs, int max_threads, int last)
+{
+    obj_mesh mesh = {0};
+    double parse = time_parse(data, size, runs, 0, &mesh);
+    if (parse < 0.0) {
+        printf("Failed to parse OBJ\n");
+        exit(-1);
+    }
+    long lines = 0, numbers = 0, mismatches = 0;
+    double scan = time_scan(data, size, runs, &lines);
+    double strtof_time = time_strtof(data, size, runs + 1, &numbers, &mismatches);
+    double mb = size / 1e6;
+
+    printf("    {\"name\": \"%s\", \"bytes\": %zu, \"lines\": %ld, \"vertices\": %u, \"indices\": %u, \"groups\": %d,\n",
+           name, size, lines, mesh.vertex_count, mesh.index_count, mesh.group_count);
+    printf("     \"parse_ms\": %.3f, \"parse_mb_s\": %.1f, \"scan_mb_s\": %.1f, \"strtof_mb_s\": %.1f,\n",
+           parse * 1e3, mb / parse, mb / scan, mb / strtof_time);
+    printf("     \"numbers\": %ld, \"strtof_mismatches\": %ld,\n", numbers, mismatches);
+    printf("     \"threaded\": [");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        obj_mesh threaded = {0};
+        double t = time_parse(data, size, runs, threads, &threaded);
+        int identical = t > 0.0 && same_mesh(&mesh, &threaded);
+        mismatched |= !identical;
+        printf("%s{\"threads\": %d, \"parse_ms\": %.3f, \"parse_mb_s\": %.1f, \"identical\": %s}",
+               threads > 1 ? ", " : "", threads, t * 1e3, mb / t, identical ? "true" : "false");
+        obj_free(&threaded);
+    }
+    printf("]}%s\n", last ? "" : ",");
+    obj_free(&mesh);
+}
+
+void report_cache(const char *path, const char *data, size_t size, int runs, int threads)
+{
+    char cache_path[1024];
+    snprintf(cache_path, sizeof(cache_path), "%s.mesh", path);
+    remove(cache_path);
+
+    double start = now_s();
+    mesh_data cached;
+    if (!mesh_load_obj(&cached, path, threads)) {
+        printf("Failed to load OBJ through the cache\n");
+        exit(-1);
+    }
+    double cold = now_s() - start;
+    mesh_close(&cached);
+
+    double warm = 1e9;
+    for (int r = 0; r < runs; r++) {
+        mesh_close(&cached);
+        start = now_s();
+        mesh_load_obj(&cached, path, threads);
+        double t = now_s() - start;
+        warm = t < warm ? t : warm;
+    }
+
+    double hash = 1e9;
+    volatile uint64_t sink = 0;
+    for (int r = 0; r < runs; r++) {
+        start = now_s();
+        sink ^= mesh_hash(data, size);
+        double t = now_s() - start;
+        hash = t < hash ? t : hash;
+    }
+    (void)sink;
+
+    obj_mesh mesh;
+    obj_parse(&mesh, data, size);
+    int identical = mesh_optimize(&mesh);
+    // the cache's index blob goes on with the levels of detail after the full mesh, and its vertices
+    // with the material number after each obj_vertex
+    identical = identical && cached.header && cached.file.data && cached.header->vertex_count == mesh.vertex_count &&
+                cached.header->index_count >= mesh.index_count &&
+                cached.header->submesh_count == (uint32_t)mesh.group_count &&
+                !memcmp(cached.indices, mesh.indices, mesh.index_count * sizeof(unsigned int));
+    for (unsigned int v = 0; identical && v < mesh.vertex_count; v++) {
+        identical = !memcmp((const char *)cached.vertices + (size_t)v * cached.header->vertex_stride, &mesh.vertices[v],
+                            sizeof(obj_vertex));
+    }
+    mismatched |= !identical;
+    printf("  \"cache\": {\"bytes\": %llu, \"cold_ms\": %.3f, \"warm_ms\": %.3f, \"hash_mb_s\": %.1f, \"identical\": %s},\n",
+           cached.header ? (unsigned long long)cached.header->file_size : 0ull, cold * 1e3, warm * 1e3,
+           size / 1e6 / hash, identical ? "true" : "false");
+    obj_free(&mesh);
+    mesh_close(&cached);
+}
+
+// streams path through obj_stream with the smallest cache and chunks it allows, every chunk's
+// triangles compared corner by corner against reference's (an obj_parse of the same file).
+// 1 if they match, 0 if they don't, -1 if the stream failed
+int stream_matches(const char *path, size_t window_size, const obj_mesh *reference, unsigned int *chunk_count)
+{
+    obj_stream stream;
+    if (!obj_stream_open(&stream, path, window_size, 0, 0, NULL, NULL)) {
+        return -1;
+    }
+    obj_mesh chunk;
+    unsigned int done = 0;
+    int r, same = 1;
+    *chunk_count = 0;
+    while ((r = obj_stream_next(&stream, &chunk)) > 0) {
+        for (unsigned int i = 0; same && i < chunk.index_count; i++) {
+            same = done + i < reference->index_count &&
+                   !memcmp(&chunk.vertices[chunk.indices[i]], &reference->vertices[reference->indices[done + i]],
+                           sizeof(obj_vertex));
+        }
+        done += chunk.index_count;
+        (*chunk_count)++;
+    }
+    obj_stream_close(&stream);
+    return r < 0 ? -1 : same && done == reference->index_count;
+}
+
+// inputs obj_stream has to parse the way obj_parse does (1) or turn down (-1) without writing past its chunk
+typedef struct {
+    const char *name, *head, *repeat;
+    int repeat_count, expect;
+} StreamCase;
+
+static const StreamCase stream_cases[] = {
+    {"corners joined by minus signs", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3", "-1-2-3", 1, 1},
+    {"more joined corners than a chunk holds", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3", "-1-2-3", 40000, -1},
+    {"more spaced corners than a chunk holds", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3", " -1 -2 -3", 40000, -1},
+    {"no newline at the end", "v 0 0 0\r\nv 1 0 0\r\nv 0 1 0\r\nf 1 2 3", "", 0, 1},
+};
+
+#define STREAM_CASE_COUNT (sizeof(stream_cases) / sizeof(stream_cases[0]))
+
+int stream_chunks, stream_identical, stream_passed[STREAM_CASE_COUNT];
+
+// run before the JSON starts, obj.h prints why it turns a case down
+void check_stream(const char *path, const char *data, size_t size)
+{
+    obj_mesh mesh;
+    obj_parse(&mesh, data, size);
+    unsigned int chunks = 0;
+    stream_identical = stream_matches(path, 0, &mesh, &chunks) == 1;
+    stream_chunks = (int)chunks;
+    obj_free(&mesh);
+    mismatched |= !stream_identical;
+
+    char case_path[1024];
+    snprintf(case_path, sizeof(case_path), "%s.case.tmp", path);
+    for (size_t c = 0; c < STREAM_CASE_COUNT; c++) {
+        const StreamCase *sc = &stream_cases[c];
+        Buffer b = {0};
+        append(&b, sc->head, strlen(sc->head));
+        for (int k = 0; k < sc->repeat_count; k++) {
+            append(&b, sc->repeat, strlen(sc->repeat));
+        }
+        append(&b, "\n", sc->repeat_count ? 1 : 0);
+        FILE *f = fopen(case_path, "wb");
+        if (!f || fwrite(b.data, 1, b.size, f) != b.size || fclose(f) != 0) {
+            printf("Failed to write %s\n", case_path);
+            exit(-1);
+        }
+        // a window the whole face fits in, so it's the chunk that has to turn it down
+        obj_parse(&mesh, b.data, b.size);
+        stream_passed[c] = stream_matches(case_path, b.size + 1, &mesh, &chunks) == sc->expect;
+        mismatched |= !stream_passed[c];
+        obj_free(&mesh);
+        remove(case_path);
+        free(b.data);
+    }
+}
+
+void report_stream(void)
+{
+    printf("  \"stream\": {\"chunks\": %d, \"identical\": %s, \"cases\": [", stream_chunks,
+           stream_identical ? "true" : "false");
+    for (size_t c = 0; c < STREAM_CASE_COUNT; c++) {
+        printf("%s{\"name\": \"%s\", \"passed\": %s}", c ? ", " : "", stream_cases[c].name,
+               stream_passed[c] ? "true" : "false");
+    }
+    printf("]},\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "./third_party/assets/Tree.obj";
+    double megabytes = argc > 2 ? atof(argv[2]) : 100.0;
+    int runs = argc > 3 ? atoi(argv[3]) : 5;
+    int max_threads = argc > 4 ? atoi(argv[4]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (runs < 1) {
+        runs = 1;
+    }
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    // the whole load once, map included, for the number a caller sees
+    double start = now_s();
+    obj_mesh mesh;
+    if (!obj_load(&mesh, path)) {
+        return -1;
+    }
+    double load = now_s() - start;
+    obj_free(&mesh);
+
+    asset_file file;
+    if (!asset_map(&file, path)) {
+        return -1;
+    }
+    Buffer big = replicate((const char *)file.data, file.size, (size_t)(megabytes * 1e6));
+
+    check_stream(path, (const char *)file.data, file.size);
+
+    printf("{\n");
+    printf("  \"path\": \"%s\",\n", path);
+    printf("  \"runs\": %d,\n", runs);
+    printf("  \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("  \"first_load_ms\": %.3f,\n", load * 1e3);
+    report_cache(path, (const char *)file.data, file.size, runs, max_threads);
+    report_stream();
+    printf("  \"inputs\": [\n");
+    report("file", (const char *)file.data, file.size, runs, max_threads, big.size == 0);
+    if (big.size) {
+        report("replicated", big.data, big.size, runs, max_threads, 1);
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    free(big.data);
+    asset_unmap(&file);
+    return mismatched;
+}
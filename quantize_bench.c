@@ -0,0 +1,237 @@
+// Quantized vertex benchmark.
+//
+// Bakes every mesh twice, float vertices (mesh_load_obj) and MESH_QUANTIZE
+// ones (mesh_load_obj_flags), prints the vertex buffer and cache file sizes,
+// what quantizing saved and the largest position (model units and share of
+// the bounds' diagonal), normal (degrees) and uv error. Then draws a grid of
+// instanced copies of each, headless, with the same MESH_GLSL_DECODE shader,
+// and prints frame times and how many pixels came out different, as JSON.
+// LIBGL_ALWAYS_SOFTWARE=1 pins it to llvmpipe.
+//
+// usage: ./quantize_bench [copies per side] [frames] [path ...]     default 48 10 Tree.obj
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "glad.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDMADE_MATH_IMPLEMENTATION
+#include "handmade_math.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define OBJ_IMPLEMENTATION
+#include "obj.h"
+
+#define MESH_OPT_IMPLEMENTATION
+#include "mesh_opt.h"
+
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+#define HEADLESS_IMPLEMENTATION
+#include "headless.h"
+
+#define WIDTH 1280
+#define HEIGHT 720
+
+const char *vs = "#version 450 core\n"
+    MESH_GLSL_DECODE
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec3 aNormal;\n"
+    "layout (location = 3) in uint aMaterial;\n"
+    "// per instance hmm_mat3x4, the rows of the model matrix without (0, 0, 0, 1)\n"
+    "layout (location = 4) in vec4 aModel0;\n"
+    "layout (location = 5) in vec4 aModel1;\n"
+    "layout (location = 6) in vec4 aModel2;\n"
+    "\n"
+    "out vec3 Normal;\n"
+    "flat out uint MaterialIndex;\n"
+    "\n"
+    "uniform mat4 projection_view;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    mat4 model = transpose(mat4(aModel0, aModel1, aModel2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));\n"
+    "    gl_Position = projection_view*model*vec4(mesh_position(aPos), 1.0f);\n"
+    "    Normal = mat3(model)*mesh_normal(aNormal);\n"
+    "    MaterialIndex = aMaterial;\n"
+    "}";
+
+const char *fs = "#version 450 core\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "in vec3 Normal;\n"
+    "flat in uint MaterialIndex;\n"
+    "\n"
+    "struct Material { vec4 diffuse; vec4 specular; vec4 emissive; ivec4 maps; };\n"
+    "layout (std430, binding = 0) readonly buffer Materials { Material materials[]; };\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    float light = max(dot(normalize(Normal), normalize(vec3(0.4f, 1.0f, 0.3f))), 0.0f);\n"
+    "    FragColor = vec4(materials[MaterialIndex].diffuse.rgb*(0.2f + 0.8f*light), 1.0f);\n"
+    "}";
+
+// draws side x side copies of m frames times, leaves the last frame in pixels, returns the median frame ms
+double draw_grid(const mesh_data *m, GLuint program, int side, int frames, unsigned char *pixels)
+{
+    const mesh_header *h = m->header;
+    GLuint vbo, ibo;
+    GLuint vao = mesh_upload(m, &vbo, &ibo);
+    GLuint materials = mesh_upload_materials(m);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, materials);
+    mesh_decode_uniforms(m, program);
+
+    // same placement for both, from the bounds, which quantizing keeps
+    hmm_vec3 center = HMM_Vec3((h->min[0] + h->max[0]) * 0.5f, (h->min[1] + h->max[1]) * 0.5f,
+                               (h->min[2] + h->max[2]) * 0.5f);
+    float radius = HMM_LengthVec3(HMM_SubtractVec3(HMM_Vec3(h->max[0], h->max[1], h->max[2]), center));
+    float spacing = 2.0f * radius, extent = side * spacing;
+    int copies = side * side;
+    hmm_mat3x4 *models = malloc(copies * sizeof(hmm_mat3x4));
+    for (int i = 0; i < copies; i++) {
+        hmm_vec3 position = HMM_Vec3((i % side) * spacing - center.X, -center.Y, (i / side) * spacing - center.Z);
+        models[i] = HMM_Mat3x4FromMat4(HMM_MultiplyMat4(HMM_Translate(position),
+                                                        HMM_Rotate((float)(i * 37 % 360), HMM_Vec3(0.0f, 1.0f, 0.0f))));
+    }
+    GLuint instances;
+    glBindVertexArray(vao);
+    glGenBuffers(1, &instances);
+    glBindBuffer(GL_ARRAY_BUFFER, instances);
+    glBufferData(GL_ARRAY_BUFFER, copies * sizeof(hmm_mat3x4), models, GL_STATIC_DRAW);
+    for (int row = 0; row < 3; row++) {
+        glEnableVertexAttribArray(4 + row);
+        glVertexAttribPointer(4 + row, 4, GL_FLOAT, GL_FALSE, sizeof(hmm_mat3x4), (void *)(row * 4 * sizeof(float)));
+        glVertexAttribDivisor(4 + row, 1);
+    }
+
+    hmm_vec3 camera = HMM_Vec3(-spacing, 0.4f * extent, -spacing);
+    hmm_mat4 projection = HMM_Perspective(45.0f, (float)WIDTH / HEIGHT, 0.1f * radius, 4.0f * extent);
+    hmm_mat4 view = HMM_LookAt(camera, HMM_Vec3(0.5f * extent, 0.0f, 0.5f * extent), HMM_Vec3(0.0f, 1.0f, 0.0f));
+    hmm_mat4 projection_view = HMM_MultiplyMat4(projection, view);
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection_view"), 1, GL_FALSE, &projection_view.Elements[0][0]);
+
+    uint32_t count = 0;
+    for (uint32_t s = 0; s < h->submesh_count; s++) {
+        count += m->lods[s].index_count;
+    }
+    double *frame_ms = malloc(frames * sizeof(double));
+    // one frame first to warm up the driver
+    for (int f = -1; f < frames; f++) {
+        double start = headless_now_ms();
+        glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void *)0, copies);
+        glFinish();
+        if (f >= 0) {
+            frame_ms[f] = headless_now_ms() - start;
+        }
+    }
+    glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    qsort(frame_ms, frames, sizeof(double), headless_compare_double);
+    double median = frame_ms[frames / 2];
+
+    free(frame_ms);
+    free(models);
+    glDeleteBuffers(1, &instances);
+    glDeleteBuffers(1, &materials);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+    glDeleteVertexArrays(1, &vao);
+    return median;
+}
+
+int main(int argc, char **argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 48;
+    int frames = argc > 2 ? atoi(argv[2]) : 10;
+    const char *default_path = "./third_party/assets/Tree.obj";
+    const char **paths = argc > 3 ? (const char **)argv + 3 : &default_path;
+    int path_count = argc > 3 ? argc - 3 : 1;
+    if (side < 1) {
+        side = 1;
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    if (!headless_context_create()) {
+        return -1;
+    }
+
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    GLuint program = headless_program(1, &vs, &fs);
+
+    unsigned char *pixels[2] = {malloc(WIDTH * HEIGHT * 4), malloc(WIDTH * HEIGHT * 4)};
+    printf("{\n");
+    printf("  \"copies\": %d, \"frames\": %d, \"width\": %d, \"height\": %d,\n", side * side, frames, WIDTH, HEIGHT);
+    printf("  \"meshes\": [\n");
+    for (int p = 0; p < path_count; p++) {
+        mesh_data meshes[2];
+        if (!mesh_load_obj(&meshes[0], paths[p], 0)) {
+            return -1;
+        }
+        if (!mesh_load_obj_flags(&meshes[1], paths[p], 0, MESH_QUANTIZE)) {
+            return -1;
+        }
+        double frame_ms[2];
+        for (int q = 0; q < 2; q++) {
+            frame_ms[q] = draw_grid(&meshes[q], program, side, frames, pixels[q]);
+        }
+        int changed = 0;
+        for (int i = 0; i < WIDTH * HEIGHT * 4; i += 4) {
+            int differs = 0;
+            for (int c = 0; c < 3; c++) {
+                differs |= abs(pixels[0][i + c] - pixels[1][i + c]) > 2;
+            }
+            changed += differs;
+        }
+
+        const mesh_header *f = meshes[0].header, *q = meshes[1].header;
+        unsigned long long float_vertex_bytes = (unsigned long long)f->vertex_count * f->vertex_stride;
+        unsigned long long quantized_vertex_bytes = (unsigned long long)q->vertex_count * q->vertex_stride;
+        float diagonal = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            diagonal += (f->max[k] - f->min[k]) * (f->max[k] - f->min[k]);
+        }
+        diagonal = sqrtf(diagonal);
+        printf("    {\"name\": \"%s\", \"vertices\": %u, \"vertex_stride\": [%u, %u], \"vertex_bytes\": [%llu, %llu], \"file_bytes\": [%llu, %llu],\n",
+               paths[p], q->vertex_count, f->vertex_stride, q->vertex_stride, float_vertex_bytes, quantized_vertex_bytes,
+               (unsigned long long)f->file_size, (unsigned long long)q->file_size);
+        printf("     \"vertex_bytes_saved\": %llu, \"file_bytes_saved\": %llu, \"file_saved_share\": %.3f,\n",
+               float_vertex_bytes - quantized_vertex_bytes, (unsigned long long)(f->file_size - q->file_size),
+               1.0 - (double)q->file_size / f->file_size);
+        printf("     \"max_position_error\": %.7f, \"max_position_error_of_diagonal\": %.2e, \"max_normal_error_degrees\": %.4f, \"max_uv_error\": %.7f,\n",
+               q->position_error, q->position_error / diagonal, q->normal_error, q->uv_error);
+        printf("     \"frame_ms_median\": [%.2f, %.2f], \"pixels_changed\": %.5f}%s\n", frame_ms[0], frame_ms[1],
+               (double)changed / (WIDTH * HEIGHT), p + 1 < path_count ? "," : "");
+        mesh_close(&meshes[0]);
+        mesh_close(&meshes[1]);
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    free(pixels[0]);
+    free(pixels[1]);
+    headless_context_destroy();
+    return 0;
+}
@@ -12,6 +12,15 @@
 #define HANDMADE_MATH_IMPLEMENTATION
 #include "handmade_math.h"
 
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define TEXTURE_IMPLEMENTATION
+#include "texture.h"
+
+#define ATLAS_IMPLEMENTATION
+#include "atlas.h"
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void process_input(GLFWwindow *window);
 void draw_text(float xpos, float ypos, float width, float height, char *text);
@@ -21,6 +30,8 @@ int screen_height = 1080;
 unsigned int shaderProgram;
 unsigned int VBO, VAO, EBO;
 unsigned int font_texture_atlas;
+atlas sprite_atlas;
+atlas_sprite glyphs[128]; // resolved once from font_idx at startup
 
 typedef struct {
     int x;
@@ -265,30 +276,42 @@ int main(void)
     
     
 
-    glGenTextures(1, &font_texture_atlas);
-    glBindTexture(GL_TEXTURE_2D, font_texture_atlas); 
+    // sprite sheets are packed offline by atlas_packer, look up every glyph once
+    if (!atlas_load(&sprite_atlas, "./third_party/atlas/atlas.txt"))
+    {
+        return -1;
+    }
+    int font_page = -1;
+    for (size_t c = 0; c < sizeof(font_idx) / sizeof(font_idx[0]); c++) {
+        char name[ATLAS_NAME_LEN];
+        snprintf(name, sizeof(name), "minogram_6x10/%d_%d", font_idx[c].x, font_idx[c].y);
+        const atlas_sprite *glyph = atlas_find(&sprite_atlas, name);
+        if (glyph) {
+            glyphs[c] = *glyph;
+            font_page = glyph->page;
+        }
+    }
+    if (font_page < 0)
+    {
+        printf("Font glyphs missing from atlas\n");
+        return -1;
+    }
+
+    // load image, create texture and generate mipmaps
+    // glyph coverage only needs one channel, the mask swizzle hands the shader (1, 1, 1, a)
+    /* stbi_set_flip_vertically_on_load(1); // tell stb_image.h to flip loaded texture's on the y-axis. */
+    font_texture_atlas = texture_load(sprite_atlas.pages[font_page].path,
+            sprite_atlas.pages[font_page].mask ? TEXTURE_USAGE_MASK : TEXTURE_USAGE_COLOR, 1, NULL);
+    if (!font_texture_atlas)
+    {
+        return -1;
+    }
      // set the texture wrapping parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);	// set texture wrapping to GL_REPEAT (default wrapping method)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     // set texture filtering parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    // load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    /* stbi_set_flip_vertically_on_load(1); // tell stb_image.h to flip loaded texture's on the y-axis. */
-    unsigned char *data = stbi_load("./third_party/fonts/minogram_6x10.png", &width, &height, &nrChannels, 4);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        printf("Failed to load texture\n");
-        return -1;
-    }
-    stbi_write_png("out.png", width, height, 1, data, 3);
-    stbi_image_free(data);
     
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "font_texture_atlas"), 0);
@@ -349,21 +372,19 @@ void draw_text(float xpos, float ypos, float width, float height, char *text) {
     glBindVertexArray(VAO);
 
     for (size_t i = 0; i < strlen(text); i++) {
-        float x = font_idx[(int)text[i]].x; 
-        float y = font_idx[(int)text[i]].y;
-        float sheet_width = 70.f;
-        float sheet_height = 78.f;
-        float sprite_height = 11.14285714f;
-        float sprite_width = 5.384615385f;
-
-        float brx = (x * sprite_width) / sheet_width;
-        float bry = (y * sprite_height) / sheet_height;
-        float blx = ((x+1) * sprite_width) / sheet_width;
-        float bly = (y * sprite_height) / sheet_height;
-        float trx = (x * sprite_width) / sheet_width;
-        float try = ((y+1) * sprite_height) / sheet_height;
-        float tlx = ((x+1) * sprite_width) / sheet_width;
-        float tly = ((y+1) * sprite_height) / sheet_height;
+        atlas_sprite *glyph = &glyphs[text[i] & 127];
+        if (glyph->w == 0) {
+            continue; // blank cells (space) aren't packed
+        }
+
+        float brx = glyph->u0;
+        float bry = glyph->v0;
+        float blx = glyph->u1;
+        float bly = glyph->v0;
+        float trx = glyph->u0;
+        float try = glyph->v1;
+        float tlx = glyph->u1;
+        float tly = glyph->v1;
 
         float sprite_verts[4*5] = {
              // positions                    // texture coords
@@ -0,0 +1,377 @@
+/*
+  texture.h
+
+  Picks the smallest sized internal format that can hold a decoded image
+  and allocates it with immutable storage (glTexStorage2D), so the driver
+  never has to convert pixels on upload and single channel data (font
+  sheets, masks) costs one byte per texel instead of four.
+
+  Do this:
+
+     #define TEXTURE_IMPLEMENTATION
+
+  in EXACTLY one C file that includes this header, AFTER glad.h,
+  stb_image.h and asset_io.h (files are mapped, not read):
+
+     #include "glad.h"
+     #include "stb_image.h"
+     #define ASSET_IO_IMPLEMENTATION
+     #include "asset_io.h"
+     #define TEXTURE_IMPLEMENTATION
+     #include "texture.h"
+
+  Usage:
+
+     texture_desc desc;
+     GLuint tex = texture_load("./third_party/images/doge.png", TEXTURE_USAGE_COLOR, 1, &desc);
+
+  Format table (channels after decode -> internal format / upload format):
+
+     MASK   any      -> GL_R8            / GL_RED  (coverage taken from alpha when present)
+     COLOR  1        -> GL_R8            / GL_RED  (grey)
+     COLOR  2        -> GL_RG8           / GL_RG   (grey + alpha)
+     COLOR  3, 4     -> GL_RGBA8         / GL_RGBA
+     SRGB   3, 4     -> GL_SRGB8_ALPHA8  / GL_RGBA
+
+  3 channel images are decoded straight to 4 channels by stb_image since
+  drivers store RGB8 as RGBX anyway, that keeps the upload a plain copy.
+
+  The *_pbo loaders take the other road: the image is decoded at the
+  file's own channel count and written into a mapped
+  GL_PIXEL_UNPACK_BUFFER in a single (SSE2/SSSE3 when available) pass
+  that also does the RGB -> RGBA or alpha -> coverage conversion. That
+  skips stb_image's own convert allocation + copy and the driver's copy
+  out of client memory. stb_image still allocates its decode buffer, it
+  has no way to decode into caller memory.
+  Masks get a (1, 1, 1, R) swizzle and grey images (R, R, R, 1) or
+  (R, R, R, G), so shaders that sample rgba keep working unchanged.
+*/
+
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <stddef.h>
+
+typedef enum
+{
+    TEXTURE_USAGE_COLOR, // linear color / data, keeps every channel
+    TEXTURE_USAGE_SRGB,  // color that should be decoded from sRGB when sampled
+    TEXTURE_USAGE_MASK,  // single channel coverage (fonts, masks)
+} texture_usage;
+
+typedef struct
+{
+    int width;
+    int height;
+    int channels;           // channels in the pixel data handed to glTexSubImage2D
+    int levels;             // mip levels allocated by glTexStorage2D
+    texture_usage usage;
+    GLenum internal_format; // sized format, e.g. GL_R8
+    GLenum format;          // upload format, e.g. GL_RED
+} texture_desc;
+
+// channels_in_file is what stbi_info reports, mipmaps != 0 allocates a full chain
+texture_desc texture_describe(int width, int height, int channels_in_file, texture_usage usage, int mipmaps);
+// the number of components texture_create expects in pixels for desc
+int texture_decode_channels(int channels_in_file, texture_usage usage);
+// pixels has desc->channels components per texel, rows tightly packed
+GLuint texture_create(const texture_desc *desc, const void *pixels);
+// returns 0 if the file could not be decoded, desc is optional
+GLuint texture_load(const char *path, texture_usage usage, int mipmaps, texture_desc *desc);
+// same as texture_load for an image that is already in memory (e.g. an asset_file)
+GLuint texture_load_from_memory(const unsigned char *bytes, size_t size, texture_usage usage, int mipmaps, texture_desc *desc);
+// same result as texture_load / texture_load_from_memory, staged through a pixel unpack buffer
+GLuint texture_load_pbo(const char *path, texture_usage usage, int mipmaps, texture_desc *desc);
+GLuint texture_load_from_memory_pbo(const unsigned char *bytes, size_t size, texture_usage usage, int mipmaps, texture_desc *desc);
+// dst_channels must equal src_channels, or be 4 from 3, or 1 from 2 / 4 (keeps the last channel)
+void texture_convert(unsigned char *dst, int dst_channels, const unsigned char *src, int src_channels, long count);
+// bytes of level 0, handy to compare against the old GL_RGBA uploads
+long texture_level0_bytes(const texture_desc *desc);
+
+#endif // TEXTURE_H
+
+#ifdef TEXTURE_IMPLEMENTATION
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+static int
+texture_mip_count(int width, int height)
+{
+    int size = width > height ? width : height;
+    int levels = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+int
+texture_decode_channels(int channels_in_file, texture_usage usage)
+{
+    if (usage == TEXTURE_USAGE_MASK) {
+        // files without alpha use their luminance as coverage, files with
+        // alpha are decoded as-is and the alpha channel is kept
+        return (channels_in_file == 1 || channels_in_file == 3) ? 1 : channels_in_file;
+    }
+    if (usage == TEXTURE_USAGE_SRGB) {
+        return 4;
+    }
+    return channels_in_file == 3 ? 4 : channels_in_file;
+}
+
+texture_desc
+texture_describe(int width, int height, int channels_in_file, texture_usage usage, int mipmaps)
+{
+    texture_desc desc = {0};
+    desc.width = width;
+    desc.height = height;
+    desc.usage = usage;
+    desc.levels = mipmaps ? texture_mip_count(width, height) : 1;
+
+    int channels = texture_decode_channels(channels_in_file, usage);
+    if (usage == TEXTURE_USAGE_MASK) {
+        channels = 1;
+    }
+    desc.channels = channels;
+
+    switch (channels) {
+        case 1:
+            desc.internal_format = GL_R8;
+            desc.format = GL_RED;
+            break;
+        case 2:
+            desc.internal_format = GL_RG8;
+            desc.format = GL_RG;
+            break;
+        default:
+            desc.internal_format = usage == TEXTURE_USAGE_SRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+            desc.format = GL_RGBA;
+            break;
+    }
+
+    return desc;
+}
+
+long
+texture_level0_bytes(const texture_desc *desc)
+{
+    return (long)desc->width * desc->height * desc->channels;
+}
+
+// pixels is an offset when a GL_PIXEL_UNPACK_BUFFER is bound
+static void
+texture_upload(const texture_desc *desc, const void *pixels)
+{
+    // R8 / RG8 rows are not 4 byte aligned in general
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, desc->width, desc->height, desc->format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    if (desc->levels > 1) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+GLuint
+texture_create(const texture_desc *desc, const void *pixels)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, desc->levels, desc->internal_format, desc->width, desc->height);
+
+    if (desc->usage == TEXTURE_USAGE_MASK) {
+        GLint swizzle[4] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    } else if (desc->channels == 1) {
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    } else if (desc->channels == 2) {
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    if (pixels) {
+        texture_upload(desc, pixels);
+    }
+
+    return texture;
+}
+
+GLuint
+texture_load_from_memory(const unsigned char *bytes, size_t size, texture_usage usage, int mipmaps, texture_desc *desc)
+{
+    int width, height, channels_in_file;
+    if (!stbi_info_from_memory(bytes, (int)size, &width, &height, &channels_in_file)) {
+        return 0;
+    }
+
+    int req = texture_decode_channels(channels_in_file, usage);
+    unsigned char *data = stbi_load_from_memory(bytes, (int)size, &width, &height, &channels_in_file, req);
+    if (!data) {
+        return 0;
+    }
+
+    texture_desc d = texture_describe(width, height, channels_in_file, usage, mipmaps);
+    if (req > 1 && d.channels == 1) {
+        // keep alpha as coverage, compacted in place (writes never pass reads)
+        texture_convert(data, 1, data, req, (long)width * height);
+    }
+
+    GLuint texture = texture_create(&d, data);
+    stbi_image_free(data);
+
+    if (desc) {
+        *desc = d;
+    }
+    return texture;
+}
+
+GLuint
+texture_load(const char *path, texture_usage usage, int mipmaps, texture_desc *desc)
+{
+    asset_file file;
+    if (!asset_map(&file, path)) {
+        return 0;
+    }
+
+    GLuint texture = texture_load_from_memory(file.data, file.size, usage, mipmaps, desc);
+    if (!texture) {
+        printf("Failed to load texture: %s\n", path);
+    }
+
+    asset_unmap(&file);
+    return texture;
+}
+
+void
+texture_convert(unsigned char *dst, int dst_channels, const unsigned char *src, int src_channels, long count)
+{
+    long i = 0;
+
+    if (dst_channels == src_channels) {
+        memcpy(dst, src, count * src_channels);
+        return;
+    }
+
+    if (src_channels == 3 && dst_channels == 4) {
+#ifdef __SSSE3__
+        // 16 source bytes hold 5 and a bit pixels, take 4 at a time
+        const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+        for (; i + 6 <= count; i += 4) {
+            __m128i rgb = _mm_loadu_si128((const __m128i *)(src + i*3));
+            __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, expand), alpha);
+            _mm_storeu_si128((__m128i *)(dst + i*4), rgba);
+        }
+#endif
+        for (; i < count; i++) {
+            dst[i*4 + 0] = src[i*3 + 0];
+            dst[i*4 + 1] = src[i*3 + 1];
+            dst[i*4 + 2] = src[i*3 + 2];
+            dst[i*4 + 3] = 255;
+        }
+        return;
+    }
+
+    // coverage from the last channel
+#ifdef __SSE2__
+    if (src_channels == 4) {
+        for (; i + 16 <= count; i += 16) {
+            const __m128i *p = (const __m128i *)(src + i*4);
+            __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(p + 0), 24);
+            __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+            __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+            __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+            __m128i lo = _mm_packs_epi32(a0, a1);
+            __m128i hi = _mm_packs_epi32(a2, a3);
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+        }
+    } else if (src_channels == 2) {
+        for (; i + 16 <= count; i += 16) {
+            const __m128i *p = (const __m128i *)(src + i*2);
+            __m128i a0 = _mm_srli_epi16(_mm_loadu_si128(p + 0), 8);
+            __m128i a1 = _mm_srli_epi16(_mm_loadu_si128(p + 1), 8);
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a0, a1));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = src[i*src_channels + src_channels - 1];
+    }
+}
+
+GLuint
+texture_load_from_memory_pbo(const unsigned char *bytes, size_t size, texture_usage usage, int mipmaps, texture_desc *desc)
+{
+    int width, height, channels_in_file;
+    if (!stbi_info_from_memory(bytes, (int)size, &width, &height, &channels_in_file)) {
+        return 0;
+    }
+
+    texture_desc d = texture_describe(width, height, channels_in_file, usage, mipmaps);
+
+    // decode at the file's channel count whenever texture_convert can take it from there
+    int req = channels_in_file;
+    if (!(req == d.channels || (req == 3 && d.channels == 4) || (d.channels == 1 && (req == 2 || req == 4)))) {
+        req = texture_decode_channels(channels_in_file, usage);
+    }
+
+    unsigned char *data = stbi_load_from_memory(bytes, (int)size, &width, &height, &channels_in_file, req);
+    if (!data) {
+        return 0;
+    }
+
+    GLsizeiptr staging_size = texture_level0_bytes(&d);
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, staging_size, NULL, GL_STREAM_DRAW);
+    unsigned char *staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, staging_size,
+                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    GLuint texture = 0;
+    if (staging) {
+        texture_convert(staging, d.channels, data, req, (long)width * height);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        texture = texture_create(&d, NULL);
+        texture_upload(&d, (const void *)0);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);
+    stbi_image_free(data);
+
+    if (texture && desc) {
+        *desc = d;
+    }
+    return texture;
+}
+
+GLuint
+texture_load_pbo(const char *path, texture_usage usage, int mipmaps, texture_desc *desc)
+{
+    asset_file file;
+    if (!asset_map(&file, path)) {
+        return 0;
+    }
+
+    GLuint texture = texture_load_from_memory_pbo(file.data, file.size, usage, mipmaps, desc);
+    if (!texture) {
+        printf("Failed to load texture: %s\n", path);
+    }
+
+    asset_unmap(&file);
+    return texture;
+}
+
+#endif // TEXTURE_IMPLEMENTATION
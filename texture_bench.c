@@ -0,0 +1,246 @@
+// Texture load benchmark.
+//
+// Loads every image in third_party/images and third_party/fonts N times and
+// times each stage of the load separately, then prints percentiles as
+// JSON so runs can be diffed over time. Runs headless (EGL surfaceless),
+// LIBGL_ALWAYS_SOFTWARE=1 pins it to llvmpipe.
+//
+// usage: ./texture_bench [iterations] [stb|pbo]
+//
+//   stb  decode straight to the upload channel count, upload from client memory
+//        (what texture_load does)
+//   pbo  decode at the file's channel count, convert into a mapped unpack
+//        buffer, upload from the buffer (what texture_load_pbo does)
+//
+// stages (microseconds):
+//   read    map the file and touch every page
+//   decode  stbi_load_from_memory
+//   convert channel conversion (alpha -> coverage, RGB -> RGBA), incl. PBO map for pbo
+//   upload  glTexStorage2D + glTexSubImage2D, glFinish'd
+//   mips    glGenerateMipmap, glFinish'd
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "glad.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#define ASSET_IO_IMPLEMENTATION
+#include "asset_io.h"
+
+#define TEXTURE_IMPLEMENTATION
+#include "texture.h"
+
+#define HEADLESS_IMPLEMENTATION
+#include "headless.h"
+
+#define MAX_IMAGES 64
+
+enum { STAGE_READ, STAGE_DECODE, STAGE_CONVERT, STAGE_UPLOAD, STAGE_MIPS, STAGE_COUNT };
+const char *stage_names[STAGE_COUNT] = {"read", "decode", "convert", "upload", "mips"};
+
+typedef struct {
+    char path[512];
+    texture_usage usage;
+    int width, height, channels;
+    double *samples[STAGE_COUNT];
+} Image;
+
+Image images[MAX_IMAGES];
+int image_count = 0;
+
+double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+void find_images(const char *dir, texture_usage usage)
+{
+    DIR *d = opendir(dir);
+    if (!d) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) && image_count < MAX_IMAGES) {
+        const char *ext = strrchr(entry->d_name, '.');
+        if (!ext || (strcmp(ext, ".png") && strcmp(ext, ".jpg"))) {
+            continue;
+        }
+        Image *image = &images[image_count++];
+        snprintf(image->path, sizeof(image->path), "%s/%s", dir, entry->d_name);
+        image->usage = usage;
+    }
+    closedir(d);
+}
+
+int compare_path(const void *a, const void *b)
+{
+    return strcmp(((const Image *)a)->path, ((const Image *)b)->path);
+}
+
+int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+double percentile(double *sorted, int n, double q)
+{
+    return sorted[(int)(q * (n - 1) + 0.5)];
+}
+
+// returns 0 if the image can't be decoded or the staging buffer can't be mapped
+int load_once(Image *image, int pbo, double *t)
+{
+    double start = now_us();
+    asset_file file;
+    if (!asset_map(&file, image->path)) {
+        return 0;
+    }
+    // mmap is lazy, fault every page in so the read shows up here and not in decode
+    volatile unsigned char sink = 0;
+    for (size_t i = 0; i < file.size; i += 4096) {
+        sink ^= file.data[i];
+    }
+    (void)sink;
+    t[STAGE_READ] = now_us() - start;
+
+    start = now_us();
+    int width, height, n;
+    stbi_info_from_memory(file.data, (int)file.size, &width, &height, &n);
+    texture_desc desc = texture_describe(width, height, n, image->usage, 1);
+    int req = texture_decode_channels(n, image->usage);
+    if (pbo && (n == desc.channels || (n == 3 && desc.channels == 4) || (desc.channels == 1 && (n == 2 || n == 4)))) {
+        req = n;
+    }
+    unsigned char *data = stbi_load_from_memory(file.data, (int)file.size, &width, &height, &n, req);
+    t[STAGE_DECODE] = now_us() - start;
+    asset_unmap(&file);
+    if (!data) {
+        return 0;
+    }
+
+    image->width = width;
+    image->height = height;
+    image->channels = n;
+
+    long count = (long)width * height;
+    GLuint staging = 0;
+    start = now_us();
+    if (pbo) {
+        glGenBuffers(1, &staging);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, texture_level0_bytes(&desc), NULL, GL_STREAM_DRAW);
+        unsigned char *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, texture_level0_bytes(&desc),
+                                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped) {
+            // as texture_load_from_memory_pbo does, nothing to upload from
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &staging);
+            stbi_image_free(data);
+            return 0;
+        }
+        texture_convert(mapped, desc.channels, data, req, count);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else if (req != desc.channels) {
+        texture_convert(data, desc.channels, data, req, count);
+    }
+    t[STAGE_CONVERT] = now_us() - start;
+
+    start = now_us();
+    texture_desc base = desc;
+    GLuint texture = texture_create(&base, NULL);
+    base.levels = 1; // upload level 0 only, mips are timed on their own
+    texture_upload(&base, pbo ? (const void *)0 : data);
+    glFinish();
+    t[STAGE_UPLOAD] = now_us() - start;
+
+    start = now_us();
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glFinish();
+    t[STAGE_MIPS] = now_us() - start;
+
+    if (pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &staging);
+    }
+    glDeleteTextures(1, &texture);
+    stbi_image_free(data);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    int pbo = argc > 2 && strcmp(argv[2], "pbo") == 0;
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    if (!headless_context_create()) {
+        return -1;
+    }
+
+    find_images("./third_party/images", TEXTURE_USAGE_COLOR);
+    find_images("./third_party/fonts", TEXTURE_USAGE_MASK);
+    qsort(images, image_count, sizeof(Image), compare_path); // stable order to diff runs
+
+    // warm up the driver so the first image doesn't pay for shader/format setup
+    for (int i = 0; i < image_count; i++) {
+        double t[STAGE_COUNT];
+        load_once(&images[i], pbo, t);
+    }
+
+    for (int i = 0; i < image_count; i++) {
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            images[i].samples[s] = calloc(iterations, sizeof(double));
+        }
+    }
+
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < image_count; i++) {
+            double t[STAGE_COUNT] = {0};
+            if (!load_once(&images[i], pbo, t)) {
+                printf("Failed to load texture: %s\n", images[i].path);
+                return -1;
+            }
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                images[i].samples[s][it] = t[s];
+            }
+        }
+    }
+
+    printf("{\n");
+    printf("  \"mode\": \"%s\",\n", pbo ? "pbo" : "stb");
+    printf("  \"iterations\": %d,\n", iterations);
+    printf("  \"renderer\": \"%s\",\n", (const char *)glGetString(GL_RENDERER));
+    printf("  \"unit\": \"us\",\n");
+    printf("  \"images\": [\n");
+    for (int i = 0; i < image_count; i++) {
+        Image *image = &images[i];
+        printf("    {\"path\": \"%s\", \"width\": %d, \"height\": %d, \"channels\": %d, \"stages\": {",
+               image->path, image->width, image->height, image->channels);
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            double *v = image->samples[s];
+            qsort(v, iterations, sizeof(double), compare_double);
+            printf("%s\"%s\": {\"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+                   s ? ", " : "", stage_names[s], v[0], percentile(v, iterations, 0.5),
+                   percentile(v, iterations, 0.9), percentile(v, iterations, 0.99), v[iterations - 1]);
+            free(v);
+        }
+        printf("}}%s\n", i + 1 < image_count ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    headless_context_destroy();
+    return 0;
+}